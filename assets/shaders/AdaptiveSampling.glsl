@@ -0,0 +1,8 @@
+
+// Screen tiles sharing a sample budget (see AdaptiveSamplingPipeline).
+const uint SampleTileSize = 16;
+
+uint SampleTileIndex(const uvec2 pixel, const uint width)
+{
+	return (pixel.y / SampleTileSize) * ((width + SampleTileSize - 1) / SampleTileSize) + pixel.x / SampleTileSize;
+}
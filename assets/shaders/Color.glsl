@@ -0,0 +1,6 @@
+
+// Relative luminance of a linear Rec. 709 color.
+float Luminance(const vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
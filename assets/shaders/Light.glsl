@@ -0,0 +1,22 @@
+
+struct Light
+{
+	vec4 P0; // xyz + w (sphere radius, zero for triangles)
+	vec4 P1;
+	vec4 P2;
+	vec4 EmissionAndArea;
+	uint BitTrail;
+	uint Padding0;
+	uint Padding1;
+	uint Padding2;
+};
+
+const uint LightTreeLeaf = 0x80000000u;
+
+struct LightTreeNode
+{
+	vec3 BoundsMin;
+	float Power;
+	vec3 BoundsMax;
+	uint ChildOrLight; // right child index (the left child follows its parent), or light index | LightTreeLeaf
+};
@@ -0,0 +1,150 @@
+
+// Requires the Lights and LightNodes arrays to be declared, and Random.glsl to be included, before including this file.
+
+struct LightSample
+{
+	vec3 Position;
+	vec3 Normal;
+	vec3 Emission;
+	float Pdf; // area density
+};
+
+bool HasLights()
+{
+	return LightNodes[0].Power > 0;
+}
+
+// Conservative estimate of the light a tree node can send to a surface point: its power, times a bound on the receiver
+// cosine over the node bounding sphere, divided by the squared distance (clamped when the point is inside the node).
+float LightTreeImportance(const vec3 position, const vec3 normal, const LightTreeNode node)
+{
+	const vec3 center = 0.5 * (node.BoundsMin + node.BoundsMax);
+	const float radius2 = 0.25 * dot(node.BoundsMax - node.BoundsMin, node.BoundsMax - node.BoundsMin);
+	const vec3 toCenter = center - position;
+	const float distance2 = dot(toCenter, toCenter);
+
+	float cosine = 1;
+
+	if (distance2 > radius2)
+	{
+		const float distance = sqrt(distance2);
+		const float cosTheta = dot(normal, toCenter) / distance;
+		const float sinAlpha = sqrt(radius2) / distance;
+		const float cosAlpha = sqrt(1 - sinAlpha * sinAlpha);
+
+		// cos(max(theta - alpha, 0)), clamped to zero once the whole node is below the surface.
+		if (cosTheta < cosAlpha)
+		{
+			const float sinTheta = sqrt(max(1 - cosTheta * cosTheta, 0));
+			cosine = max(cosTheta * cosAlpha + sinTheta * sinAlpha, 0);
+		}
+	}
+
+	return node.Power * cosine / max(max(distance2, radius2), 1e-6);
+}
+
+// Pick a light by walking down the light tree, choosing each child proportionally to its importance for the surface point,
+// then a uniform point on it. Returns false when no light can reach the point.
+bool SampleLight(const vec3 position, const vec3 normal, inout uint seed, out LightSample s)
+{
+	uint node = 0;
+	float pmf = 1;
+
+	while ((LightNodes[node].ChildOrLight & LightTreeLeaf) == 0)
+	{
+		const uint left = node + 1;
+		const uint right = LightNodes[node].ChildOrLight;
+		const float leftImportance = LightTreeImportance(position, normal, LightNodes[left]);
+		const float rightImportance = LightTreeImportance(position, normal, LightNodes[right]);
+
+		if (leftImportance + rightImportance <= 0)
+		{
+			return false;
+		}
+
+		const float leftProbability = leftImportance / (leftImportance + rightImportance);
+
+		if (RandomFloat(seed) < leftProbability)
+		{
+			node = left;
+			pmf *= leftProbability;
+		}
+		else
+		{
+			node = right;
+			pmf *= 1 - leftProbability;
+		}
+	}
+
+	const Light light = Lights[LightNodes[node].ChildOrLight & ~LightTreeLeaf];
+	const float radius = light.P0.w;
+
+	if (radius > 0)
+	{
+		// Uniform sphere sampling, points on the far side are occluded by the sphere itself.
+		s.Normal = RandomUnitVector(seed);
+		s.Position = light.P0.xyz + radius * s.Normal;
+	}
+	else
+	{
+		// Uniform triangle sampling.
+		const float su = sqrt(RandomFloat(seed));
+		const float u = 1 - su;
+		const float v = RandomFloat(seed) * su;
+
+		const vec3 p0 = light.P0.xyz;
+		const vec3 p1 = light.P1.xyz;
+		const vec3 p2 = light.P2.xyz;
+
+		s.Position = p0 * u + p1 * v + p2 * (1 - u - v);
+		s.Normal = normalize(cross(p1 - p0, p2 - p0));
+	}
+
+	s.Emission = light.EmissionAndArea.rgb;
+	s.Pdf = pmf / light.EmissionAndArea.w;
+
+	return true;
+}
+
+// Area density of SampleLight() picking a point on the given light, by walking down the tree along the light bit trail.
+float LightAreaPdf(const vec3 position, const vec3 normal, const uint lightIndex)
+{
+	const Light light = Lights[lightIndex];
+
+	uint node = 0;
+	float pmf = 1;
+
+	for (uint depth = 0; (LightNodes[node].ChildOrLight & LightTreeLeaf) == 0; ++depth)
+	{
+		const uint left = node + 1;
+		const uint right = LightNodes[node].ChildOrLight;
+		const float leftImportance = LightTreeImportance(position, normal, LightNodes[left]);
+		const float rightImportance = LightTreeImportance(position, normal, LightNodes[right]);
+
+		if (leftImportance + rightImportance <= 0)
+		{
+			return 0;
+		}
+
+		const bool isRight = ((light.BitTrail >> depth) & 1) != 0;
+
+		pmf *= (isRight ? rightImportance : leftImportance) / (leftImportance + rightImportance);
+		node = isRight ? right : left;
+	}
+
+	return pmf / light.EmissionAndArea.w;
+}
+
+// Convert an area density into a solid angle density.
+float LightPdf(const float areaPdf, const float distance, const float cosine)
+{
+	return areaPdf * distance * distance / max(cosine, 1e-6);
+}
+
+// Power heuristic (beta = 2) from Veach's thesis.
+float PowerHeuristic(const float pdf, const float otherPdf)
+{
+	const float a = pdf * pdf;
+	const float b = otherPdf * otherPdf;
+	return a / (a + b);
+}
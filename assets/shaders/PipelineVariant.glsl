@@ -0,0 +1,19 @@
+
+// Feature switches baked into the ray tracing shaders as specialization constants, so that the disabled features
+// cost nothing. Each combination is a separate pipeline variant (see RayTracingPipeline::SetVariant and PipelineVariant.hpp).
+// Constant id 0 is the hit group material model (see Scatter.glsl).
+layout(constant_id = 1) const uint NumberOfBounces = 16;
+layout(constant_id = 2) const bool HasSky = true;
+layout(constant_id = 3) const bool ShowHeatmap = false;
+layout(constant_id = 4) const bool NextEventEstimation = true;
+layout(constant_id = 5) const bool RussianRoulette = true;
+layout(constant_id = 6) const bool HybridPrimary = false; // only used by RayTracing.rgen
+layout(constant_id = 7) const bool BatchViews = false; // only used by RayTracing.rgen
+layout(constant_id = 8) const uint AovMask = 0; // only used by RayTracing.rgen
+
+// First hit AOVs selected by AovMask (see PipelineVariant::AovBits).
+const uint AovDepth = 1;
+const uint AovNormal = 2;
+const uint AovAlbedo = 4;
+const uint AovInstanceId = 8;
+const uint AovMaterialId = 16;
@@ -0,0 +1,28 @@
+
+// Requires the Camera uniform buffer and the SampleBudgets array to be declared, and AdaptiveSampling.glsl to be included,
+// before including this file.
+
+// While the camera moves, only one pixel in InterleaveRate is traced per frame, the phase rotates the subset between frames.
+// The 2x2 pattern visits the pixels in the order (0, 0), (1, 1), (1, 0), (0, 1), so that consecutive frames are spread evenly.
+bool IsTracedPixel(const uvec2 pixel)
+{
+	const uint phase = Camera.InterleavePhase;
+
+	switch (Camera.InterleaveRate)
+	{
+	case 2: return ((pixel.x + pixel.y + phase) & 1) == 0;
+	case 4: return ((pixel.x & 1) | ((pixel.y & 1) << 1)) == ((0x9Cu >> ((phase & 3) * 2)) & 3);
+	default: return true;
+	}
+}
+
+// With adaptive sampling, converged tiles get fewer (or no) samples. The tile budgets are out of date when the view has just
+// moved. The pixels skipped by the interleaving get no sample, they keep their reprojected history, or are filled in from
+// their neighbours if they have none (see Reconstruction.comp).
+uint NumberOfPixelSamples(const uvec2 pixel, const uint width, const bool accumulate)
+{
+	return !IsTracedPixel(pixel) ? 0
+		: accumulate && Camera.AdaptiveSampling && !Camera.Reproject
+		? min(SampleBudgets[SampleTileIndex(pixel, width)], Camera.NumberOfSamples)
+		: Camera.NumberOfSamples;
+}
@@ -1,5 +1,26 @@
 #extension GL_EXT_control_flow_attributes : require
 
+// Requires the Camera uniform buffer to be declared before including this file, as it selects the sampler.
+
+const float Pi = 3.1415926535897932384626433832795;
+
+// Samplers (see UserSettings::Sampler).
+// - LCG: the seed is the full 32-bit generator state.
+// - Sobol and lattice: the seed packs the sample index and the current dimension. The per-pixel scrambling is derived
+//   from the pixel, so every ray tracing stage can draw the next dimension of the same sample.
+// The compute shaders, which have no launch ID, define RANDOM_PIXEL as the pixel of the path they are processing. In
+// split-frame mode, the ray tracing launch only covers a band of rows of the frame, starting at Camera.FirstRow.
+#ifndef RANDOM_PIXEL
+#define RANDOM_PIXEL (gl_LaunchIDEXT.xy + uvec2(0, Camera.FirstRow))
+#endif
+
+const uint SamplerLcg = 0;
+const uint SamplerSobol = 1;
+const uint SamplerLattice = 2;
+
+const uint SamplerDimensionBits = 10;
+const uint SamplerDimensionMask = (1u << SamplerDimensionBits) - 1;
+
 // Generates a seed for a random number generator from 2 inputs plus a backoff
 // https://github.com/nvpro-samples/optix_prime_baking/blob/332a886f1ac46c0b3eea9e89a59593470c755a0e/random.h
 // https://github.com/nvpro-samples/vk_raytracing_tutorial_KHR/tree/master/ray_tracing_jitter_cam
@@ -19,43 +40,161 @@ uint InitRandomSeed(uint val0, uint val1)
 	return v0;
 }
 
+// Seed for the given sample index. The LCG state simply carries on from one sample to the next.
+uint InitSampleSeed(const uint seed, const uint sampleIndex)
+{
+	return Camera.Sampler == SamplerLcg ? seed : sampleIndex << SamplerDimensionBits;
+}
+
 uint RandomInt(inout uint seed)
 {
 	// LCG values from Numerical Recipes
     return (seed = 1664525 * seed + 1013904223);
 }
 
-float RandomFloat(inout uint seed)
+// https://www.pcg-random.org/, via Jarzynski & Olano, "Hash Functions for GPU Rendering".
+uint Hash(const uint value)
 {
-	//// Float version using bitmask from Numerical Recipes
-	//const uint one = 0x3f800000;
-	//const uint msk = 0x007fffff;
-	//return uintBitsToFloat(one | (msk & (RandomInt(seed) >> 9))) - 1;
+	const uint state = value * 747796405u + 2891336453u;
+	const uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
 
-	// Faster version from NVIDIA examples; quality good enough for our use case.
-	return (float(RandomInt(seed) & 0x00FFFFFF) / float(0x01000000));
+// Owen scrambling of the bits of x, from the most significant one down (Burley, "Practical Hash-based Owen Scrambling").
+uint NestedUniformScramble(uint x, const uint seed)
+{
+	x = bitfieldReverse(x);
+	x += seed;
+	x ^= x * 0x6c50b47cu;
+	x ^= x * 0xb82f1e52u;
+	x ^= x * 0xc7afe638u;
+	x ^= x * 0x8d22f6e6u;
+	return bitfieldReverse(x);
 }
 
-vec2 RandomInUnitDisk(inout uint seed)
+// Second dimension of the Sobol sequence (the first one is the van der Corput sequence, i.e. bitfieldReverse).
+uint SobolSecondDimension(uint index)
 {
-	for (;;)
+	uint result = 0;
+
+	for (uint v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1)
 	{
-		const vec2 p = 2 * vec2(RandomFloat(seed), RandomFloat(seed)) - 1;
-		if (dot(p, p) < 1)
+		if ((index & 1) != 0)
 		{
-			return p;
+			result ^= v;
 		}
 	}
+
+	return result;
 }
 
-vec3 RandomInUnitSphere(inout uint seed)
+// Advance to the next dimension of the current sample. Past the last dimension, wrap around rather than overflow into the index.
+uint NextDimension(inout uint seed)
 {
-	for (;;)
+	const uint dimension = seed & SamplerDimensionMask;
+	seed = (seed & ~SamplerDimensionMask) | ((dimension + 1) & SamplerDimensionMask);
+	return dimension;
+}
+
+// Owen-scrambled Sobol, padded from 2D: each pair of dimensions is a (0, 2)-sequence whose sample order is shuffled
+// independently per pixel and pair, which decorrelates the pairs from each other.
+uint SobolInt(inout uint seed)
+{
+	const uint index = seed >> SamplerDimensionBits;
+	const uint dimension = NextDimension(seed);
+	const uint pixel = Hash(RANDOM_PIXEL.x + Hash(RANDOM_PIXEL.y));
+	const uint pair = dimension >> 1;
+
+	const uint shuffledIndex = NestedUniformScramble(index, Hash(pixel ^ Hash(pair)));
+	const uint sobol = (dimension & 1) == 0 ? bitfieldReverse(shuffledIndex) : SobolSecondDimension(shuffledIndex);
+
+	return NestedUniformScramble(sobol, Hash(pixel ^ Hash(dimension + 0x9e3779b9u)));
+}
+
+// Extensible Korobov rank-1 lattice in base 2 (generator (1, a, a^2, ...) mod 2^32, radical inverse of the index),
+// with a blue noise Cranley-Patterson rotation per pixel: the R2 dither mask, translated by a hashed offset per dimension.
+uint LatticeInt(inout uint seed)
+{
+	const uint index = seed >> SamplerDimensionBits;
+	const uint dimension = NextDimension(seed);
+
+	uint generator = 1;
+	uint power = 17797u;
+
+	for (uint k = dimension; k != 0; k >>= 1, power *= power)
 	{
-		const vec3 p = 2 * vec3(RandomFloat(seed), RandomFloat(seed), RandomFloat(seed)) - 1;
-		if (dot(p, p) < 1)
+		if ((k & 1) != 0)
 		{
-			return p;
+			generator *= power;
 		}
 	}
+
+	const uint shift = Hash(dimension);
+	const uvec2 pixel = RANDOM_PIXEL + uvec2(shift & 0xffff, shift >> 16);
+	const uint rotation = pixel.x * 3242174889u + pixel.y * 2447445413u;
+
+	return bitfieldReverse(index) * generator + rotation;
+}
+
+float RandomFloat(inout uint seed)
+{
+	switch (Camera.Sampler)
+	{
+	case SamplerSobol:
+		return float(SobolInt(seed) >> 8) / float(0x01000000);
+
+	case SamplerLattice:
+		return float(LatticeInt(seed) >> 8) / float(0x01000000);
+
+	default:
+		//// Float version using bitmask from Numerical Recipes
+		//const uint one = 0x3f800000;
+		//const uint msk = 0x007fffff;
+		//return uintBitsToFloat(one | (msk & (RandomInt(seed) >> 9))) - 1;
+
+		// Faster version from NVIDIA examples; quality good enough for our use case.
+		return (float(RandomInt(seed) & 0x00FFFFFF) / float(0x01000000));
+	}
+}
+
+// The mappings below are closed form, so that every sample consumes a fixed number of dimensions and there is no divergent
+// rejection loop.
+
+// Concentric mapping (Shirley & Chiu, "A Low Distortion Map Between Disk and Square").
+vec2 RandomInUnitDisk(inout uint seed)
+{
+	const vec2 u = 2 * vec2(RandomFloat(seed), RandomFloat(seed)) - 1;
+
+	if (u == vec2(0))
+	{
+		return vec2(0);
+	}
+
+	const bool isX = abs(u.x) > abs(u.y);
+	const float r = isX ? u.x : u.y;
+	const float theta = isX ? (Pi / 4) * (u.y / u.x) : (Pi / 2) - (Pi / 4) * (u.x / u.y);
+
+	return r * vec2(cos(theta), sin(theta));
+}
+
+vec3 RandomUnitVector(inout uint seed)
+{
+	const float z = 1 - 2 * RandomFloat(seed);
+	const float phi = 2 * Pi * RandomFloat(seed);
+	const float r = sqrt(max(1 - z * z, 0));
+
+	return vec3(r * cos(phi), r * sin(phi), z);
+}
+
+vec3 RandomInUnitSphere(inout uint seed)
+{
+	const vec3 direction = RandomUnitVector(seed);
+	return direction * pow(RandomFloat(seed), 1.0 / 3.0);
+}
+
+// Cosine weighted direction (pdf = cos / pi) around the given unit normal, using a unit vector offset (equivalent to
+// Malley's method, without needing a tangent frame). The result is not normalised.
+vec3 RandomCosineDirection(const vec3 normal, inout uint seed)
+{
+	return normal + RandomUnitVector(seed);
 }
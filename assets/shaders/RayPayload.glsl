@@ -3,5 +3,9 @@ struct RayPayload
 {
 	vec4 ColorAndDistance; // rgb + t
 	vec4 ScatterDirection; // xyz + w (is scatter needed)
+	vec4 Normal; // xyz + w (diffuse surface to sample lights from)
+	uint LightIndex; // light list index + 1 of an emissive primitive, 0 otherwise
+	uint InstanceId; // instance of the hit, for the first hit AOVs
+	uint MaterialId; // material index of the hit, for the first hit AOVs
 	uint RandomSeed;
 };
@@ -3,6 +3,15 @@
 #include "Random.glsl"
 #include "RayPayload.glsl"
 
+// Material model of the hit group (see RayTracingPipeline). Once specialised, the hit group only keeps the code of its own
+// material model. The generic hit groups (MaterialAnyModel) switch on the material model at run time instead.
+layout(constant_id = 0) const uint HitGroupMaterialModel = 0xFFFFFFFF;
+
+uint GetMaterialModel(const Material m)
+{
+	return HitGroupMaterialModel != MaterialAnyModel ? HitGroupMaterialModel : m.MaterialModel;
+}
+
 // Polynomial approximation by Christophe Schlick
 float Schlick(const float cosine, const float refractionIndex)
 {
@@ -17,9 +26,10 @@ RayPayload ScatterLambertian(const Material m, const vec3 direction, const vec3
 	const bool isScattered = dot(direction, normal) < 0;
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
-	const vec4 scatter = vec4(normal + RandomInUnitSphere(seed), isScattered ? 1 : 0);
+	// Cosine weighted sampling (pdf = cos / pi), which exactly cancels the Lambertian BRDF (albedo / pi) times the cosine term.
+	const vec4 scatter = vec4(RandomCosineDirection(normal, seed), isScattered ? 1 : 0);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, vec4(normal, isScattered ? 1 : 0), 0, 0, 0, seed);
 }
 
 // Metallic
@@ -32,7 +42,7 @@ RayPayload ScatterMetallic(const Material m, const vec3 direction, const vec3 no
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
 	const vec4 scatter = vec4(reflected + m.Fuzziness*RandomInUnitSphere(seed), isScattered ? 1 : 0);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, vec4(normal, 0), 0, 0, 0, seed);
 }
 
 // Dielectric
@@ -49,24 +59,24 @@ RayPayload ScatterDieletric(const Material m, const vec3 direction, const vec3 n
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
 	
 	return RandomFloat(seed) < reflectProb
-		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), 1), seed)
-		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, 1), seed);
+		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), 1), vec4(normal, 0), 0, 0, 0, seed)
+		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, 1), vec4(normal, 0), 0, 0, 0, seed);
 }
 
 // Diffuse Light
-RayPayload ScatterDiffuseLight(const Material m, const float t, inout uint seed)
+RayPayload ScatterDiffuseLight(const Material m, const vec3 normal, const float t, inout uint seed)
 {
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb, t);
 	const vec4 scatter = vec4(1, 0, 0, 0);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, vec4(normal, 0), 0, 0, 0, seed);
 }
 
 RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
 {
 	const vec3 normDirection = normalize(direction);
 
-	switch (m.MaterialModel)
+	switch (GetMaterialModel(m))
 	{
 	case MaterialLambertian:
 		return ScatterLambertian(m, normDirection, normal, texCoord, t, seed);
@@ -75,7 +85,7 @@ RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, co
 	case MaterialDielectric:
 		return ScatterDieletric(m, normDirection, normal, texCoord, t, seed);
 	case MaterialDiffuseLight:
-		return ScatterDiffuseLight(m, t, seed);
+		return ScatterDiffuseLight(m, normal, t, seed);
 	}
 }
 
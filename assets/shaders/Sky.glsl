@@ -0,0 +1,15 @@
+
+// Requires PipelineVariant.glsl to be included before including this file.
+
+// Colour of the rays leaving the scene.
+vec3 SkyColor(const vec3 direction)
+{
+	if (!HasSky)
+	{
+		return vec3(0);
+	}
+
+	const float t = 0.5*(normalize(direction).y + 1);
+
+	return mix(vec3(1.0), vec3(0.5, 0.7, 1.0), t);
+}
@@ -0,0 +1,39 @@
+
+// Nearest intersection of the ray with the sphere (xyz = center, w = radius) in [tMin, tMax).
+// https://en.wikipedia.org/wiki/Quadratic_formula
+bool IntersectSphere(const vec4 sphere, const vec3 origin, const vec3 direction, const float tMin, const float tMax, out float t)
+{
+	const vec3 center = sphere.xyz;
+	const float radius = sphere.w;
+
+	const vec3 oc = origin - center;
+	const float a = dot(direction, direction);
+	const float b = dot(oc, direction);
+	const float c = dot(oc, oc) - radius * radius;
+	const float discriminant = b * b - a * c;
+
+	if (discriminant < 0)
+	{
+		return false;
+	}
+
+	const float t1 = (-b - sqrt(discriminant)) / a;
+	const float t2 = (-b + sqrt(discriminant)) / a;
+
+	t = (tMin <= t1 && t1 < tMax) ? t1 : t2;
+
+	return tMin <= t && t < tMax;
+}
+
+vec2 GetSphereTexCoord(const vec3 point)
+{
+	const float phi = atan(point.x, point.z);
+	const float theta = asin(point.y);
+	const float pi = 3.1415926535897932384626433832795;
+
+	return vec2
+	(
+		(phi + pi) / (2* pi),
+		1 - (theta + pi /2) / pi
+	);
+}
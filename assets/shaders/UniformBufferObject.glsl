@@ -5,13 +5,26 @@ struct UniformBufferObject
 	mat4 Projection;
 	mat4 ModelViewInverse;
 	mat4 ProjectionInverse;
+	mat4 PreviousModelView;
 	float Aperture;
 	float FocusDistance;
 	float HeatmapScale;
 	uint TotalNumberOfSamples;
 	uint NumberOfSamples;
-	uint NumberOfBounces;
 	uint RandomSeed;
-	bool HasSky;
-	bool ShowHeatmap;
+	uint Sampler;
+	bool AdaptiveSampling;
+	bool UpdateSampleBudgets;
+	float ErrorTarget;
+	uint RussianRouletteDepth;
+	bool Reproject;
+	uint MaxHistoryLength;
+	uint RenderWidth;
+	uint RenderHeight;
+	uint InterleaveRate;
+	uint InterleavePhase;
+	float PrimaryJitterX;
+	float PrimaryJitterY;
+	uint FirstRow;
+	uint SampleOffset;
 };
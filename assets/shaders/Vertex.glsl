@@ -1,4 +1,6 @@
 
+// Requires the Vertices array to be declared before including this file, and the Indices and Offsets arrays for GetTriangleHit().
+
 struct Vertex
 {
   vec3 Position;
@@ -21,3 +23,30 @@ Vertex UnpackVertex(uint index)
 
 	return v;
 }
+
+vec2 Mix(vec2 a, vec2 b, vec2 c, vec3 barycentrics)
+{
+	return a * barycentrics.x + b * barycentrics.y + c * barycentrics.z;
+}
+
+vec3 Mix(vec3 a, vec3 b, vec3 c, vec3 barycentrics) 
+{
+    return a * barycentrics.x + b * barycentrics.y + c * barycentrics.z;
+}
+
+// Interpolate the normal and texture coordinates at the hit point of a triangle, and return its material index.
+int GetTriangleHit(const uint instance, const uint primitive, const vec2 hitAttributes, out vec3 normal, out vec2 texCoord)
+{
+	const uvec4 offsets = Offsets[instance];
+	const uint indexOffset = offsets.x;
+	const uint vertexOffset = offsets.y;
+	const Vertex v0 = UnpackVertex(vertexOffset + Indices[indexOffset + primitive * 3 + 0]);
+	const Vertex v1 = UnpackVertex(vertexOffset + Indices[indexOffset + primitive * 3 + 1]);
+	const Vertex v2 = UnpackVertex(vertexOffset + Indices[indexOffset + primitive * 3 + 2]);
+
+	const vec3 barycentrics = vec3(1.0 - hitAttributes.x - hitAttributes.y, hitAttributes.x, hitAttributes.y);
+	normal = normalize(Mix(v0.Normal, v1.Normal, v2.Normal, barycentrics));
+	texCoord = Mix(v0.TexCoord, v1.TexCoord, v2.TexCoord, barycentrics);
+
+	return v0.MaterialIndex;
+}
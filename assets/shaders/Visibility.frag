@@ -0,0 +1,11 @@
+#version 460
+
+layout(location = 0) in flat uint FragModelIndex;
+
+layout(location = 0) out uvec2 OutVisibility;
+
+void main() 
+{
+	// Zero is left for the background. The primitive index restarts with each draw, as does the one of the BLAS geometry.
+	OutVisibility = uvec2(FragModelIndex + 1, gl_PrimitiveID);
+}
@@ -0,0 +1,31 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#include "UniformBufferObject.glsl"
+
+layout(binding = 0) readonly uniform UniformBufferObjectStruct { UniformBufferObject Camera; };
+
+layout(location = 0) in vec3 InPosition;
+layout(location = 4) in vec4 InTranslationAndScale;
+layout(location = 6) in uint InModelIndex;
+
+layout(location = 0) out flat uint FragModelIndex;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main() 
+{
+	// Triangle meshes use an identity instance, procedural spheres are instances of a unit sphere.
+	const vec3 position = InTranslationAndScale.xyz + InTranslationAndScale.w * InPosition;
+	const vec4 clipPosition = Camera.Projection * Camera.ModelView * vec4(position, 1.0);
+
+	// The pixel centres are rasterized, shift the geometry so that they sample the same jittered position as the camera
+	// rays of RayTracing.rgen (pixel + jitter).
+	const vec2 jitter = vec2(Camera.PrimaryJitterX, Camera.PrimaryJitterY);
+	const vec2 offset = (0.5 - jitter) * 2.0 / vec2(Camera.RenderWidth, Camera.RenderHeight);
+
+	gl_Position = vec4(clipPosition.xy + offset * clipPosition.w, clipPosition.zw);
+	FragModelIndex = InModelIndex;
+}
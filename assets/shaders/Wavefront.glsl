@@ -0,0 +1,170 @@
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_ray_query : require
+
+// Shared declarations of the wavefront path tracing kernels (see WavefrontPipeline). Each pixel owns a path slot. The live
+// paths are listed in the ray queue, their hits are binned by material model before being shaded, and the shadow rays are
+// traced in a separate pass. The bounce loop of RayTracing.rgen is unrolled on the host, one set of kernels per bounce.
+
+#include "AdaptiveSampling.glsl"
+#include "Color.glsl"
+#include "Light.glsl"
+#include "Material.glsl"
+#include "PipelineVariant.glsl"
+#include "UniformBufferObject.glsl"
+
+// Must match WavefrontPipeline.
+const uint WavefrontGroupSize = 64;
+const uint MaterialBinCount = 8;
+
+const uint WavefrontStageGenerate = 0;
+const uint WavefrontStageExtend = 1;
+const uint WavefrontStageShade = 2;
+const uint WavefrontStageConnect = 3;
+
+const float RayTMin = 0.001;
+const float RayTMax = 10000.0;
+
+struct WavefrontPath
+{
+	vec3 Origin;
+	float ScatterPdf; // see RayTracing.rgen
+	vec3 Direction;
+	uint RandomSeed;
+	vec3 Throughput;
+	uint PixelRandomSeed;
+	vec3 Radiance;
+	uint Segments; // rays traced by the pixel during this frame
+	vec3 ScatterNormal;
+	uint Padding0;
+	vec3 ColorSum; // sum of the path radiances of the pixel during this frame
+	float SumOfSquares;
+};
+
+struct WavefrontHit
+{
+	uint PathIndex;
+	uint InstanceIndex;
+	uint PrimitiveIndex; // ~0 for procedurals
+	uint MaterialIndex;
+	vec2 Barycentrics;
+	float T;
+	uint MaterialModel;
+};
+
+struct WavefrontShadowRay
+{
+	vec3 Origin;
+	uint PathIndex;
+	vec3 Direction;
+	float Distance;
+	vec3 Contribution; // added to the path radiance if the light is visible
+	uint Padding0;
+};
+
+layout(push_constant) uniform PushConstants
+{
+	uint Width;
+	uint Height;
+	uint Sample;
+	uint Bounce;
+	uint Stage;
+};
+
+layout(binding = 0, set = 0) uniform accelerationStructureEXT Scene;
+layout(binding = 1, rgba32f) uniform image2D AccumulationImage;
+layout(binding = 2, rgba8) writeonly uniform image2D OutputImage;
+layout(binding = 3) readonly uniform UniformBufferObjectStruct { UniformBufferObject Camera; };
+layout(binding = 4) readonly buffer VertexArray { float Vertices[]; };
+layout(binding = 5) readonly buffer IndexArray { uint Indices[]; };
+layout(binding = 6) readonly buffer MaterialArray { Material[] Materials; };
+layout(binding = 7) readonly buffer OffsetArray { uvec4[] Offsets; };
+layout(binding = 8) uniform sampler2D[] TextureSamplers;
+layout(binding = 9) readonly buffer SphereArray { vec4[] Spheres; };
+layout(binding = 10) readonly buffer LightArray { Light[] Lights; };
+layout(binding = 11) readonly buffer LightTreeArray { LightTreeNode[] LightNodes; };
+layout(binding = 12) readonly buffer LightIndexArray { uint[] LightIndices; };
+layout(binding = 13) buffer SampleBudgetArray { uint ActiveTiles; uint Paths; uint PathSegments; uint Padding1; uint SampleBudgets[]; };
+layout(binding = 14, r32f) uniform image2D VarianceImage;
+layout(binding = 15, rgba16f) writeonly uniform image2D AlbedoImage;
+layout(binding = 16, rgba16f) writeonly uniform image2D NormalDepthImage;
+layout(binding = 17) buffer PathArray { WavefrontPath[] PathStates; };
+layout(binding = 18) buffer QueueArray
+{
+	uint RayCount;
+	uint NextRayCount;
+	uint HitCount;
+	uint ShadowCount;
+	uint BinCounts[MaterialBinCount];
+	uint BinOffsets[MaterialBinCount];
+	uvec4 ExtendArgs;
+	uvec4 HitArgs;
+	uvec4 ShadowArgs;
+	uint RayQueue[]; // two halves of Width * Height entries, read and written alternately by each bounce
+};
+layout(binding = 19) buffer HitArray { WavefrontHit[] Hits; }; // unsorted, then sorted by material model
+layout(binding = 20) buffer ShadowRayArray { WavefrontShadowRay[] ShadowRays; };
+
+// Pixel of the path being processed (see Random.glsl).
+uvec2 CurrentPixel;
+#define RANDOM_PIXEL CurrentPixel
+
+#include "Scatter.glsl"
+#include "LightSampling.glsl"
+#include "PixelSampling.glsl"
+#include "Sky.glsl"
+#include "Sphere.glsl"
+#include "Vertex.glsl"
+
+uvec2 PathPixel(const uint pathIndex)
+{
+	return uvec2(pathIndex % Width, pathIndex / Width);
+}
+
+struct RayQueryHit
+{
+	float T;
+	uint InstanceIndex;
+	uint PrimitiveIndex;
+	vec2 Barycentrics;
+	bool IsProcedural;
+};
+
+// Find the closest hit (or any hit for shadow rays). There is no intersection shader, the procedural spheres are intersected here.
+bool TraceRay(const vec3 origin, const vec3 direction, const float tMax, const bool isShadowRay, out RayQueryHit hit)
+{
+	const uint flags = gl_RayFlagsOpaqueEXT | (isShadowRay ? gl_RayFlagsTerminateOnFirstHitEXT : 0u);
+
+	rayQueryEXT rayQuery;
+	rayQueryInitializeEXT(rayQuery, Scene, flags, 0xff, origin, RayTMin, direction, tMax);
+
+	while (rayQueryProceedEXT(rayQuery))
+	{
+		if (rayQueryGetIntersectionTypeEXT(rayQuery, false) == gl_RayQueryCandidateIntersectionAABBEXT)
+		{
+			const bool hasCommitted = rayQueryGetIntersectionTypeEXT(rayQuery, true) != gl_RayQueryCommittedIntersectionNoneEXT;
+			const float tCommitted = hasCommitted ? rayQueryGetIntersectionTEXT(rayQuery, true) : tMax;
+			const vec4 sphere = Spheres[rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false)];
+			float t;
+
+			if (IntersectSphere(sphere, origin, direction, RayTMin, tCommitted, t))
+			{
+				rayQueryGenerateIntersectionEXT(rayQuery, t);
+			}
+		}
+	}
+
+	const uint type = rayQueryGetIntersectionTypeEXT(rayQuery, true);
+
+	if (type == gl_RayQueryCommittedIntersectionNoneEXT)
+	{
+		return false;
+	}
+
+	hit.T = rayQueryGetIntersectionTEXT(rayQuery, true);
+	hit.InstanceIndex = rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, true);
+	hit.PrimitiveIndex = rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, true);
+	hit.IsProcedural = type == gl_RayQueryCommittedIntersectionGeneratedEXT;
+	hit.Barycentrics = hit.IsProcedural ? vec2(0) : rayQueryGetIntersectionBarycentricsEXT(rayQuery, true);
+
+	return true;
+}
@@ -0,0 +1,285 @@
+#include "GeometryKernels.hpp"
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_KERNELS_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define GEOMETRY_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace glm;
+
+namespace Assets {
+
+namespace
+{
+	// The SIMD paths load 4 floats starting at Position and Normal, reading into the next member.
+	static_assert(offsetof(Vertex, Normal) == offsetof(Vertex, Position) + 3 * sizeof(float), "unexpected vertex layout");
+	static_assert(offsetof(Vertex, TexCoord) == offsetof(Vertex, Normal) + 3 * sizeof(float), "unexpected vertex layout");
+
+	// Below this many elements per batch, the cost of spawning a thread outweighs the work.
+	constexpr size_t MinBatchSize = 64 * 1024;
+
+	size_t NumberOfBatches(const size_t count)
+	{
+		const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+		return std::max<size_t>(1, std::min(threads, (count + MinBatchSize - 1) / MinBatchSize));
+	}
+
+	// Split [0, count) into NumberOfBatches(count) contiguous ranges and call func(batch, begin, end) on each of them in parallel.
+	template <class Func>
+	void ParallelFor(const size_t count, const Func& func)
+	{
+		const size_t batches = NumberOfBatches(count);
+		const size_t batchSize = (count + batches - 1) / batches;
+
+		std::vector<std::thread> workers;
+		workers.reserve(batches - 1);
+
+		for (size_t batch = 1; batch < batches; ++batch)
+		{
+			workers.emplace_back([&func, batch, batchSize, count]()
+			{
+				func(batch, std::min(count, batch * batchSize), std::min(count, (batch + 1) * batchSize));
+			});
+		}
+
+		func(0, 0, std::min(count, batchSize));
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void TransformRange(Vertex* const vertices, const size_t begin, const size_t end, const mat4& m, const mat4& n)
+	{
+#if defined(GEOMETRY_KERNELS_SSE2)
+
+		const __m128 m0 = _mm_loadu_ps(&m[0][0]);
+		const __m128 m1 = _mm_loadu_ps(&m[1][0]);
+		const __m128 m2 = _mm_loadu_ps(&m[2][0]);
+		const __m128 m3 = _mm_loadu_ps(&m[3][0]);
+		const __m128 n0 = _mm_loadu_ps(&n[0][0]);
+		const __m128 n1 = _mm_loadu_ps(&n[1][0]);
+		const __m128 n2 = _mm_loadu_ps(&n[2][0]);
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			float* const position = &vertices[i].Position.x;
+			float* const normal = &vertices[i].Normal.x;
+
+			const __m128 p = _mm_loadu_ps(position); // px, py, pz, nx
+			const __m128 v = _mm_loadu_ps(normal); // nx, ny, nz, u
+
+			const __m128 tp = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(m0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(m1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm_add_ps(_mm_mul_ps(m2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))), m3));
+
+			const __m128 tn = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(n0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))), _mm_mul_ps(n1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)))),
+				_mm_mul_ps(n2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+
+			// Stitch (tpx, tpy, tpz, tnx) and (tnx, tny, tnz, u) so that both 4-wide stores leave the texture coordinates untouched.
+			const __m128 pw = _mm_shuffle_ps(tp, tn, _MM_SHUFFLE(0, 0, 2, 2));
+			const __m128 nw = _mm_shuffle_ps(tn, v, _MM_SHUFFLE(3, 3, 2, 2));
+
+			_mm_storeu_ps(position, _mm_shuffle_ps(tp, pw, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(normal, _mm_shuffle_ps(tn, nw, _MM_SHUFFLE(2, 0, 1, 0)));
+		}
+
+#elif defined(GEOMETRY_KERNELS_NEON)
+
+		const float32x4_t m0 = vld1q_f32(&m[0][0]);
+		const float32x4_t m1 = vld1q_f32(&m[1][0]);
+		const float32x4_t m2 = vld1q_f32(&m[2][0]);
+		const float32x4_t m3 = vld1q_f32(&m[3][0]);
+		const float32x4_t n0 = vld1q_f32(&n[0][0]);
+		const float32x4_t n1 = vld1q_f32(&n[1][0]);
+		const float32x4_t n2 = vld1q_f32(&n[2][0]);
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			float* const position = &vertices[i].Position.x;
+			float* const normal = &vertices[i].Normal.x;
+
+			const float32x4_t p = vld1q_f32(position); // px, py, pz, nx
+			const float32x4_t v = vld1q_f32(normal); // nx, ny, nz, u
+
+			const float32x4_t tp = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(m3, m0, vgetq_lane_f32(p, 0)), m1, vgetq_lane_f32(p, 1)), m2, vgetq_lane_f32(p, 2));
+			const float32x4_t tn = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(n0, vgetq_lane_f32(v, 0)), n1, vgetq_lane_f32(v, 1)), n2, vgetq_lane_f32(v, 2));
+
+			// Patch the 4th lanes so that both 4-wide stores leave the texture coordinates untouched.
+			vst1q_f32(position, vsetq_lane_f32(vgetq_lane_f32(tn, 0), tp, 3));
+			vst1q_f32(normal, vsetq_lane_f32(vgetq_lane_f32(v, 3), tn, 3));
+		}
+
+#else
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			auto& vertex = vertices[i];
+			vertex.Position = m * vec4(vertex.Position, 1);
+			vertex.Normal = n * vec4(vertex.Normal, 0);
+		}
+
+#endif
+	}
+
+	std::pair<vec3, vec3> BoundsRange(const Vertex* const vertices, const size_t begin, const size_t end)
+	{
+#if defined(GEOMETRY_KERNELS_SSE2)
+
+		__m128 min = _mm_set1_ps(std::numeric_limits<float>::max());
+		__m128 max = _mm_set1_ps(std::numeric_limits<float>::lowest());
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			const __m128 p = _mm_loadu_ps(&vertices[i].Position.x); // The 4th lane is ignored.
+			min = _mm_min_ps(min, p);
+			max = _mm_max_ps(max, p);
+		}
+
+		float lo[4], hi[4];
+		_mm_storeu_ps(lo, min);
+		_mm_storeu_ps(hi, max);
+
+		return std::make_pair(vec3(lo[0], lo[1], lo[2]), vec3(hi[0], hi[1], hi[2]));
+
+#elif defined(GEOMETRY_KERNELS_NEON)
+
+		float32x4_t min = vdupq_n_f32(std::numeric_limits<float>::max());
+		float32x4_t max = vdupq_n_f32(std::numeric_limits<float>::lowest());
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			const float32x4_t p = vld1q_f32(&vertices[i].Position.x); // The 4th lane is ignored.
+			min = vminq_f32(min, p);
+			max = vmaxq_f32(max, p);
+		}
+
+		float lo[4], hi[4];
+		vst1q_f32(lo, min);
+		vst1q_f32(hi, max);
+
+		return std::make_pair(vec3(lo[0], lo[1], lo[2]), vec3(hi[0], hi[1], hi[2]));
+
+#else
+
+		vec3 min(std::numeric_limits<float>::max());
+		vec3 max(std::numeric_limits<float>::lowest());
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			min = glm::min(min, vertices[i].Position);
+			max = glm::max(max, vertices[i].Position);
+		}
+
+		return std::make_pair(min, max);
+
+#endif
+	}
+}
+
+void GeometryKernels::Transform(std::vector<Vertex>& vertices, const mat4& transform)
+{
+	const auto transformIT = inverseTranspose(transform);
+
+	ParallelFor(vertices.size(), [&](size_t, const size_t begin, const size_t end)
+	{
+		TransformRange(vertices.data(), begin, end, transform, transformIT);
+	});
+}
+
+std::pair<vec3, vec3> GeometryKernels::ComputeBounds(const std::vector<Vertex>& vertices)
+{
+	std::vector<std::pair<vec3, vec3>> bounds(NumberOfBatches(vertices.size()));
+
+	ParallelFor(vertices.size(), [&](const size_t batch, const size_t begin, const size_t end)
+	{
+		bounds[batch] = BoundsRange(vertices.data(), begin, end);
+	});
+
+	auto result = bounds[0];
+
+	for (size_t i = 1; i != bounds.size(); ++i)
+	{
+		result.first = min(result.first, bounds[i].first);
+		result.second = max(result.second, bounds[i].second);
+	}
+
+	return result;
+}
+
+void GeometryKernels::ComputeSmoothNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	// Face normals are computed in parallel, but accumulated serially as triangles share vertices.
+	const size_t triangleCount = indices.size() / 3;
+	std::vector<vec3> faceNormals(triangleCount);
+
+	ParallelFor(triangleCount, [&](size_t, const size_t begin, const size_t end)
+	{
+		for (size_t i = begin; i != end; ++i)
+		{
+			const vec3& p0 = vertices[indices[3 * i + 0]].Position;
+			const vec3& p1 = vertices[indices[3 * i + 1]].Position;
+			const vec3& p2 = vertices[indices[3 * i + 2]].Position;
+
+			faceNormals[i] = normalize(cross(p1 - p0, p2 - p0));
+		}
+	});
+
+	for (auto& vertex : vertices)
+	{
+		vertex.Normal = vec3(0);
+	}
+
+	for (size_t i = 0; i != triangleCount; ++i)
+	{
+		vertices[indices[3 * i + 0]].Normal += faceNormals[i];
+		vertices[indices[3 * i + 1]].Normal += faceNormals[i];
+		vertices[indices[3 * i + 2]].Normal += faceNormals[i];
+	}
+
+	ParallelFor(vertices.size(), [&](size_t, const size_t begin, const size_t end)
+	{
+		for (size_t i = begin; i != end; ++i)
+		{
+			vertices[i].Normal = normalize(vertices[i].Normal);
+		}
+	});
+}
+
+bool GeometryKernels::ValidateIndices(const std::vector<uint32_t>& indices, const size_t vertexCount)
+{
+	if (indices.size() % 3 != 0)
+	{
+		return false;
+	}
+
+	std::vector<uint32_t> maxIndices(NumberOfBatches(indices.size()), 0);
+
+	ParallelFor(indices.size(), [&](const size_t batch, const size_t begin, const size_t end)
+	{
+		uint32_t maxIndex = 0;
+
+		for (size_t i = begin; i != end; ++i)
+		{
+			maxIndex = std::max(maxIndex, indices[i]);
+		}
+
+		maxIndices[batch] = maxIndex;
+	});
+
+	return indices.empty() || *std::max_element(maxIndices.begin(), maxIndices.end()) < vertexCount;
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Vertex.hpp"
+#include <utility>
+#include <vector>
+
+namespace Assets
+{
+
+	// Bulk geometry operations on vertex/index arrays. Large arrays are split across all hardware threads,
+	// and each batch uses SSE2 (x86-64) or NEON (ARM64) when available, with a scalar fallback otherwise.
+	class GeometryKernels final
+	{
+	public:
+
+		// Transform the positions by the given matrix, and the normals by its inverse transpose.
+		static void Transform(std::vector<Vertex>& vertices, const glm::mat4& transform);
+
+		// Axis aligned bounding box (min, max) of the vertex positions.
+		static std::pair<glm::vec3, glm::vec3> ComputeBounds(const std::vector<Vertex>& vertices);
+
+		// Overwrite the vertex normals with the normalised sum of the normals of the triangles sharing them.
+		static void ComputeSmoothNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+		// Check that the index count is a multiple of 3 and that every index refers to an existing vertex.
+		static bool ValidateIndices(const std::vector<uint32_t>& indices, size_t vertexCount);
+	};
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+
+namespace Assets
+{
+
+	// Emissive primitive used for explicit light sampling (next event estimation).
+	struct alignas(16) Light final
+	{
+		// Triangle vertices in world space, or sphere center (P0.xyz) and radius (P0.w, zero for triangles).
+		glm::vec4 P0;
+		glm::vec4 P1;
+		glm::vec4 P2;
+
+		// Emitted radiance (rgb) and area (w).
+		glm::vec4 EmissionAndArea;
+
+		// Path from the root of the light tree to the leaf holding this light (bit i set: right child taken at depth i).
+		uint32_t BitTrail;
+		uint32_t Padding[3];
+	};
+
+}
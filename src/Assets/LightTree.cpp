@@ -0,0 +1,130 @@
+#include "LightTree.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace glm;
+
+namespace Assets {
+
+namespace
+{
+	struct LightBounds
+	{
+		vec3 Min;
+		vec3 Max;
+		float Power;
+	};
+
+	LightBounds GetLightBounds(const Light& light)
+	{
+		const float radius = light.P0.w;
+		const vec3 emission(light.EmissionAndArea);
+		const float power = dot(emission, vec3(0.2126f, 0.7152f, 0.0722f)) * light.EmissionAndArea.w;
+
+		if (radius > 0)
+		{
+			return LightBounds{vec3(light.P0) - radius, vec3(light.P0) + radius, power};
+		}
+
+		return LightBounds{
+			min(vec3(light.P0), min(vec3(light.P1), vec3(light.P2))),
+			max(vec3(light.P0), max(vec3(light.P1), vec3(light.P2))),
+			power};
+	}
+
+	class Builder final
+	{
+	public:
+
+		Builder(std::vector<Light>& lights, std::vector<LightTreeNode>& nodes) :
+			lights_(lights),
+			nodes_(nodes),
+			order_(lights.size())
+		{
+			bounds_.reserve(lights.size());
+
+			for (const auto& light : lights)
+			{
+				bounds_.push_back(GetLightBounds(light));
+			}
+
+			std::iota(order_.begin(), order_.end(), 0u);
+		}
+
+		// Recursively build the subtree over order_[begin, end), splitting at the median centroid along the largest axis.
+		// Median splits keep the tree balanced, so its depth always fits in the 32 bits of the bit trails.
+		void BuildNode(const size_t begin, const size_t end, const uint32_t bitTrail, const uint32_t depth)
+		{
+			const size_t nodeIndex = nodes_.size();
+			nodes_.emplace_back();
+
+			LightTreeNode node{vec3(std::numeric_limits<float>::max()), 0, vec3(std::numeric_limits<float>::lowest()), 0};
+			vec3 centroidMin(std::numeric_limits<float>::max());
+			vec3 centroidMax(std::numeric_limits<float>::lowest());
+
+			for (size_t i = begin; i != end; ++i)
+			{
+				const auto& bounds = bounds_[order_[i]];
+				const vec3 centroid = 0.5f * (bounds.Min + bounds.Max);
+
+				node.BoundsMin = min(node.BoundsMin, bounds.Min);
+				node.BoundsMax = max(node.BoundsMax, bounds.Max);
+				node.Power += bounds.Power;
+				centroidMin = min(centroidMin, centroid);
+				centroidMax = max(centroidMax, centroid);
+			}
+
+			if (end - begin == 1)
+			{
+				node.ChildOrLight = order_[begin] | LightTreeNode::Leaf;
+				lights_[order_[begin]].BitTrail = bitTrail;
+				nodes_[nodeIndex] = node;
+				return;
+			}
+
+			const vec3 extent = centroidMax - centroidMin;
+			const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+			const size_t middle = begin + (end - begin) / 2;
+
+			std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end, [this, axis](const uint32_t a, const uint32_t b)
+			{
+				return bounds_[a].Min[axis] + bounds_[a].Max[axis] < bounds_[b].Min[axis] + bounds_[b].Max[axis];
+			});
+
+			BuildNode(begin, middle, bitTrail, depth + 1);
+			node.ChildOrLight = static_cast<uint32_t>(nodes_.size());
+			BuildNode(middle, end, bitTrail | (1u << depth), depth + 1);
+
+			nodes_[nodeIndex] = node;
+		}
+
+	private:
+
+		std::vector<Light>& lights_;
+		std::vector<LightTreeNode>& nodes_;
+		std::vector<LightBounds> bounds_;
+		std::vector<uint32_t> order_;
+	};
+}
+
+std::vector<LightTreeNode> LightTree::Build(std::vector<Light>& lights)
+{
+	std::vector<LightTreeNode> nodes;
+
+	// An empty root with no power disables light sampling in the shaders.
+	if (lights.empty())
+	{
+		nodes.push_back(LightTreeNode{vec3(0), 0, vec3(0), LightTreeNode::Leaf});
+		return nodes;
+	}
+
+	nodes.reserve(2 * lights.size() - 1);
+
+	Builder builder(lights, nodes);
+	builder.BuildNode(0, lights.size(), 0, 0);
+
+	return nodes;
+}
+
+}
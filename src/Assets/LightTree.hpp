@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Light.hpp"
+#include <vector>
+
+namespace Assets
+{
+
+	// Node of the light tree. Nodes are stored depth first, so the left child of an interior node immediately follows it.
+	struct alignas(16) LightTreeNode final
+	{
+		static constexpr uint32_t Leaf = 0x80000000u;
+
+		glm::vec3 BoundsMin;
+		float Power;
+		glm::vec3 BoundsMax;
+		uint32_t ChildOrLight; // right child index, or light index | Leaf
+	};
+
+	// Binary bounding volume hierarchy over the emissive primitives, with one light per leaf. The shaders walk it stochastically,
+	// picking each child proportionally to an estimate of its contribution to the shaded point, so the cost of picking a light
+	// only grows logarithmically with the number of lights (see Conty & Kulla, "Importance Sampling of Many Lights with
+	// Adaptive Tree Splitting").
+	class LightTree final
+	{
+	public:
+
+		// Build the tree over the given lights and fill in their bit trails. Always returns at least one (root) node.
+		static std::vector<LightTreeNode> Build(std::vector<Light>& lights);
+	};
+
+}
@@ -0,0 +1,101 @@
+#include "MeshOptimizer.hpp"
+#include "GeometryKernels.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using namespace glm;
+
+namespace Assets {
+
+namespace
+{
+	// Spread the lower 10 bits of v so that there are two zero bits between each of them.
+	// https://developer.nvidia.com/blog/thinking-parallel-part-iii-tree-construction-gpu/
+	uint32_t ExpandBits(uint32_t v)
+	{
+		v = (v * 0x00010001u) & 0xFF0000FFu;
+		v = (v * 0x00000101u) & 0x0F00F00Fu;
+		v = (v * 0x00000011u) & 0xC30C30C3u;
+		v = (v * 0x00000005u) & 0x49249249u;
+		return v;
+	}
+
+	// 30-bit Morton code of a point normalised to the [0, 1] unit cube.
+	uint32_t MortonCode(const vec3& p)
+	{
+		const vec3 q = clamp(p * 1024.0f, vec3(0.0f), vec3(1023.0f));
+
+		return
+			(ExpandBits(static_cast<uint32_t>(q.x)) << 2) |
+			(ExpandBits(static_cast<uint32_t>(q.y)) << 1) |
+			(ExpandBits(static_cast<uint32_t>(q.z)) << 0);
+	}
+}
+
+void MeshOptimizer::ReorderSpatially(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	const size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount < 2)
+	{
+		return;
+	}
+
+	// Compute the vertex bounds, so the Morton grid covers the whole mesh (the centroids always lie inside them).
+	const auto bounds = GeometryKernels::ComputeBounds(vertices);
+	const vec3 min = bounds.first;
+	const vec3 max = bounds.second;
+
+	const vec3 extent = max - min;
+	const vec3 invExtent(
+		extent.x > 0 ? 1.0f / extent.x : 0.0f,
+		extent.y > 0 ? 1.0f / extent.y : 0.0f,
+		extent.z > 0 ? 1.0f / extent.z : 0.0f);
+
+	// Sort the triangles by the Morton code of their centroid (ties are broken by the original order to stay deterministic).
+	std::vector<std::pair<uint32_t, uint32_t>> keys(triangleCount);
+
+	for (size_t i = 0; i != triangleCount; ++i)
+	{
+		const vec3 centroid =
+			(vertices[indices[3 * i + 0]].Position +
+			 vertices[indices[3 * i + 1]].Position +
+			 vertices[indices[3 * i + 2]].Position) / 3.0f;
+
+		keys[i] = std::make_pair(MortonCode((centroid - min) * invExtent), static_cast<uint32_t>(i));
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	// Rebuild the index and vertex buffers, renumbering the vertices in the order they are first referenced.
+	constexpr auto unassigned = std::numeric_limits<uint32_t>::max();
+
+	std::vector<uint32_t> remap(vertices.size(), unassigned);
+	std::vector<Vertex> newVertices;
+	std::vector<uint32_t> newIndices;
+
+	newVertices.reserve(vertices.size());
+	newIndices.reserve(indices.size());
+
+	for (const auto& key : keys)
+	{
+		for (size_t k = 0; k != 3; ++k)
+		{
+			const uint32_t index = indices[3 * key.second + k];
+
+			if (remap[index] == unassigned)
+			{
+				remap[index] = static_cast<uint32_t>(newVertices.size());
+				newVertices.push_back(vertices[index]);
+			}
+
+			newIndices.push_back(remap[index]);
+		}
+	}
+
+	vertices = std::move(newVertices);
+	indices = std::move(newIndices);
+}
+
+}
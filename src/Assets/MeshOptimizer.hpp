@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Vertex.hpp"
+#include <vector>
+
+namespace Assets
+{
+
+	class MeshOptimizer final
+	{
+	public:
+
+		// Reorder the triangles along a Morton curve (Z-order) of their centroids, then renumber the vertices
+		// in first-use order. Triangles that are close in space end up close in the index buffer, and the vertices
+		// they share end up close in the vertex buffer.
+		static void ReorderSpatially(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	};
+
+}
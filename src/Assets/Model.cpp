@@ -1,12 +1,13 @@
 #include "Model.hpp"
 #include "CornellBox.hpp"
+#include "GeometryKernels.hpp"
+#include "MeshOptimizer.hpp"
 #include "Procedural.hpp"
 #include "Sphere.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/Console.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtx/hash.hpp>
 
 #include <tiny_obj_loader.h>
@@ -146,25 +147,12 @@ Model Model::LoadModel(const std::string& filename)
 	// See https://stackoverflow.com/questions/12139840/obj-file-averaging-normals.
 	if (objAttrib.normals.empty())
 	{
-		std::vector<vec3> normals(vertices.size());
-		
-		for (size_t i = 0; i < indices.size(); i += 3)
-		{
-			const auto normal = normalize(cross(
-				vec3(vertices[indices[i + 1]].Position) - vec3(vertices[indices[i]].Position),
-				vec3(vertices[indices[i + 2]].Position) - vec3(vertices[indices[i]].Position)));
-
-			vertices[indices[i + 0]].Normal += normal;
-			vertices[indices[i + 1]].Normal += normal;
-			vertices[indices[i + 2]].Normal += normal;			
-		}
-
-		for (auto& vertex : vertices)
-		{
-			vertex.Normal = normalize(vertex.Normal);
-		}
+		GeometryKernels::ComputeSmoothNormals(vertices, indices);
 	}
 
+	// OBJ files (especially 3D scans) have poor spatial locality, reorder the geometry before it gets uploaded.
+	MeshOptimizer::ReorderSpatially(vertices, indices);
+
 	const auto elapsed = std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - timer).count();
 
 	std::cout << "(" << objAttrib.vertices.size() << " vertices, " << uniqueVertices.size() << " unique vertices, " << materials.size() << " materials) ";
@@ -243,6 +231,13 @@ Model Model::CreateBox(const vec3& p0, const vec3& p1, const Material& material)
 
 Model Model::CreateSphere(const vec3& center, float radius, const Material& material, const bool isProcedural)
 {
+	// Procedurals are ray traced analytically, only the description is needed.
+	// The raster path draws them with a shared sphere mesh (see Scene::CreateRasterProxies).
+	if (isProcedural)
+	{
+		return Model({}, {}, std::vector<Material>{material}, new Sphere(center, radius));
+	}
+
 	const int slices = 32;
 	const int stacks = 16;
 	
@@ -308,7 +303,7 @@ Model Model::CreateSphere(const vec3& center, float radius, const Material& mate
 		std::move(vertices),
 		std::move(indices),
 		std::vector<Material>{material},
-		isProcedural ? new Sphere(center, radius) : nullptr);
+		nullptr);
 }
 
 void Model::SetMaterial(const Material& material)
@@ -319,25 +314,65 @@ void Model::SetMaterial(const Material& material)
 	}
 
 	materials_[0] = material;
+
+	UpdateSharedMaterialModel();
 }
 
 void Model::Transform(const mat4& transform)
 {
-	const auto transformIT = inverseTranspose(transform);
+	GeometryKernels::Transform(vertices_, transform);
 
-	for (auto& vertex : vertices_)
+	if (!procedural_)
 	{
-		vertex.Position = transform * vec4(vertex.Position, 1);
-		vertex.Normal = transformIT * vec4(vertex.Normal, 0);
+		bounds_ = GeometryKernels::ComputeBounds(vertices_);
 	}
 }
 
+void Model::ReleaseHostData()
+{
+	// Swap with empty vectors, as clear() does not give the memory back.
+	std::vector<Vertex>().swap(vertices_);
+	std::vector<uint32_t>().swap(indices_);
+	std::vector<Material>().swap(materials_);
+
+	hasHostData_ = false;
+}
+
 Model::Model(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, std::vector<Material>&& materials, const class Procedural* procedural) :
 	vertices_(std::move(vertices)), 
 	indices_(std::move(indices)),
 	materials_(std::move(materials)),
-	procedural_(procedural)
+	procedural_(procedural),
+	numberOfVertices_(static_cast<uint32_t>(vertices_.size())),
+	numberOfIndices_(static_cast<uint32_t>(indices_.size())),
+	numberOfMaterials_(static_cast<uint32_t>(materials_.size())),
+	hasHostData_(true)
+{
+	bounds_ = procedural_ ? procedural_->BoundingBox() : GeometryKernels::ComputeBounds(vertices_);
+
+	UpdateSharedMaterialModel();
+}
+
+void Model::UpdateSharedMaterialModel()
 {
+	sharedMaterialModel_.reset();
+
+	if (materials_.empty())
+	{
+		return;
+	}
+
+	const auto model = materials_[0].MaterialModel;
+
+	for (const auto& material : materials_)
+	{
+		if (material.MaterialModel != model)
+		{
+			return;
+		}
+	}
+
+	sharedMaterialModel_ = model;
 }
 
 }
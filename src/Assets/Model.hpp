@@ -4,7 +4,9 @@
 #include "Procedural.hpp"
 #include "Vertex.hpp"
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace Assets
@@ -29,24 +31,43 @@ namespace Assets
 		void SetMaterial(const Material& material);
 		void Transform(const glm::mat4& transform);
 
+		// Drop the host copies of the geometry once it has been uploaded to the GPU. Only the counts are kept.
+		void ReleaseHostData();
+		bool HasHostData() const { return hasHostData_; }
+
 		const std::vector<Vertex>& Vertices() const { return vertices_; }
 		const std::vector<uint32_t>& Indices() const { return indices_; }
 		const std::vector<Material>& Materials() const { return materials_; }
 
 		const class Procedural* Procedural() const { return procedural_.get(); }
 
-		uint32_t NumberOfVertices() const { return static_cast<uint32_t>(vertices_.size()); }
-		uint32_t NumberOfIndices() const { return static_cast<uint32_t>(indices_.size()); }
-		uint32_t NumberOfMaterials() const { return static_cast<uint32_t>(materials_.size()); }
+		// Axis aligned bounding box (min, max) of the model, still valid after ReleaseHostData().
+		const std::pair<glm::vec3, glm::vec3>& BoundingBox() const { return bounds_; }
+
+		// Material model shared by all the materials of the model if there is one, still valid after ReleaseHostData().
+		const std::optional<Material::Enum>& SharedMaterialModel() const { return sharedMaterialModel_; }
+
+		uint32_t NumberOfVertices() const { return numberOfVertices_; }
+		uint32_t NumberOfIndices() const { return numberOfIndices_; }
+		uint32_t NumberOfMaterials() const { return numberOfMaterials_; }
 
 	private:
 
 		Model(std::vector<Vertex>&& vertices, std::vector<uint32_t>&& indices, std::vector<Material>&& materials, const class Procedural* procedural);
 
+		void UpdateSharedMaterialModel();
+
 		std::vector<Vertex> vertices_;
 		std::vector<uint32_t> indices_;
 		std::vector<Material> materials_;
 		std::shared_ptr<const class Procedural> procedural_;
+		std::pair<glm::vec3, glm::vec3> bounds_;
+		std::optional<Material::Enum> sharedMaterialModel_;
+
+		uint32_t numberOfVertices_{};
+		uint32_t numberOfIndices_{};
+		uint32_t numberOfMaterials_{};
+		bool hasHostData_{};
 	};
 
 }
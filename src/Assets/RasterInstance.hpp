@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include "Vulkan/Vulkan.hpp"
+#include <array>
+
+namespace Assets
+{
+
+	// Per-instance data of the raster path. Each triangle mesh is drawn with its own identity instance, while procedural
+	// spheres are drawn as instances of a single shared unit sphere mesh (see Scene::CreateRasterProxies). The model index
+	// lets the visibility buffer refer back to the scene model (see VisibilityPipeline).
+	// Aligned to match the std430 layout, as the culling shader copies the visible instances.
+	struct alignas(16) RasterInstance final
+	{
+		glm::vec4 TranslationAndScale;
+		int32_t MaterialOffset;
+		uint32_t ModelIndex;
+
+		static VkVertexInputBindingDescription GetBindingDescription()
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = 1;
+			bindingDescription.stride = sizeof(RasterInstance);
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+			return bindingDescription;
+		}
+
+		static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescriptions()
+		{
+			std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions = {};
+
+			attributeDescriptions[0].binding = 1;
+			attributeDescriptions[0].location = 4;
+			attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[0].offset = offsetof(RasterInstance, TranslationAndScale);
+
+			attributeDescriptions[1].binding = 1;
+			attributeDescriptions[1].location = 5;
+			attributeDescriptions[1].format = VK_FORMAT_R32_SINT;
+			attributeDescriptions[1].offset = offsetof(RasterInstance, MaterialOffset);
+
+			attributeDescriptions[2].binding = 1;
+			attributeDescriptions[2].location = 6;
+			attributeDescriptions[2].format = VK_FORMAT_R32_UINT;
+			attributeDescriptions[2].offset = offsetof(RasterInstance, ModelIndex);
+
+			return attributeDescriptions;
+		}
+	};
+
+	// One entry per drawable object, culled on the GPU (see FrustumCulling.comp). Triangle meshes get their own draw
+	// command of their instance, spheres have no index range of their own (zero index count) and share the sphere draw.
+	struct RasterObject final
+	{
+		glm::vec4 BoundsMin;
+		glm::vec4 BoundsMax;
+		uint32_t IndexCount;
+		uint32_t FirstIndex;
+		int32_t VertexOffset;
+		uint32_t InstanceIndex;
+	};
+
+}
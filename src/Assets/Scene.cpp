@@ -1,5 +1,9 @@
 #include "Scene.hpp"
+#include "GeometryKernels.hpp"
+#include "Light.hpp"
+#include "LightTree.hpp"
 #include "Model.hpp"
+#include "RasterInstance.hpp"
 #include "Sphere.hpp"
 #include "Texture.hpp"
 #include "TextureImage.hpp"
@@ -8,42 +12,101 @@
 #include "Vulkan/Sampler.hpp"
 #include "Utilities/Exception.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
+#include <algorithm>
 
 
 namespace Assets {
 
-Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures) :
+namespace
+{
+	// Gather the emissive triangles and spheres of the scene for explicit light sampling. Each emissive model gets a table
+	// mapping its primitives to their light index (~0 for primitives that are not lights), whose offset is stored in offsets.w.
+	void CreateLights(const std::vector<Model>& models, std::vector<glm::uvec4>& offsets, std::vector<Light>& lights, std::vector<uint32_t>& lightIndices)
+	{
+		constexpr float pi = 3.14159265358979f;
+		constexpr uint32_t notALight = ~0u;
+
+		for (size_t m = 0; m != models.size(); ++m)
+		{
+			const auto& model = models[m];
+			const auto& materials = model.Materials();
+
+			const bool isEmissive = std::any_of(materials.begin(), materials.end(), [](const Material& material)
+			{
+				return material.MaterialModel == Material::Enum::DiffuseLight;
+			});
+
+			if (!isEmissive)
+			{
+				continue;
+			}
+
+			offsets[m].w = static_cast<uint32_t>(lightIndices.size());
+
+			const auto* const sphere = dynamic_cast<const Sphere*>(model.Procedural());
+			if (sphere != nullptr)
+			{
+				const float area = 4 * pi * sphere->Radius * sphere->Radius;
+				lightIndices.push_back(static_cast<uint32_t>(lights.size()));
+				lights.push_back(Light{glm::vec4(sphere->Center, sphere->Radius), glm::vec4(0), glm::vec4(0), glm::vec4(glm::vec3(materials[0].Diffuse), area), 0, {}});
+				continue;
+			}
+
+			const auto& vertices = model.Vertices();
+			const auto& indices = model.Indices();
+
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				const auto& v0 = vertices[indices[i + 0]];
+				const auto& material = materials[v0.MaterialIndex];
+
+				const glm::vec3& p0 = v0.Position;
+				const glm::vec3& p1 = vertices[indices[i + 1]].Position;
+				const glm::vec3& p2 = vertices[indices[i + 2]].Position;
+				const float area = 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
+
+				if (material.MaterialModel != Material::Enum::DiffuseLight || area <= 0)
+				{
+					lightIndices.push_back(notALight);
+					continue;
+				}
+
+				lightIndices.push_back(static_cast<uint32_t>(lights.size()));
+				lights.push_back(Light{glm::vec4(p0, 0), glm::vec4(p1, 0), glm::vec4(p2, 0), glm::vec4(glm::vec3(material.Diffuse), area), 0, {}});
+			}
+		}
+	}
+}
+
+Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures, const HostResidency residency) :
 	models_(std::move(models)),
 	textures_(std::move(textures))
 {
-	// Concatenate all the models
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-	std::vector<Material> materials;
+	// Compute the total sizes and the per-model offsets, so the models can be streamed straight into the staging buffers
+	// instead of being concatenated into a temporary host copy first.
+	size_t vertexCount = 0;
+	size_t indexCount = 0;
+	size_t materialCount = 0;
+
 	std::vector<glm::vec4> procedurals;
 	std::vector<VkAabbPositionsKHR> aabbs;
-	std::vector<glm::uvec2> offsets;
+	std::vector<glm::uvec4> offsets;
 
 	for (const auto& model : models_)
 	{
-		// Remember the index, vertex offsets.
-		const auto indexOffset = static_cast<uint32_t>(indices.size());
-		const auto vertexOffset = static_cast<uint32_t>(vertices.size());
-		const auto materialOffset = static_cast<uint32_t>(materials.size());
-
-		offsets.emplace_back(indexOffset, vertexOffset);
-
-		// Copy model data one after the other.
-		vertices.insert(vertices.end(), model.Vertices().begin(), model.Vertices().end());
-		indices.insert(indices.end(), model.Indices().begin(), model.Indices().end());
-		materials.insert(materials.end(), model.Materials().begin(), model.Materials().end());
-
-		// Adjust the material id.
-		for (size_t i = vertexOffset; i != vertices.size(); ++i)
+		// A bad index would make the GPU read out of bounds, catch it while we still have the host data.
+		if (model.HasHostData() && !GeometryKernels::ValidateIndices(model.Indices(), model.Vertices().size()))
 		{
-			vertices[i].MaterialIndex += materialOffset;
+			Throw(std::runtime_error("model has invalid triangle indices"));
 		}
 
+		// Remember the index, vertex and material offsets (procedurals have no vertex to carry their material index).
+		offsets.emplace_back(static_cast<uint32_t>(indexCount), static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(materialCount), 0);
+
+		vertexCount += model.NumberOfVertices();
+		indexCount += model.NumberOfIndices();
+		materialCount += model.NumberOfMaterials();
+
 		// Add optional procedurals.
 		const auto* const sphere = dynamic_cast<const Sphere*>(model.Procedural());
 		if (sphere != nullptr)
@@ -59,17 +122,92 @@ Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std:
 		}
 	}
 
+	// Lights must be gathered while the host data is still around, and before the offsets are uploaded.
+	std::vector<Light> lights;
+	std::vector<uint32_t> lightIndices;
+
+	CreateLights(models_, offsets, lights, lightIndices);
+
+	const auto lightTree = LightTree::Build(lights);
+	numberOfLights_ = static_cast<uint32_t>(lights.size());
+
+	// Vulkan does not allow empty buffers, the shaders do not sample lights when the light tree root has no power.
+	if (lights.empty())
+	{
+		lights.emplace_back();
+	}
+
+	if (lightIndices.empty())
+	{
+		lightIndices.push_back(0);
+	}
+
+	const auto writeVertices = [this](void* const data)
+	{
+		auto* dst = static_cast<Vertex*>(data);
+		int32_t materialOffset = 0;
+
+		for (const auto& model : models_)
+		{
+			// Copy model data one after the other, adjusting the material id on the fly.
+			for (const auto& vertex : model.Vertices())
+			{
+				Vertex v = vertex;
+				v.MaterialIndex += materialOffset;
+				*dst++ = v;
+			}
+
+			materialOffset += static_cast<int32_t>(model.NumberOfMaterials());
+		}
+	};
+
+	const auto writeIndices = [this](void* const data)
+	{
+		auto* dst = static_cast<uint32_t*>(data);
+
+		for (const auto& model : models_)
+		{
+			dst = std::copy(model.Indices().begin(), model.Indices().end(), dst);
+		}
+	};
+
+	const auto writeMaterials = [this](void* const data)
+	{
+		auto* dst = static_cast<Material*>(data);
+
+		for (const auto& model : models_)
+		{
+			dst = std::copy(model.Materials().begin(), model.Materials().end(), dst);
+		}
+	};
+
 	constexpr auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, vertices, vertexBuffer_, vertexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indices, indexBuffer_, indexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materials, materialBuffer_, materialBufferMemory_);
+	// Vulkan does not allow empty buffers, which happens with scenes made only of procedurals.
+	vertexCount = std::max<size_t>(vertexCount, 1);
+	indexCount = std::max<size_t>(indexCount, 1);
+
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, vertexCount * sizeof(Vertex), writeVertices, vertexBuffer_, vertexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indexCount * sizeof(uint32_t), writeIndices, indexBuffer_, indexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materialCount * sizeof(Material), writeMaterials, materialBuffer_, materialBufferMemory_);
 	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Offsets", flags, offsets, offsetBuffer_, offsetBufferMemory_);
 
 	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "AABBs", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
 	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
 
-	
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Lights", flags, lights, lightBuffer_, lightBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Light Tree", flags, lightTree, lightTreeBuffer_, lightTreeBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Light Indices", flags, lightIndices, lightIndexBuffer_, lightIndexBufferMemory_);
+
+	// The GPU has its own copy now, only keep the model metadata (counts, procedurals).
+	if (residency == HostResidency::Release)
+	{
+		for (auto& model : models_)
+		{
+			model.ReleaseHostData();
+		}
+	}
+
 	// Upload all textures
 	textureImages_.reserve(textures_.size());
 	textureImageViewHandles_.resize(textures_.size());
@@ -81,6 +219,64 @@ Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std:
 	   textureImageViewHandles_[i] = textureImages_[i]->ImageView().Handle();
 	   textureSamplerHandles_[i] = textureImages_[i]->Sampler().Handle();
 	}
+
+	if (residency == HostResidency::Release)
+	{
+		std::vector<Texture>().swap(textures_);
+	}
+}
+
+void Scene::CreateRasterProxies(Vulkan::CommandPool& commandPool)
+{
+	if (HasRasterProxies())
+	{
+		return;
+	}
+
+	// Unit sphere, its vertices all use the instance material.
+	const auto sphere = Model::CreateSphere(glm::vec3(0), 1, Material{}, false);
+
+	std::vector<RasterInstance> instances;
+	std::vector<RasterObject> objects;
+
+	uint32_t vertexOffset = 0;
+	uint32_t indexOffset = 0;
+	int32_t materialOffset = 0;
+	uint32_t sphereCount = 0;
+
+	for (uint32_t m = 0; m != models_.size(); ++m)
+	{
+		const auto& model = models_[m];
+		const auto& bounds = model.BoundingBox();
+		const auto* const procedural = dynamic_cast<const Sphere*>(model.Procedural());
+
+		if (procedural != nullptr)
+		{
+			objects.push_back(RasterObject{glm::vec4(bounds.first, 0), glm::vec4(bounds.second, 0), 0, 0, 0, static_cast<uint32_t>(instances.size())});
+			instances.push_back(RasterInstance{glm::vec4(procedural->Center, procedural->Radius), materialOffset, m});
+			sphereCount++;
+		}
+		else if (model.NumberOfIndices() != 0)
+		{
+			objects.push_back(RasterObject{glm::vec4(bounds.first, 0), glm::vec4(bounds.second, 0), model.NumberOfIndices(), indexOffset, static_cast<int32_t>(vertexOffset), static_cast<uint32_t>(instances.size())});
+			instances.push_back(RasterInstance{glm::vec4(0, 0, 0, 1), 0, m});
+		}
+
+		vertexOffset += model.NumberOfVertices();
+		indexOffset += model.NumberOfIndices();
+		materialOffset += static_cast<int32_t>(model.NumberOfMaterials());
+	}
+
+	constexpr auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Raster Objects", flags, objects, rasterObjectBuffer_, rasterObjectBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Raster Instances", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | flags, instances, rasterInstanceBuffer_, rasterInstanceBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Sphere Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, sphere.Vertices(), sphereVertexBuffer_, sphereVertexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Sphere Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT, sphere.Indices(), sphereIndexBuffer_, sphereIndexBufferMemory_);
+
+	numberOfSphereIndices_ = sphere.NumberOfIndices();
+	numberOfSphereInstances_ = sphereCount;
+	numberOfRasterObjects_ = static_cast<uint32_t>(objects.size());
 }
 
 Scene::~Scene()
@@ -88,6 +284,20 @@ Scene::~Scene()
 	textureSamplerHandles_.clear();
 	textureImageViewHandles_.clear();
 	textureImages_.clear();
+	sphereIndexBuffer_.reset();
+	sphereIndexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	sphereVertexBuffer_.reset();
+	sphereVertexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	rasterInstanceBuffer_.reset();
+	rasterInstanceBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	rasterObjectBuffer_.reset();
+	rasterObjectBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	lightIndexBuffer_.reset();
+	lightIndexBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	lightTreeBuffer_.reset();
+	lightTreeBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	lightBuffer_.reset();
+	lightBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	proceduralBuffer_.reset();
 	proceduralBufferMemory_.reset(); // release memory after bound buffer has been destroyed
 	aabbBuffer_.reset();
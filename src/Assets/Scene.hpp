@@ -18,6 +18,13 @@ namespace Assets
 	class Texture;
 	class TextureImage;
 
+	// Whether the host copies of the geometry and texture pixels are kept once they have been uploaded to the GPU.
+	enum class HostResidency
+	{
+		Keep,
+		Release
+	};
+
 	class Scene final
 	{
 	public:
@@ -27,25 +34,42 @@ namespace Assets
 		Scene& operator = (const Scene&) = delete;
 		Scene& operator = (Scene&&) = delete;
 
-		Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures);
+		Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures, HostResidency residency = HostResidency::Release);
 		~Scene();
 
 		const std::vector<Model>& Models() const { return models_; }
 		bool HasProcedurals() const { return static_cast<bool>(proceduralBuffer_); }
 
+		// Procedural models carry no triangles. The raster path draws them as instances of a shared unit sphere mesh,
+		// which is only created the first time it is needed. Instance 0 is the identity instance used by triangle meshes.
+		// Every mesh and sphere also gets a raster object (bounds and draw parameters) for the GPU frustum culling.
+		void CreateRasterProxies(Vulkan::CommandPool& commandPool);
+		bool HasRasterProxies() const { return static_cast<bool>(rasterInstanceBuffer_); }
+
 		const Vulkan::Buffer& VertexBuffer() const { return *vertexBuffer_; }
 		const Vulkan::Buffer& IndexBuffer() const { return *indexBuffer_; }
 		const Vulkan::Buffer& MaterialBuffer() const { return *materialBuffer_; }
 		const Vulkan::Buffer& OffsetsBuffer() const { return *offsetBuffer_; }
 		const Vulkan::Buffer& AabbBuffer() const { return *aabbBuffer_; }
 		const Vulkan::Buffer& ProceduralBuffer() const { return *proceduralBuffer_; }
+		const Vulkan::Buffer& LightBuffer() const { return *lightBuffer_; }
+		const Vulkan::Buffer& LightTreeBuffer() const { return *lightTreeBuffer_; }
+		const Vulkan::Buffer& LightIndexBuffer() const { return *lightIndexBuffer_; }
+		const Vulkan::Buffer& RasterObjectBuffer() const { return *rasterObjectBuffer_; }
+		const Vulkan::Buffer& RasterInstanceBuffer() const { return *rasterInstanceBuffer_; }
+		const Vulkan::Buffer& SphereVertexBuffer() const { return *sphereVertexBuffer_; }
+		const Vulkan::Buffer& SphereIndexBuffer() const { return *sphereIndexBuffer_; }
+		uint32_t NumberOfLights() const { return numberOfLights_; }
+		uint32_t NumberOfSphereIndices() const { return numberOfSphereIndices_; }
+		uint32_t NumberOfSphereInstances() const { return numberOfSphereInstances_; }
+		uint32_t NumberOfRasterObjects() const { return numberOfRasterObjects_; }
 		const std::vector<VkImageView> TextureImageViews() const { return textureImageViewHandles_; }
 		const std::vector<VkSampler> TextureSamplers() const { return textureSamplerHandles_; }
 
 	private:
 
-		const std::vector<Model> models_;
-		const std::vector<Texture> textures_;
+		std::vector<Model> models_;
+		std::vector<Texture> textures_;
 
 		std::unique_ptr<Vulkan::Buffer> vertexBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> vertexBufferMemory_;
@@ -65,6 +89,32 @@ namespace Assets
 		std::unique_ptr<Vulkan::Buffer> proceduralBuffer_;
 		std::unique_ptr<Vulkan::DeviceMemory> proceduralBufferMemory_;
 
+		std::unique_ptr<Vulkan::Buffer> lightBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> lightTreeBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightTreeBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> lightIndexBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> lightIndexBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> rasterObjectBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> rasterObjectBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> rasterInstanceBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> rasterInstanceBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> sphereVertexBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> sphereVertexBufferMemory_;
+
+		std::unique_ptr<Vulkan::Buffer> sphereIndexBuffer_;
+		std::unique_ptr<Vulkan::DeviceMemory> sphereIndexBufferMemory_;
+
+		uint32_t numberOfLights_{};
+		uint32_t numberOfSphereIndices_{};
+		uint32_t numberOfSphereInstances_{};
+		uint32_t numberOfRasterObjects_{};
+
 		std::vector<std::unique_ptr<TextureImage>> textureImages_;
 		std::vector<VkImageView> textureImageViewHandles_;
 		std::vector<VkSampler> textureSamplerHandles_;
@@ -20,15 +20,28 @@ namespace Assets
 		glm::mat4 Projection;
 		glm::mat4 ModelViewInverse;
 		glm::mat4 ProjectionInverse;
+		glm::mat4 PreviousModelView;
 		float Aperture;
 		float FocusDistance;
 		float HeatmapScale;
 		uint32_t TotalNumberOfSamples;
 		uint32_t NumberOfSamples;
-		uint32_t NumberOfBounces;
 		uint32_t RandomSeed;
-		uint32_t HasSky; // bool
-		uint32_t ShowHeatmap; // bool
+		uint32_t Sampler;
+		uint32_t AdaptiveSampling; // bool
+		uint32_t UpdateSampleBudgets; // bool
+		float ErrorTarget;
+		uint32_t RussianRouletteDepth;
+		uint32_t Reproject; // bool
+		uint32_t MaxHistoryLength;
+		uint32_t RenderWidth;
+		uint32_t RenderHeight;
+		uint32_t InterleaveRate;
+		uint32_t InterleavePhase;
+		float PrimaryJitterX; // sub-pixel position of the rasterized first hits, in hybrid mode
+		float PrimaryJitterY;
+		uint32_t FirstRow; // first row of the band traced by this device, in split-frame mode
+		uint32_t SampleOffset; // index of the first accumulated sample, when the samples of the pixels are split between workers
 	};
 
 	class UniformBuffer
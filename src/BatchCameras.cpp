@@ -0,0 +1,52 @@
+#include "BatchCameras.hpp"
+#include "Utilities/Exception.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::vector<glm::mat4> BatchCameras::Load(const std::string& filename)
+{
+	std::cout << "- loading '" << filename << "'... " << std::flush;
+
+	std::ifstream file(filename);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to open camera file '" + filename + "'"));
+	}
+
+	std::vector<glm::mat4> modelViews;
+	std::string line;
+	size_t lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		const auto first = line.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream stream(line);
+		glm::vec3 eye, target;
+
+		if (!(stream >> eye.x >> eye.y >> eye.z >> target.x >> target.y >> target.z))
+		{
+			Throw(std::runtime_error("invalid camera on line " + std::to_string(lineNumber) + " of '" + filename + "'"));
+		}
+
+		modelViews.push_back(glm::lookAt(eye, target, glm::vec3(0, 1, 0)));
+	}
+
+	if (modelViews.empty())
+	{
+		Throw(std::runtime_error("no camera in '" + filename + "'"));
+	}
+
+	std::cout << "(" << modelViews.size() << " views)" << std::endl;
+
+	return modelViews;
+}
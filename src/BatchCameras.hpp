@@ -0,0 +1,15 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include <string>
+#include <vector>
+
+// Camera views rendered together in batch mode (see RayTracer::SetBatchViews).
+class BatchCameras final
+{
+public:
+
+	// Each line of the file holds the eye and target positions of a view (6 numbers), lines starting with '#' are
+	// comments. Returns the view model view matrices, looking at the target with the Y axis up.
+	static std::vector<glm::mat4> Load(const std::string& filename);
+};
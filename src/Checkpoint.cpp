@@ -0,0 +1,195 @@
+#include "Checkpoint.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/Scene.hpp"
+#include "Utilities/Exception.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	const char FileMagic[8] = { 'R', 'T', 'V', 'C', 'K', 'P', 'T', '1' };
+
+	// Fixed size part of the file, followed by the accumulation and the variance.
+	struct FileHeader final
+	{
+		char Magic[8];
+		uint32_t SceneIndex;
+		uint32_t NumberOfBounces;
+		uint32_t NextEventEstimation;
+		uint32_t RussianRoulette;
+		uint32_t RussianRouletteDepth;
+		uint32_t Sampler;
+		glm::mat4 ModelView;
+		float FieldOfView;
+		float Aperture;
+		float FocusDistance;
+		uint32_t TotalNumberOfSamples;
+		uint32_t AccumulatedFrames;
+		uint32_t RandomSeed;
+		uint64_t Hash;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	// 64-bit FNV-1a.
+	class Hasher final
+	{
+	public:
+
+		template <class T>
+		void Add(const std::vector<T>& values) { Add(values.data(), values.size() * sizeof(T)); }
+
+		template <class T>
+		void Add(const T& value) { Add(&value, sizeof(T)); }
+
+		void Add(const void* const data, const size_t size)
+		{
+			const auto bytes = static_cast<const uint8_t*>(data);
+
+			for (size_t i = 0; i != size; ++i)
+			{
+				hash_ = (hash_ ^ bytes[i]) * 0x100000001b3ull;
+			}
+		}
+
+		uint64_t Hash() const { return hash_; }
+
+	private:
+
+		uint64_t hash_{ 0xcbf29ce484222325ull };
+	};
+}
+
+uint64_t Checkpoint::HashScene(const Assets::Scene& scene)
+{
+	Hasher hasher;
+
+	for (const auto& model : scene.Models())
+	{
+		if (!model.HasHostData())
+		{
+			Throw(std::runtime_error("cannot hash a scene without its host data"));
+		}
+
+		// The bounds also cover the procedural models, which have no triangles.
+		hasher.Add(model.BoundingBox().first);
+		hasher.Add(model.BoundingBox().second);
+		hasher.Add(model.Vertices());
+		hasher.Add(model.Indices());
+		hasher.Add(model.Materials());
+	}
+
+	return hasher.Hash();
+}
+
+uint64_t Checkpoint::ComputeHash(const uint64_t sceneHash) const
+{
+	Hasher hasher;
+
+	hasher.Add(sceneHash);
+	hasher.Add(SceneIndex);
+	hasher.Add(NumberOfBounces);
+	hasher.Add(NextEventEstimation);
+	hasher.Add(RussianRoulette);
+	hasher.Add(RussianRouletteDepth);
+	hasher.Add(Sampler);
+	hasher.Add(RandomSeed);
+	hasher.Add(ModelView);
+	hasher.Add(FieldOfView);
+	hasher.Add(Aperture);
+	hasher.Add(FocusDistance);
+	hasher.Add(Width);
+	hasher.Add(Height);
+
+	return hasher.Hash();
+}
+
+void Checkpoint::Save(const std::string& filename) const
+{
+	FileHeader header{};
+	std::memcpy(header.Magic, FileMagic, sizeof(FileMagic));
+	header.SceneIndex = SceneIndex;
+	header.NumberOfBounces = NumberOfBounces;
+	header.NextEventEstimation = NextEventEstimation;
+	header.RussianRoulette = RussianRoulette;
+	header.RussianRouletteDepth = RussianRouletteDepth;
+	header.Sampler = Sampler;
+	header.ModelView = ModelView;
+	header.FieldOfView = FieldOfView;
+	header.Aperture = Aperture;
+	header.FocusDistance = FocusDistance;
+	header.TotalNumberOfSamples = TotalNumberOfSamples;
+	header.AccumulatedFrames = AccumulatedFrames;
+	header.RandomSeed = RandomSeed;
+	header.Hash = Hash;
+	header.Width = Width;
+	header.Height = Height;
+
+	const std::string temporary = filename + ".tmp";
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(Accumulation.data()), Accumulation.size() * sizeof(Accumulation[0]));
+		file.write(reinterpret_cast<const char*>(Variance.data()), Variance.size() * sizeof(Variance[0]));
+
+		if (!file)
+		{
+			Throw(std::runtime_error("failed to write checkpoint '" + temporary + "'"));
+		}
+	}
+
+	std::filesystem::rename(temporary, filename);
+}
+
+Checkpoint Checkpoint::Load(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to open checkpoint '" + filename + "'"));
+	}
+
+	FileHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	if (!file || std::memcmp(header.Magic, FileMagic, sizeof(FileMagic)) != 0)
+	{
+		Throw(std::runtime_error("'" + filename + "' is not a checkpoint"));
+	}
+
+	Checkpoint checkpoint{};
+	checkpoint.SceneIndex = header.SceneIndex;
+	checkpoint.NumberOfBounces = header.NumberOfBounces;
+	checkpoint.NextEventEstimation = header.NextEventEstimation;
+	checkpoint.RussianRoulette = header.RussianRoulette;
+	checkpoint.RussianRouletteDepth = header.RussianRouletteDepth;
+	checkpoint.Sampler = header.Sampler;
+	checkpoint.ModelView = header.ModelView;
+	checkpoint.FieldOfView = header.FieldOfView;
+	checkpoint.Aperture = header.Aperture;
+	checkpoint.FocusDistance = header.FocusDistance;
+	checkpoint.TotalNumberOfSamples = header.TotalNumberOfSamples;
+	checkpoint.AccumulatedFrames = header.AccumulatedFrames;
+	checkpoint.RandomSeed = header.RandomSeed;
+	checkpoint.Hash = header.Hash;
+	checkpoint.Width = header.Width;
+	checkpoint.Height = header.Height;
+
+	const size_t pixelCount = static_cast<size_t>(header.Width) * header.Height;
+	checkpoint.Accumulation.resize(pixelCount);
+	checkpoint.Variance.resize(pixelCount);
+
+	file.read(reinterpret_cast<char*>(checkpoint.Accumulation.data()), pixelCount * sizeof(checkpoint.Accumulation[0]));
+	file.read(reinterpret_cast<char*>(checkpoint.Variance.data()), pixelCount * sizeof(checkpoint.Variance[0]));
+
+	if (!file)
+	{
+		Throw(std::runtime_error("checkpoint '" + filename + "' is truncated"));
+	}
+
+	return checkpoint;
+}
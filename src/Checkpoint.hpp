@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Assets
+{
+	class Scene;
+}
+
+// Snapshot of a progressive render, enough to carry on accumulating exactly where it stopped (see RayTracer).
+struct Checkpoint final
+{
+	// Scene, camera and settings the samples were traced with, restored on resume.
+	uint32_t SceneIndex;
+	uint32_t NumberOfBounces;
+	uint32_t NextEventEstimation; // bool
+	uint32_t RussianRoulette; // bool
+	uint32_t RussianRouletteDepth;
+	uint32_t Sampler;
+	glm::mat4 ModelView;
+	float FieldOfView;
+	float Aperture;
+	float FocusDistance;
+
+	// Random number generator state. The seeds of the paths are derived from the sample counts and the random seed, and the
+	// primary ray jitter from the number of accumulated frames.
+	uint32_t TotalNumberOfSamples;
+	uint32_t AccumulatedFrames;
+	uint32_t RandomSeed;
+
+	// Hash of the scene contents, camera and settings, checked on resume to make sure they still match.
+	uint64_t Hash;
+
+	// Render extent of the accumulation (radiance sums, sample count in alpha) and of its luminance variance.
+	uint32_t Width;
+	uint32_t Height;
+	std::vector<glm::vec4> Accumulation;
+	std::vector<float> Variance;
+
+	// Hash the geometry and the materials of the scene (once per scene, it must keep its host data), then that hash with
+	// the camera and the settings.
+	static uint64_t HashScene(const Assets::Scene& scene);
+	uint64_t ComputeHash(uint64_t sceneHash) const;
+
+	// Write to a temporary file first, then replace the previous checkpoint with it, so that a crash while saving leaves
+	// the previous one intact.
+	void Save(const std::string& filename) const;
+	static Checkpoint Load(const std::string& filename);
+};
@@ -0,0 +1,303 @@
+#include "ExrImage.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	uint16_t ToHalf(const float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+		const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		// Infinity and NaN.
+		if ((bits & 0x7fffffff) >= 0x7f800000)
+		{
+			return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+		}
+
+		// Overflow to infinity.
+		if (exponent >= 31)
+		{
+			return sign | 0x7c00;
+		}
+
+		// Denormals, or underflow to zero.
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return sign;
+			}
+
+			mantissa |= 0x800000;
+			const uint32_t shift = 14 - exponent;
+			const uint32_t denormal = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+			return sign | static_cast<uint16_t>(denormal);
+		}
+
+		// Rounding may carry into the exponent, up to infinity.
+		const uint32_t normal = (static_cast<uint32_t>(exponent) << 10 | mantissa >> 13) + ((mantissa >> 12) & 1);
+		return sign | static_cast<uint16_t>(normal);
+	}
+
+	template <class T>
+	void Append(std::vector<char>& buffer, const T& value)
+	{
+		const auto bytes = reinterpret_cast<const char*>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	void AppendString(std::vector<char>& buffer, const std::string& value)
+	{
+		buffer.insert(buffer.end(), value.c_str(), value.c_str() + value.size() + 1);
+	}
+
+	void AppendAttribute(std::vector<char>& buffer, const std::string& name, const std::string& type, const std::vector<char>& value)
+	{
+		AppendString(buffer, name);
+		AppendString(buffer, type);
+		Append(buffer, static_cast<int32_t>(value.size()));
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+
+	template <class... T>
+	std::vector<char> Values(const T&... values)
+	{
+		std::vector<char> buffer;
+		(Append(buffer, values), ...);
+		return buffer;
+	}
+
+	// OpenEXR RLE compression of a scanline, after the same byte reordering and delta predictor as the ZIP compression.
+	// Runs of 3 to 128 equal bytes are stored as (length - 1, byte), other bytes as (-count, bytes...).
+	std::vector<char> CompressRle(const std::vector<char>& scanline)
+	{
+		const size_t size = scanline.size();
+		std::vector<uint8_t> reordered(size);
+
+		for (size_t i = 0; i != size; ++i)
+		{
+			reordered[(i & 1) == 0 ? i / 2 : (size + 1) / 2 + i / 2] = static_cast<uint8_t>(scanline[i]);
+		}
+
+		for (size_t i = size - 1; i > 0; --i)
+		{
+			reordered[i] = static_cast<uint8_t>(reordered[i] - reordered[i - 1] + 128);
+		}
+
+		const size_t MinRunLength = 3;
+		const size_t MaxRunLength = 127;
+
+		std::vector<char> compressed;
+		compressed.reserve(size);
+
+		const uint8_t* const end = reordered.data() + size;
+		const uint8_t* runStart = reordered.data();
+		const uint8_t* runEnd = runStart + 1;
+
+		while (runStart < end)
+		{
+			while (runEnd < end && *runStart == *runEnd && static_cast<size_t>(runEnd - runStart - 1) < MaxRunLength)
+			{
+				++runEnd;
+			}
+
+			if (static_cast<size_t>(runEnd - runStart) >= MinRunLength)
+			{
+				compressed.push_back(static_cast<char>(runEnd - runStart - 1));
+				compressed.push_back(static_cast<char>(*runStart));
+				runStart = runEnd;
+			}
+			else
+			{
+				while (runEnd < end &&
+					((runEnd + 1 >= end || *runEnd != *(runEnd + 1)) || (runEnd + 2 >= end || *(runEnd + 1) != *(runEnd + 2))) &&
+					static_cast<size_t>(runEnd - runStart) < MaxRunLength)
+				{
+					++runEnd;
+				}
+
+				compressed.push_back(static_cast<char>(runStart - runEnd));
+				compressed.insert(compressed.end(), runStart, runEnd);
+				runStart = runEnd;
+			}
+
+			++runEnd;
+		}
+
+		return compressed;
+	}
+}
+
+ExrImage::ExrImage(const uint32_t width, const uint32_t height) :
+	width_(width),
+	height_(height)
+{
+}
+
+void ExrImage::AddAccumulation(const std::vector<glm::vec4>& accumulation, const bool half)
+{
+	const char* const names[] = { "R", "G", "B" };
+
+	for (int channel = 0; channel != 3; ++channel)
+	{
+		std::vector<float> values(accumulation.size());
+
+		for (size_t i = 0; i != accumulation.size(); ++i)
+		{
+			values[i] = accumulation[i].a > 0 ? accumulation[i][channel] / accumulation[i].a : 0.0f;
+		}
+
+		AddChannel(names[channel], values, half);
+	}
+
+	std::vector<float> sampleCounts(accumulation.size());
+	std::transform(accumulation.begin(), accumulation.end(), sampleCounts.begin(), [](const glm::vec4& pixel) { return pixel.a; });
+
+	AddChannel("SampleCount", sampleCounts, false);
+}
+
+void ExrImage::AddChannel(const std::string& name, const std::vector<float>& values, const bool half)
+{
+	std::vector<uint32_t> bits(values.size());
+	std::memcpy(bits.data(), values.data(), values.size() * sizeof(float));
+
+	channels_.push_back({ name, half ? PixelType::Half : PixelType::Float, std::move(bits) });
+}
+
+void ExrImage::AddChannel(const std::string& name, std::vector<uint32_t> values)
+{
+	channels_.push_back({ name, PixelType::UInt, std::move(values) });
+}
+
+void ExrImage::Save(const std::string& filename) const
+{
+	// The channels must be sorted by name, each scanline holds the values of one channel after the other.
+	std::vector<const Channel*> sorted;
+
+	for (const auto& channel : channels_)
+	{
+		if (channel.Values.size() != static_cast<size_t>(width_) * height_)
+		{
+			Throw(std::runtime_error("EXR channel '" + channel.Name + "' does not match the image size"));
+		}
+
+		sorted.push_back(&channel);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const Channel* a, const Channel* b) { return a->Name < b->Name; });
+
+	std::vector<char> channels;
+	for (const auto* const channel : sorted)
+	{
+		AppendString(channels, channel->Name);
+		Append(channels, channel->Type);
+		const auto linearAndSampling = Values(uint8_t(0), uint8_t(0), uint8_t(0), uint8_t(0), int32_t(1), int32_t(1));
+		channels.insert(channels.end(), linearAndSampling.begin(), linearAndSampling.end());
+	}
+	channels.push_back(0);
+
+	const uint32_t width = width_;
+	const uint32_t height = height_;
+	const int32_t maxX = static_cast<int32_t>(width) - 1;
+	const int32_t maxY = static_cast<int32_t>(height) - 1;
+
+	std::vector<char> header = Values(uint32_t(20000630), uint32_t(2));
+	AppendAttribute(header, "channels", "chlist", channels);
+	AppendAttribute(header, "compression", "compression", Values(uint8_t(1)));
+	AppendAttribute(header, "dataWindow", "box2i", Values(int32_t(0), int32_t(0), maxX, maxY));
+	AppendAttribute(header, "displayWindow", "box2i", Values(int32_t(0), int32_t(0), maxX, maxY));
+	AppendAttribute(header, "lineOrder", "lineOrder", Values(uint8_t(0)));
+	AppendAttribute(header, "pixelAspectRatio", "float", Values(1.0f));
+	AppendAttribute(header, "screenWindowCenter", "v2f", Values(0.0f, 0.0f));
+	AppendAttribute(header, "screenWindowWidth", "float", Values(1.0f));
+	header.push_back(0);
+
+	// One scanline per chunk, each one compressed by one of the threads.
+	std::vector<std::vector<char>> chunks(height);
+
+	const auto compressRows = [&](const uint32_t firstRow, const uint32_t rowStep)
+	{
+		std::vector<char> scanline;
+
+		for (uint32_t y = firstRow; y < height; y += rowStep)
+		{
+			scanline.clear();
+
+			for (const auto* const channel : sorted)
+			{
+				const uint32_t* const row = channel->Values.data() + static_cast<size_t>(y) * width;
+
+				for (uint32_t x = 0; x != width; ++x)
+				{
+					if (channel->Type == PixelType::Half)
+					{
+						float value;
+						std::memcpy(&value, &row[x], sizeof(value));
+						Append(scanline, ToHalf(value));
+					}
+					else
+					{
+						Append(scanline, row[x]);
+					}
+				}
+			}
+
+			// Chunks that do not get smaller are stored uncompressed.
+			std::vector<char> compressed = CompressRle(scanline);
+			std::vector<char>& chunk = chunks[y];
+			Append(chunk, static_cast<int32_t>(y));
+			Append(chunk, static_cast<int32_t>(std::min(compressed.size(), scanline.size())));
+			chunk.insert(chunk.end(),
+				compressed.size() < scanline.size() ? compressed.begin() : scanline.begin(),
+				compressed.size() < scanline.size() ? compressed.end() : scanline.end());
+		}
+	};
+
+	const uint32_t threadCount = std::max(1u, std::min(std::thread::hardware_concurrency(), height));
+	std::vector<std::thread> threads;
+
+	for (uint32_t i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back(compressRows, i, threadCount);
+	}
+
+	compressRows(0, threadCount);
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// The offset table gives the position of each chunk in the file.
+	uint64_t offset = header.size() + height * sizeof(uint64_t);
+	std::vector<char> offsets;
+
+	for (const auto& chunk : chunks)
+	{
+		Append(offsets, offset);
+		offset += chunk.size();
+	}
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+
+	file.write(header.data(), header.size());
+	file.write(offsets.data(), offsets.size());
+
+	for (const auto& chunk : chunks)
+	{
+		file.write(chunk.data(), chunk.size());
+	}
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to write '" + filename + "'"));
+	}
+}
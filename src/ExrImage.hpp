@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Linear high dynamic range output of the accumulation and of the first hit AOVs, for compositing and training
+// (see RayTracer::OnAccumulationSnapshot).
+class ExrImage final
+{
+public:
+
+	ExrImage(uint32_t width, uint32_t height);
+
+	// Divide the radiance sums of the accumulation by the sample count held in its alpha channel, into the R, G, B (half or
+	// float) channels, and add the sample counts as the SampleCount (float) channel.
+	void AddAccumulation(const std::vector<glm::vec4>& accumulation, bool half);
+
+	// Add a channel of floats (stored as half floats if asked) or of unsigned integers, one row after the other.
+	void AddChannel(const std::string& name, const std::vector<float>& values, bool half);
+	void AddChannel(const std::string& name, std::vector<uint32_t> values);
+
+	// Save as an OpenEXR scanline file. The scanlines are RLE compressed in parallel, as it is the only OpenEXR compression
+	// that does not need zlib.
+	void Save(const std::string& filename) const;
+
+private:
+
+	enum class PixelType : int32_t
+	{
+		UInt = 0,
+		Half = 1,
+		Float = 2
+	};
+
+	struct Channel final
+	{
+		std::string Name;
+		PixelType Type;
+		std::vector<uint32_t> Values; // bit patterns of the floats for the Half and Float channels
+	};
+
+	uint32_t width_;
+	uint32_t height_;
+	std::vector<Channel> channels_;
+};
@@ -0,0 +1,195 @@
+#include "JobRunner.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Exception.hpp"
+#include "Utilities/Halton.hpp"
+#include "Utilities/StbImage.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/SwapChain.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	double SecondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::chrono::seconds::period>(Clock::now() - start).count();
+	}
+}
+
+JobRunner::JobRunner(const UserSettings& userSettings, const std::vector<RenderJob>& jobs) :
+	Application(Vulkan::WindowConfig{ "Job Runner", jobs.front().Width, jobs.front().Height, false, false, false, false }, VK_PRESENT_MODE_IMMEDIATE_KHR),
+	userSettings_(userSettings),
+	jobs_(jobs)
+{
+}
+
+JobRunner::~JobRunner()
+{
+	if (HasSwapChain())
+	{
+		Device().WaitIdle();
+	}
+
+	scene_.reset();
+}
+
+void JobRunner::RunJobs()
+{
+	const auto queueStart = Clock::now();
+
+	for (size_t i = 0; i != jobs_.size(); ++i)
+	{
+		std::cout << "Job " << i + 1 << "/" << jobs_.size() << ": " << SceneList::AllScenes[jobs_[i].SceneIndex].first
+			<< ", " << jobs_[i].Width << "x" << jobs_[i].Height << ", " << jobs_[i].Samples << " spp, "
+			<< jobs_[i].Bounces << " bounces -> '" << jobs_[i].Output << "'" << std::endl;
+
+		RunJob(jobs_[i]);
+	}
+
+	std::cout << "Rendered " << jobs_.size() << " jobs in " << std::fixed << std::setprecision(2) << SecondsSince(queueStart) << "s" << std::endl;
+}
+
+Assets::UniformBufferObject JobRunner::GetUniformBufferObject(const VkExtent2D extent) const
+{
+	Assets::UniformBufferObject ubo = {};
+	ubo.ModelView = modelView_;
+	ubo.Projection = glm::perspective(glm::radians(fieldOfView_), extent.width / static_cast<float>(extent.height), 0.1f, 10000.0f);
+	ubo.Projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
+	ubo.ModelViewInverse = glm::inverse(ubo.ModelView);
+	ubo.ProjectionInverse = glm::inverse(ubo.Projection);
+	ubo.PreviousModelView = modelView_;
+	ubo.Aperture = cameraInitialSate_.Aperture;
+	ubo.FocusDistance = cameraInitialSate_.FocusDistance;
+	ubo.TotalNumberOfSamples = totalNumberOfSamples_;
+	ubo.NumberOfSamples = numberOfSamples_;
+	ubo.RandomSeed = 1;
+	ubo.Sampler = userSettings_.Sampler;
+	ubo.RussianRouletteDepth = userSettings_.RussianRouletteDepth;
+	ubo.MaxHistoryLength = userSettings_.MaxHistoryLength;
+	ubo.RenderWidth = RenderExtent().width;
+	ubo.RenderHeight = RenderExtent().height;
+	ubo.InterleaveRate = interleaveRate_;
+	ubo.PrimaryJitterX = Utilities::Halton(accumulatedFrames_, 2);
+	ubo.PrimaryJitterY = Utilities::Halton(accumulatedFrames_, 3);
+	ubo.HeatmapScale = userSettings_.HeatmapScale;
+
+	return ubo;
+}
+
+void JobRunner::OnDeviceSet()
+{
+	Application::OnDeviceSet();
+
+	const auto start = Clock::now();
+
+	LoadScene(jobs_.front().SceneIndex);
+	CreateAccelerationStructures();
+
+	sceneLoadTime_ = SecondsSince(start);
+}
+
+void JobRunner::CreateSwapChain()
+{
+	const auto start = Clock::now();
+
+	Application::CreateSwapChain();
+
+	setupTime_ += SecondsSince(start);
+}
+
+void JobRunner::LoadScene(const uint32_t sceneIndex)
+{
+	scene_ = SceneList::LoadScene(CommandPool(), sceneIndex, cameraInitialSate_, Assets::HostResidency::Release);
+	sceneIndex_ = sceneIndex;
+}
+
+void JobRunner::RunJob(const RenderJob& job)
+{
+	// Only rebuild what the job does not share with the previous one, the first job resources are created with the device.
+	const bool sceneChanged = job.SceneIndex != sceneIndex_;
+	const bool extentChanged = job.Width != offscreenExtent_.width || job.Height != offscreenExtent_.height;
+
+	if (sceneChanged || extentChanged)
+	{
+		Device().WaitIdle();
+		DeleteSwapChain();
+
+		if (sceneChanged)
+		{
+			const auto start = Clock::now();
+
+			DeleteAccelerationStructures();
+			LoadScene(job.SceneIndex);
+			CreateAccelerationStructures();
+
+			sceneLoadTime_ = SecondsSince(start);
+		}
+
+		offscreenExtent_ = VkExtent2D{ job.Width, job.Height };
+		CreateSwapChain();
+	}
+
+	modelView_ = job.HasCamera ? glm::lookAt(job.Eye, job.Target, glm::vec3(0, 1, 0)) : cameraInitialSate_.ModelView;
+	fieldOfView_ = job.FieldOfView > 0 ? job.FieldOfView : cameraInitialSate_.FieldOfView;
+
+	// Offline renders are traced by the plain engines at full resolution, without any of the interactive passes.
+	pipelineVariant_ = Vulkan::RayTracing::PipelineVariant{};
+	pipelineVariant_.NumberOfBounces = job.Bounces;
+	pipelineVariant_.HasSky = cameraInitialSate_.HasSky;
+	pipelineVariant_.NextEventEstimation = userSettings_.NextEventEstimation;
+	pipelineVariant_.RussianRoulette = userSettings_.RussianRoulette;
+
+	wavefront_ = userSettings_.Engine == 1;
+
+	// Trace the samples a few per frame, so that a single submission does not run long enough to trigger a device timeout.
+	const auto renderStart = Clock::now();
+	const uint32_t samplesPerFrame = std::max(userSettings_.NumberOfSamples, 1u);
+
+	totalNumberOfSamples_ = 0;
+	accumulatedFrames_ = 0;
+
+	while (totalNumberOfSamples_ != job.Samples)
+	{
+		numberOfSamples_ = std::min(job.Samples - totalNumberOfSamples_, samplesPerFrame);
+		totalNumberOfSamples_ += numberOfSamples_;
+		wavefrontSamples_ = numberOfSamples_;
+		accumulatedFrames_++;
+
+		DrawFrame();
+	}
+
+	Device().WaitIdle();
+
+	const double renderTime = SecondsSince(renderStart);
+	const auto saveStart = Clock::now();
+
+	SaveOutput(job);
+
+	const double saveTime = SecondsSince(saveStart);
+	const double samplesPerSecond = static_cast<double>(job.Width) * job.Height * job.Samples / renderTime;
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< "- scene: " << sceneLoadTime_ << "s" << (sceneLoadTime_ != 0 ? "" : " (cached)")
+		<< ", setup: " << setupTime_ << "s" << (setupTime_ != 0 ? "" : " (cached)")
+		<< ", render: " << renderTime << "s (" << accumulatedFrames_ << " frames, " << std::setprecision(2) << samplesPerSecond / 1000000 << " Msamples/s)"
+		<< ", save: " << std::setprecision(3) << saveTime << "s" << std::endl;
+
+	sceneLoadTime_ = 0;
+	setupTime_ = 0;
+}
+
+void JobRunner::SaveOutput(const RenderJob& job)
+{
+	const auto pixels = ReadOutputImage();
+
+	if (!stbi_write_png(job.Output.c_str(), static_cast<int>(job.Width), static_cast<int>(job.Height), 4, pixels.data(), static_cast<int>(job.Width * 4)))
+	{
+		Throw(std::runtime_error("failed to write job output '" + job.Output + "'"));
+	}
+}
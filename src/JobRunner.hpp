@@ -0,0 +1,55 @@
+#pragma once
+
+#include "RenderJob.hpp"
+#include "SceneList.hpp"
+#include "UserSettings.hpp"
+#include "Vulkan/RayTracing/Application.hpp"
+
+// Renders a queue of offline jobs one after the other in a hidden window (see RenderJob). The device, the pipelines and
+// their variants are kept for the whole queue, and so are the scene and its acceleration structures while consecutive jobs
+// share them. Only the swap chain is recreated when the resolution changes.
+class JobRunner final : public Vulkan::RayTracing::Application
+{
+public:
+
+	VULKAN_NON_COPIABLE(JobRunner)
+
+	JobRunner(const UserSettings& userSettings, const std::vector<RenderJob>& jobs);
+	~JobRunner();
+
+	// Render and save all the jobs, logging the time spent in each step of every job.
+	void RunJobs();
+
+protected:
+
+	const Assets::Scene& GetScene() const override { return *scene_; }
+	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override;
+
+	void OnDeviceSet() override;
+	void CreateSwapChain() override;
+
+private:
+
+	void LoadScene(uint32_t sceneIndex);
+	void RunJob(const RenderJob& job);
+	void SaveOutput(const RenderJob& job);
+
+	const UserSettings userSettings_;
+	const std::vector<RenderJob> jobs_;
+
+	uint32_t sceneIndex_{};
+	SceneList::CameraInitialSate cameraInitialSate_{};
+	std::unique_ptr<const Assets::Scene> scene_;
+
+	// Time spent loading the scene and building its acceleration structures, then creating the swap chain and the
+	// pipelines, since the last job was logged.
+	double sceneLoadTime_{};
+	double setupTime_{};
+
+	glm::mat4 modelView_{};
+	float fieldOfView_{};
+
+	uint32_t totalNumberOfSamples_{};
+	uint32_t numberOfSamples_{};
+	uint32_t accumulatedFrames_{};
+};
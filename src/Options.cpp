@@ -2,25 +2,47 @@
 #include "SceneList.hpp"
 #include "Utilities/Exception.hpp"
 #include <boost/program_options.hpp>
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 
 using namespace boost::program_options;
 
 Options::Options(const int argc, const char* argv[])
 {
 	const int lineLength = 120;
+	std::string aovs;
 	
 	options_description benchmark("Benchmark options", lineLength);
 	benchmark.add_options()
 		("next-scenes", bool_switch(&BenchmarkNextScenes)->default_value(false), "Load the next scene once the sample or time limit is reached.")
 		("max-time", value<uint32_t>(&BenchmarkMaxTime)->default_value(60), "The benchmark time limit per scene (in seconds).")
+		("compare-engines", bool_switch(&BenchmarkCompareEngines)->default_value(false), "Benchmark each scene with the megakernel engine, then again with the wavefront engine.")
+		("compare-samplers", bool_switch(&BenchmarkCompareSamplers)->default_value(false), "Trace each scene up to the sample limit with every sampler, then with 16 times more LCG samples as reference, and report the RMSE of each sampler (the time limit is ignored).")
 		;
 
 	options_description renderer("Renderer options", lineLength);
 	renderer.add_options()
+		("engine", value<uint32_t>(&Engine)->default_value(0), "The path tracing engine (0 = megakernel ray tracing pipeline, 1 = wavefront compute kernels with ray queries).")
+		("hybrid", bool_switch(&HybridPrimary)->default_value(false), "Rasterize the first hits and only ray trace the secondary bounces (megakernel engine, pinhole camera).")
+		("split-frame", bool_switch(&SplitFrame)->default_value(false), "Split the frames between all the visible devices (turns off the wavefront engine, hybrid mode, adaptive sampling, denoiser and reprojection).")
 		("samples", value<uint32_t>(&Samples)->default_value(8), "The number of ray samples per pixel.")
 		("bounces", value<uint32_t>(&Bounces)->default_value(16), "The maximum number of bounces per ray.")
 		("max-samples", value<uint32_t>(&MaxSamples)->default_value(64 * 1024), "The maximum number of accumulated ray samples per pixel.")
+		("nee", value<bool>(&NextEventEstimation)->default_value(true), "Explicitly sample the emissive triangles on diffuse surfaces (next event estimation).")
+		("sampler", value<uint32_t>(&Sampler)->default_value(0), "The sample generator (0 = LCG, 1 = Owen scrambled Sobol, 2 = blue noise rank-1 lattice).")
+		("adaptive", bool_switch(&AdaptiveSampling)->default_value(false), "Stop sampling the screen tiles whose estimated relative error is below the error target.")
+		("error-target", value<float>(&ErrorTarget)->default_value(0.02f), "The relative error target of adaptive sampling.")
+		("russian-roulette", value<bool>(&RussianRoulette)->default_value(true), "Randomly terminate the low throughput paths (unbiased).")
+		("roulette-depth", value<uint32_t>(&RussianRouletteDepth)->default_value(3), "The number of bounces before Russian roulette starts terminating paths.")
+		("denoise", bool_switch(&Denoise)->default_value(false), "Filter the output with an edge-avoiding a-trous wavelet denoiser.")
+		("denoiser-iterations", value<uint32_t>(&DenoiserIterations)->default_value(4), "The number of denoiser filter iterations (1 to 8).")
+		("reprojection", value<bool>(&TemporalReprojection)->default_value(true), "Reproject the accumulated samples when the camera moves, instead of restarting the accumulation.")
+		("history-length", value<uint32_t>(&MaxHistoryLength)->default_value(64), "The maximum number of samples per pixel kept by temporal reprojection.")
+		("interleave", value<uint32_t>(&InterleaveMode)->default_value(0), "The pixels traced per frame while the camera moves (0 = all, 1 = checkerboard, 2 = one in four).")
+		("render-scale", value<float>(&RenderScale)->default_value(1.0f), "The ratio of the ray traced resolution to the window resolution (0.25 to 1), the result is upscaled.")
+		("dynamic-resolution", bool_switch(&DynamicResolution)->default_value(false), "Adjust the render scale to hold the target frame time.")
+		("target-frame-time", value<float>(&TargetFrameTime)->default_value(16.7f), "The frame time targeted by dynamic resolution (in milliseconds).")
 		;
 
 	options_description scene("Scene options", lineLength);
@@ -28,6 +50,44 @@ Options::Options(const int argc, const char* argv[])
 		("scene", value<uint32_t>(&SceneIndex)->default_value(1), "The scene to start with.")
 		;
 
+	options_description batch("Batch options", lineLength);
+	batch.add_options()
+		("cameras", value<std::string>(&CameraFile), "Trace the views of all the cameras in this file at once ('eye target' positions, one camera per line), then save them once the sample limit is reached and exit.")
+		("batch-output", value<std::string>(&BatchOutput)->default_value("view"), "The file name prefix of the saved batch views (PNG).")
+		;
+
+	options_description checkpoint("Checkpoint options", lineLength);
+	checkpoint.add_options()
+		("checkpoint", value<std::string>(&CheckpointFile), "Periodically save the accumulated samples, camera and settings to this file (the resumed file by default, turns off split frame).")
+		("checkpoint-interval", value<float>(&CheckpointInterval)->default_value(300.0f), "The time between checkpoints (in seconds).")
+		("resume", value<std::string>(&ResumeFile), "Resume the render saved in this checkpoint file, with the same window size.")
+		;
+
+	options_description exr("EXR options", lineLength);
+	exr.add_options()
+		("exr", value<std::string>(&ExrFile)->default_value("render.exr"), "The file the linear accumulation (normalized, with the sample counts) is saved to when pressing F3 (turns off split frame when set).")
+		("exr-half", bool_switch(&ExrHalf)->default_value(false), "Save the EXR colors as half floats instead of floats.")
+		("exr-on-completion", bool_switch(&ExrOnCompletion)->default_value(false), "Also save the EXR file once the sample limit is reached (turns off split frame).")
+		("aovs", value<std::string>(&aovs), "Comma separated first hit AOVs saved in the EXR file (depth, normal, albedo, instance, material). Forces the megakernel engine without split frame.")
+		;
+
+	options_description jobs("Job options", lineLength);
+	jobs.add_options()
+		("jobs", value<std::string>(&JobFile), "Render the offline jobs of this file one after the other in a hidden window, then exit (one job per line, 'key=value' fields: scene, width, height, spp, bounces, eye=x,y,z, target=x,y,z, fov and output). The missing fields are taken from the command line.")
+		;
+
+	options_description distributed("Distributed options", lineLength);
+	distributed.add_options()
+		("distribute", bool_switch(&Distribute)->default_value(false), "Split the render of the scene (max-samples per pixel) between worker processes, then save it and exit.")
+		("workers", value<uint32_t>(&Workers)->default_value(2), "The number of local worker processes launched by the coordinator (more can be started by hand with --worker).")
+		("worker", bool_switch(&Worker)->default_value(false), "Run as a worker of the coordinator listening on the port, with the device picked by --visible-device and --worker-device.")
+		("worker-device", value<uint32_t>(&WorkerDevice)->default_value(0), "The index of the worker device among the suitable visible ones (set by the coordinator for its local workers).")
+		("port", value<uint32_t>(&Port)->default_value(41000), "The loopback port of the coordinator.")
+		("unit-rows", value<uint32_t>(&UnitRows)->default_value(64), "The number of rows of each unit of work.")
+		("unit-samples", value<uint32_t>(&UnitSamples)->default_value(64), "The number of samples per pixel of each unit of work.")
+		("distributed-output", value<std::string>(&DistributedOutput)->default_value("distributed.png"), "The file name of the distributed render (PNG).")
+		;
+
 	options_description vulkan("Vulkan options", lineLength);
 	vulkan.add_options()
 		("visible-device", value<std::vector<uint32_t>>(&VisibleDevices), "Explicitly set which Vulkan device ID is visible (can be repeated for multiple devices). If unspecified, all devices are visible.")
@@ -50,6 +110,11 @@ Options::Options(const int argc, const char* argv[])
 	desc.add(benchmark);
 	desc.add(renderer);
 	desc.add(scene);
+	desc.add(batch);
+	desc.add(checkpoint);
+	desc.add(exr);
+	desc.add(jobs);
+	desc.add(distributed);
 	desc.add(vulkan);
 	desc.add(window);
 
@@ -73,5 +138,140 @@ Options::Options(const int argc, const char* argv[])
 	{
 		Throw(std::out_of_range("invalid present mode"));
 	}
+
+	if (Engine > 1)
+	{
+		Throw(std::out_of_range("invalid engine"));
+	}
+
+	if (Sampler > 2)
+	{
+		Throw(std::out_of_range("invalid sampler"));
+	}
+
+	if (BenchmarkCompareSamplers && BenchmarkCompareEngines)
+	{
+		Throw(std::invalid_argument("--compare-samplers and --compare-engines cannot be combined"));
+	}
+
+	// The samplers are compared at the same number of samples on every pixel.
+	if (BenchmarkCompareSamplers && (AdaptiveSampling || SplitFrame || DynamicResolution))
+	{
+		Throw(std::invalid_argument("--compare-samplers cannot be combined with adaptive sampling, split frame nor dynamic resolution"));
+	}
+
+	if (ErrorTarget <= 0)
+	{
+		Throw(std::out_of_range("invalid error target"));
+	}
+
+	if (DenoiserIterations < 1 || DenoiserIterations > 8)
+	{
+		Throw(std::out_of_range("invalid denoiser iteration count"));
+	}
+
+	if (MaxHistoryLength == 0)
+	{
+		Throw(std::out_of_range("invalid history length"));
+	}
+
+	if (InterleaveMode > 2)
+	{
+		Throw(std::out_of_range("invalid interleave mode"));
+	}
+
+	if (RenderScale < 0.25f || RenderScale > 1.0f)
+	{
+		Throw(std::out_of_range("invalid render scale"));
+	}
+
+	if (TargetFrameTime <= 0)
+	{
+		Throw(std::out_of_range("invalid target frame time"));
+	}
+
+	// Same bits as PipelineVariant::AovBits.
+	const std::pair<std::string, uint32_t> aovBits[] = { {"depth", 1}, {"normal", 2}, {"albedo", 4}, {"instance", 8}, {"material", 16} };
+	std::istringstream aovList(aovs);
+
+	for (std::string aov; std::getline(aovList, aov, ',');)
+	{
+		const auto bit = std::find_if(std::begin(aovBits), std::end(aovBits), [&](const auto& entry) { return entry.first == aov; });
+
+		if (bit == std::end(aovBits))
+		{
+			Throw(std::invalid_argument("invalid AOV '" + aov + "'"));
+		}
+
+		AovMask |= bit->second;
+	}
+
+	if (CheckpointInterval < 0)
+	{
+		Throw(std::out_of_range("invalid checkpoint interval"));
+	}
+
+	if (CheckpointFile.empty())
+	{
+		CheckpointFile = ResumeFile;
+	}
+
+	if (Port == 0 || Port > 65535)
+	{
+		Throw(std::out_of_range("invalid port"));
+	}
+
+	if (UnitRows == 0 || UnitSamples == 0)
+	{
+		Throw(std::out_of_range("invalid unit size"));
+	}
+
+	// The peer devices only hand back the final colour (see PeerRenderer). Turn off what split frame cannot render, or
+	// split frame itself when the other options need the whole frame, rather than creating peers that are never used.
+	if (SplitFrame && (AovMask != 0 || !CameraFile.empty()))
+	{
+		SplitFrame = false;
+		std::cout << "Split frame: turned off, the AOVs and batch views are only traced by the presenting device" << std::endl;
+	}
+
+	if (SplitFrame && !CheckpointFile.empty())
+	{
+		SplitFrame = false;
+		std::cout << "Split frame: turned off, checkpoints save the accumulation of the presenting device only" << std::endl;
+	}
+
+	if (SplitFrame && (!vm["exr"].defaulted() || ExrOnCompletion))
+	{
+		SplitFrame = false;
+		std::cout << "Split frame: turned off, the EXR file saves the accumulation of the presenting device only" << std::endl;
+	}
+
+	if (SplitFrame)
+	{
+		std::string disabled;
+
+		const auto disable = [&disabled](bool& setting, const std::string& name)
+		{
+			if (setting)
+			{
+				disabled += (disabled.empty() ? "" : ", ") + name;
+				setting = false;
+			}
+		};
+
+		bool wavefront = Engine != 0;
+
+		disable(wavefront, "wavefront engine");
+		disable(HybridPrimary, "hybrid mode");
+		disable(AdaptiveSampling, "adaptive sampling");
+		disable(Denoise, "denoiser");
+		disable(TemporalReprojection, "temporal reprojection");
+		Engine = 0;
+
+		if (!disabled.empty())
+		{
+			std::cout << "Split frame: turned off " << disabled << std::endl;
+		}
+	}
 }
 
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <exception>
+#include <string>
 #include <vector>
 
 class Options final
@@ -24,16 +25,63 @@ public:
 	
 	// Benchmark options.
 	bool BenchmarkNextScenes{};
+	bool BenchmarkCompareEngines{};
+	bool BenchmarkCompareSamplers{};
 	uint32_t BenchmarkMaxTime{};
 
 	// Renderer options.
+	uint32_t Engine{};
+	bool HybridPrimary{};
+	bool SplitFrame{};
 	uint32_t Samples{};
 	uint32_t Bounces{};
 	uint32_t MaxSamples{};
+	bool NextEventEstimation{};
+	uint32_t Sampler{};
+	bool AdaptiveSampling{};
+	float ErrorTarget{};
+	bool RussianRoulette{};
+	uint32_t RussianRouletteDepth{};
+	bool Denoise{};
+	uint32_t DenoiserIterations{};
+	bool TemporalReprojection{};
+	uint32_t MaxHistoryLength{};
+	uint32_t InterleaveMode{};
+	float RenderScale{};
+	bool DynamicResolution{};
+	float TargetFrameTime{};
 
 	// Scene options.
 	uint32_t SceneIndex{};
 
+	// Batch options.
+	std::string CameraFile{};
+	std::string BatchOutput{};
+
+	// Checkpoint options.
+	std::string CheckpointFile{};
+	float CheckpointInterval{};
+	std::string ResumeFile{};
+
+	// EXR options.
+	std::string ExrFile{};
+	bool ExrHalf{};
+	bool ExrOnCompletion{};
+	uint32_t AovMask{}; // Vulkan::RayTracing::PipelineVariant::AovBits
+
+	// Job options.
+	std::string JobFile{};
+
+	// Distributed options.
+	bool Distribute{};
+	bool Worker{};
+	uint32_t WorkerDevice{};
+	uint32_t Workers{};
+	uint32_t Port{};
+	uint32_t UnitRows{};
+	uint32_t UnitSamples{};
+	std::string DistributedOutput{};
+
 	// Vulkan options
 	std::vector<uint32_t> VisibleDevices{};
 
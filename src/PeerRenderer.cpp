@@ -0,0 +1,99 @@
+#include "PeerRenderer.hpp"
+#include "SceneList.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/Scene.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/SwapChain.hpp"
+#include <cstring>
+
+PeerRenderer::PeerRenderer(const uint32_t sceneIndex, const Vulkan::WindowConfig& windowConfig) :
+	Application(windowConfig, VK_PRESENT_MODE_IMMEDIATE_KHR),
+	sceneIndex_(sceneIndex)
+{
+}
+
+PeerRenderer::~PeerRenderer()
+{
+	if (HasSwapChain())
+	{
+		Device().WaitIdle();
+	}
+
+	scene_.reset();
+}
+
+void PeerRenderer::LoadScene(const uint32_t sceneIndex)
+{
+	if (sceneIndex == sceneIndex_)
+	{
+		return;
+	}
+
+	Device().WaitIdle();
+	DeleteSwapChain();
+	DeleteAccelerationStructures();
+	CreateScene(sceneIndex);
+	CreateAccelerationStructures();
+	CreateSwapChain();
+
+	hasBand_ = false;
+}
+
+void PeerRenderer::RenderBand(
+	const Assets::UniformBufferObject& ubo,
+	const Vulkan::RayTracing::PipelineVariant& variant,
+	const float renderScale,
+	const FrameBand band)
+{
+	ubo_ = ubo;
+	ubo_.FirstRow = band.FirstRow;
+
+	pipelineVariant_ = variant;
+	renderScale_ = renderScale;
+	traceBand_ = band;
+	readBackBand_ = true;
+
+	DrawFrame();
+
+	hasBand_ = true;
+}
+
+void PeerRenderer::ReadBand(void* const destination)
+{
+	if (!hasBand_)
+	{
+		return;
+	}
+
+	Device().WaitIdle();
+
+	const auto rowPitch = BandBufferRowPitch();
+	const auto offset = traceBand_.FirstRow * rowPitch;
+	const auto size = traceBand_.RowCount * rowPitch;
+
+	const auto data = static_cast<const uint8_t*>(MapBandBuffer(lastFrame_));
+	std::memcpy(static_cast<uint8_t*>(destination) + offset, data + offset, size);
+	UnmapBandBuffer(lastFrame_);
+}
+
+void PeerRenderer::OnDeviceSet()
+{
+	Application::OnDeviceSet();
+
+	CreateScene(sceneIndex_);
+	CreateAccelerationStructures();
+}
+
+void PeerRenderer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
+{
+	lastFrame_ = currentFrame;
+
+	Application::Render(commandBuffer, currentFrame, imageIndex);
+}
+
+void PeerRenderer::CreateScene(const uint32_t sceneIndex)
+{
+	SceneList::CameraInitialSate cameraInitialState{};
+	scene_ = SceneList::LoadScene(CommandPool(), sceneIndex, cameraInitialState, Assets::HostResidency::Release);
+	sceneIndex_ = sceneIndex;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Assets/UniformBuffer.hpp"
+#include "Vulkan/RayTracing/Application.hpp"
+
+// Renders bands of the frame of the presenting RayTracer on another device, with its own copy of the scene and of the
+// acceleration structures. Its window is hidden and its frames are rendered offscreen, each traced band being read
+// back for the presenting device to upload into its own output image (see RayTracer::DrawFrame).
+class PeerRenderer final : public Vulkan::RayTracing::Application
+{
+public:
+
+	VULKAN_NON_COPIABLE(PeerRenderer)
+
+	PeerRenderer(uint32_t sceneIndex, const Vulkan::WindowConfig& windowConfig);
+	~PeerRenderer();
+
+	void LoadScene(uint32_t sceneIndex);
+
+	// Submit the rendering of the given band with the camera and the settings of the presenting device, without waiting.
+	void RenderBand(const Assets::UniformBufferObject& ubo, const Vulkan::RayTracing::PipelineVariant& variant, float renderScale, FrameBand band);
+
+	// Wait for the last band to be rendered, then copy its rows to the same rows of the destination output image copy.
+	void ReadBand(void* destination);
+
+	const FrameBand& Band() const { return traceBand_; }
+
+	using Vulkan::RayTracing::Application::TraceRowRate;
+
+protected:
+
+	const Assets::Scene& GetScene() const override { return *scene_; }
+	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override { return ubo_; }
+
+	void OnDeviceSet() override;
+	void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex) override;
+
+private:
+
+	void CreateScene(uint32_t sceneIndex);
+
+	uint32_t sceneIndex_{};
+	std::unique_ptr<const Assets::Scene> scene_;
+
+	Assets::UniformBufferObject ubo_{};
+	size_t lastFrame_{};
+	bool hasBand_{};
+};
@@ -1,30 +1,65 @@
 #include "RayTracer.hpp"
+#include "ExrImage.hpp"
+#include "PeerRenderer.hpp"
 #include "UserInterface.hpp"
 #include "UserSettings.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
-#include "Assets/Texture.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/Glm.hpp"
+#include "Utilities/Halton.hpp"
+#include "Utilities/StbImage.hpp"
 #include "Vulkan/Device.hpp"
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Window.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 namespace
 {
-	const bool EnableValidationLayers =
-#ifdef NDEBUG
-		false;
-#else
-		true;
-#endif
+	// Number of LCG samples per pixel of the --compare-samplers reference, relative to the sample limit.
+	const uint32_t SamplerReferenceFactor = 16;
+
+	// Root mean square error of the accumulated radiance, over all the colour channels.
+	double RootMeanSquareError(const std::vector<glm::vec4>& accumulation, const std::vector<glm::vec4>& reference)
+	{
+		double sum = 0;
+
+		for (size_t i = 0; i != accumulation.size(); ++i)
+		{
+			const glm::vec3 error = glm::vec3(accumulation[i]) / std::max(accumulation[i].a, 1.0f) - glm::vec3(reference[i]) / std::max(reference[i].a, 1.0f);
+			sum += glm::dot(error, error);
+		}
+
+		return std::sqrt(sum / (3.0 * std::max<size_t>(accumulation.size(), 1)));
+	}
+
+	std::array<uint8_t, VK_UUID_SIZE> DeviceUuid(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceIDProperties idProp{};
+		idProp.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 prop{};
+		prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		prop.pNext = &idProp;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &prop);
+
+		std::array<uint8_t, VK_UUID_SIZE> uuid{};
+		std::memcpy(uuid.data(), idProp.deviceUUID, VK_UUID_SIZE);
+		return uuid;
+	}
 }
 
 RayTracer::RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, const VkPresentModeKHR presentMode) :
-	Application(windowConfig, presentMode, EnableValidationLayers),
+	Application(windowConfig, presentMode),
 	userSettings_(userSettings)
 {
 	CheckFramebufferSize();
@@ -32,58 +67,117 @@ RayTracer::RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfi
 
 RayTracer::~RayTracer()
 {
+	peers_.clear();
 	scene_.reset();
 }
 
-Assets::UniformBufferObject RayTracer::GetUniformBufferObject(const VkExtent2D extent) const
+void RayTracer::AddPeerDevice(VkPhysicalDevice physicalDevice)
+{
+	// Each peer has its own Vulkan instance, so find its handle to the same physical device.
+	const auto uuid = DeviceUuid(physicalDevice);
+	const auto extent = SwapChain().Extent();
+
+	std::unique_ptr<PeerRenderer> peer(new PeerRenderer(sceneIndex_, Vulkan::WindowConfig{ "Peer Device", extent.width, extent.height, false, false, false, false }));
+
+	const auto& physicalDevices = peer->PhysicalDevices();
+	const auto result = std::find_if(physicalDevices.begin(), physicalDevices.end(), [&](VkPhysicalDevice device)
+	{
+		return DeviceUuid(device) == uuid;
+	});
+
+	if (result == physicalDevices.end())
+	{
+		Throw(std::runtime_error("cannot find the peer device in its own instance"));
+	}
+
+	static_cast<Vulkan::Application&>(*peer).SetPhysicalDevice(*result);
+
+	peers_.push_back(std::move(peer));
+	peerBandsPending_ = false;
+	resetAccumulation_ = true;
+
+	// The benchmark adds the devices one at a time, to report how the frame rate scales.
+	splitFrameDevices_ = userSettings_.Benchmark ? 1 : static_cast<uint32_t>(peers_.size()) + 1;
+}
+
+void RayTracer::SetBatchViews(const std::vector<glm::mat4>& modelViews, const std::string& outputPrefix)
+{
+	batchModelViews_ = modelViews;
+	batchOutputPrefix_ = outputPrefix;
+	userSettings_.BatchViews = static_cast<uint32_t>(modelViews.size());
+}
+
+void RayTracer::SetCheckpoint(const std::string& filename, const double interval, const std::string& resumeFilename)
+{
+	checkpointFilename_ = filename;
+	checkpointInterval_ = interval;
+
+	if (resumeFilename.empty())
+	{
+		return;
+	}
+
+	std::cout << "- resuming from '" << resumeFilename << "'... " << std::flush;
+
+	resumeCheckpoint_.reset(new Checkpoint(Checkpoint::Load(resumeFilename)));
+
+	if (resumeCheckpoint_->SceneIndex >= SceneList::AllScenes.size())
+	{
+		Throw(std::runtime_error("checkpoint scene index is out of range"));
+	}
+
+	// The scene is loaded with the device, the rest of the checkpoint is restored on the first frame.
+	userSettings_.SceneIndex = resumeCheckpoint_->SceneIndex;
+	checkpointSamples_ = resumeCheckpoint_->TotalNumberOfSamples;
+
+	std::cout << "(" << resumeCheckpoint_->TotalNumberOfSamples << " samples per pixel)" << std::endl;
+}
+
+void RayTracer::SetExrOutput(const std::string& filename, const bool half, const bool onCompletion)
 {
-	const auto& init = cameraInitialSate_;
+	exrFilename_ = filename;
+	exrHalf_ = half;
+	exrOnCompletion_ = onCompletion;
+}
 
+void RayTracer::SetAovs(const uint32_t aovMask)
+{
+	aovMask_ = aovMask;
+}
+
+Assets::UniformBufferObject RayTracer::GetUniformBufferObject(const VkExtent2D extent) const
+{
 	Assets::UniformBufferObject ubo = {};
 	ubo.ModelView = modelViewController_.ModelView();
 	ubo.Projection = glm::perspective(glm::radians(userSettings_.FieldOfView), extent.width / static_cast<float>(extent.height), 0.1f, 10000.0f);
 	ubo.Projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
 	ubo.ModelViewInverse = glm::inverse(ubo.ModelView);
 	ubo.ProjectionInverse = glm::inverse(ubo.Projection);
+	ubo.PreviousModelView = previousModelView_;
 	ubo.Aperture = userSettings_.Aperture;
 	ubo.FocusDistance = userSettings_.FocusDistance;
 	ubo.TotalNumberOfSamples = totalNumberOfSamples_;
 	ubo.NumberOfSamples = numberOfSamples_;
-	ubo.NumberOfBounces = userSettings_.NumberOfBounces;
 	ubo.RandomSeed = 1;
-	ubo.HasSky = init.HasSky;
-	ubo.ShowHeatmap = userSettings_.ShowHeatmap;
+	ubo.Sampler = userSettings_.Sampler;
+	ubo.AdaptiveSampling = userSettings_.AdaptiveSampling;
+	ubo.UpdateSampleBudgets = updateSampleBudgets_;
+	ubo.ErrorTarget = userSettings_.ErrorTarget;
+	ubo.RussianRouletteDepth = userSettings_.RussianRouletteDepth;
+	ubo.Reproject = reprojectAccumulation_;
+	ubo.MaxHistoryLength = userSettings_.MaxHistoryLength;
+	ubo.RenderWidth = RenderExtent().width;
+	ubo.RenderHeight = RenderExtent().height;
+	ubo.InterleaveRate = interleaveRate_;
+	ubo.InterleavePhase = interleavePhase_;
+	ubo.PrimaryJitterX = Utilities::Halton(accumulatedFrames_, 2);
+	ubo.PrimaryJitterY = Utilities::Halton(accumulatedFrames_, 3);
 	ubo.HeatmapScale = userSettings_.HeatmapScale;
+	ubo.FirstRow = traceBand_.FirstRow;
 
 	return ubo;
 }
 
-void RayTracer::SetPhysicalDevice(
-	VkPhysicalDevice physicalDevice, 
-	std::vector<const char*>& requiredExtensions,
-	VkPhysicalDeviceFeatures& deviceFeatures, 
-	void* nextDeviceFeatures)
-{
-	// Required extensions.
-	requiredExtensions.insert(requiredExtensions.end(),
-		{
-			// VK_KHR_SHADER_CLOCK is required for heatmap
-			VK_KHR_SHADER_CLOCK_EXTENSION_NAME
-		});
-	
-	// Opt-in into mandatory device features.
-	VkPhysicalDeviceShaderClockFeaturesKHR shaderClockFeatures = {};
-	shaderClockFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR;
-	shaderClockFeatures.pNext = nextDeviceFeatures;
-	shaderClockFeatures.shaderSubgroupClock = true;
-	
-	deviceFeatures.fillModeNonSolid = true;
-	deviceFeatures.samplerAnisotropy = true;
-	deviceFeatures.shaderInt64 = true;
-
-	Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &shaderClockFeatures);
-}
-
 void RayTracer::OnDeviceSet()
 {
 	Application::OnDeviceSet();
@@ -120,25 +214,159 @@ void RayTracer::DrawFrame()
 		LoadScene(userSettings_.SceneIndex);
 		CreateAccelerationStructures();
 		CreateSwapChain();
+
+		for (auto& peer : peers_)
+		{
+			peer->LoadScene(sceneIndex_);
+		}
+
+		peerBandsPending_ = false;
 		return;
 	}
 
+	// The batch views are traced by the plain megakernel, the passes needing the per-pixel buffers of a single view are off.
+	if (userSettings_.BatchViews != 0)
+	{
+		userSettings_.IsRayTraced = true;
+		userSettings_.Engine = 0;
+		userSettings_.HybridPrimary = false;
+		userSettings_.SplitFrame = false;
+		userSettings_.AdaptiveSampling = false;
+		userSettings_.Denoise = false;
+		userSettings_.TemporalReprojection = false;
+		userSettings_.InterleaveMode = 0;
+	}
+
+	// The first hit AOVs are only written by the megakernel, and only for the rows traced by the presenting device.
+	if (aovMask_ != 0)
+	{
+		userSettings_.Engine = 0;
+		userSettings_.SplitFrame = false;
+	}
+
+	// A render scale change resets the accumulation, so it has to happen before checking the settings.
+	UpdateRenderScale();
+
+	if (resumeCheckpoint_)
+	{
+		ResumeFromCheckpoint();
+	}
+
 	// Check if the accumulation buffer needs to be reset.
 	if (resetAccumulation_ || 
 		userSettings_.RequiresAccumulationReset(previousSettings_) || 
 		!userSettings_.AccumulateRays)
 	{
 		totalNumberOfSamples_ = 0;
+		accumulatedFrames_ = 0;
 		resetAccumulation_ = false;
+		batchViewsSaved_ = false;
 	}
 
 	previousSettings_ = userSettings_;
 
+	// The raster path and the hybrid mode need the procedural proxies, only create them the first time they are used.
+	if ((!userSettings_.IsRayTraced || userSettings_.UsesHybridPrimary()) && !GetScene().HasRasterProxies())
+	{
+		scene_->CreateRasterProxies(CommandPool());
+	}
+
+	// The heatmap is written straight to the output image, do not filter it.
+	denoise_ = userSettings_.Denoise && !userSettings_.ShowHeatmap;
+	denoiserIterations_ = userSettings_.DenoiserIterations;
+	renderScale_ = userSettings_.RenderScale;
+
+	// Switches compiled into the ray tracing shaders, changing them selects another pipeline variant.
+	pipelineVariant_.NumberOfBounces = userSettings_.NumberOfBounces;
+	pipelineVariant_.HasSky = cameraInitialSate_.HasSky;
+	pipelineVariant_.ShowHeatmap = userSettings_.ShowHeatmap;
+	pipelineVariant_.NextEventEstimation = userSettings_.NextEventEstimation;
+	pipelineVariant_.RussianRoulette = userSettings_.RussianRoulette;
+	pipelineVariant_.HybridPrimary = userSettings_.UsesHybridPrimary();
+	pipelineVariant_.BatchViews = userSettings_.BatchViews != 0;
+
+	batchViewShown_ = static_cast<uint32_t>(userSettings_.ShownBatchView);
+
+	wavefront_ = userSettings_.Engine == 1;
+
 	// Keep track of our sample count.
 	numberOfSamples_ = glm::clamp(userSettings_.MaxNumberOfSamples - totalNumberOfSamples_, 0u, userSettings_.NumberOfSamples);
+
+	// With adaptive sampling, stop once every tile has reached the error target. The tile count is read back a few frames
+	// late, so give the budgets a chance to be recomputed after a reset before trusting it.
+	if (userSettings_.AdaptiveSampling && accumulatedFrames_ > 8 && NumberOfActiveSampleTiles() == 0)
+	{
+		numberOfSamples_ = 0;
+	}
+
 	totalNumberOfSamples_ += numberOfSamples_;
+	wavefrontSamples_ = numberOfSamples_;
+
+	// The sample budgets are only re-estimated every few frames, in between the tiles keep their budget.
+	updateSampleBudgets_ = accumulatedFrames_ % 4 == 0;
+	accumulatedFrames_++;
+
+	// Snapshot the accumulation every so often, it is written to the checkpoint and EXR files on other threads once read back.
+	CollectCheckpoint();
+	CollectExr();
+
+	if (exrRequested_ && IsSplittingFrame())
+	{
+		exrRequested_ = false;
+		std::cout << "EXR: turn off split frame to save the accumulation" << std::endl;
+	}
+
+	const bool checkpoint = IsCheckpointDue();
+	const bool exr = IsExrDue();
+
+	if (checkpoint)
+	{
+		pendingCheckpoint_.reset();
+		checkpointTime_ = time_;
+	}
+
+	if (exr)
+	{
+		exrRequested_ = false;
+		exrPending_ = true;
+		exrSamples_ = totalNumberOfSamples_;
+	}
+
+	if (checkpoint || exr)
+	{
+		RequestAccumulationSnapshot();
+	}
 
 	Application::DrawFrame();
+
+	// Rendering the frame has updated the camera. The snapshot only matches it if the accumulation is not about to be reset
+	// nor has been reprojected.
+	if (checkpoint && IsAccumulationSnapshotPending() && !resetAccumulation_ && !reprojectAccumulation_)
+	{
+		pendingCheckpoint_.reset(new Checkpoint());
+		pendingCheckpoint_->SceneIndex = sceneIndex_;
+		pendingCheckpoint_->NumberOfBounces = userSettings_.NumberOfBounces;
+		pendingCheckpoint_->NextEventEstimation = userSettings_.NextEventEstimation;
+		pendingCheckpoint_->RussianRoulette = userSettings_.RussianRoulette;
+		pendingCheckpoint_->RussianRouletteDepth = userSettings_.RussianRouletteDepth;
+		pendingCheckpoint_->Sampler = userSettings_.Sampler;
+		pendingCheckpoint_->ModelView = modelViewController_.ModelView();
+		pendingCheckpoint_->FieldOfView = userSettings_.FieldOfView;
+		pendingCheckpoint_->Aperture = userSettings_.Aperture;
+		pendingCheckpoint_->FocusDistance = userSettings_.FocusDistance;
+		pendingCheckpoint_->TotalNumberOfSamples = totalNumberOfSamples_;
+		pendingCheckpoint_->AccumulatedFrames = accumulatedFrames_;
+		pendingCheckpoint_->RandomSeed = GetUniformBufferObject(SwapChain().Extent()).RandomSeed;
+	}
+
+	RenderPeerBands();
+
+	// The previous frames have traced all the samples, the batch views are complete.
+	if (userSettings_.BatchViews != 0 && numberOfSamples_ == 0 && !batchViewsSaved_)
+	{
+		SaveBatchViews();
+		Window().Close();
+	}
 }
 
 void RayTracer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
@@ -149,11 +377,29 @@ void RayTracer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame,
 	const auto timeDelta = time_ - prevTime;
 
 	// Update the camera position / angle.
-	resetAccumulation_ = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+	previousModelView_ = modelViewController_.ModelView();
+	const bool cameraMoved = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+
+	// With temporal reprojection, the samples accumulated in the previous view are carried over to this frame (see
+	// RayTracing.rgen), otherwise they are thrown away on the next one. The history length is clamped there too.
+	reprojectAccumulation_ = cameraMoved && userSettings_.UsesTemporalReprojection() && totalNumberOfSamples_ != numberOfSamples_;
+	resetAccumulation_ |= cameraMoved && !userSettings_.UsesTemporalReprojection();
+
+	// While moving, only trace a rotating subset of the pixels, and go back to all of them as soon as the camera stops.
+	interleaveRate_ = cameraMoved ? 1u << userSettings_.InterleaveMode : 1u;
+	interleavePhase_ += cameraMoved ? 1 : 0;
+
+	if (reprojectAccumulation_)
+	{
+		totalNumberOfSamples_ = std::min(totalNumberOfSamples_ - numberOfSamples_, userSettings_.MaxHistoryLength) + numberOfSamples_;
+		accumulatedFrames_ = 1;
+	}
 
 	// Check the current state of the benchmark, update it for the new frame.
 	CheckAndUpdateBenchmarkState(prevTime);
 
+	GatherPeerBands(currentFrame, cameraMoved);
+
 	// Render the scene
 	userSettings_.IsRayTraced
 		? Vulkan::RayTracing::Application::Render(commandBuffer, currentFrame, imageIndex)
@@ -166,13 +412,21 @@ void RayTracer::Render(VkCommandBuffer commandBuffer, const size_t currentFrame,
 
 	if (userSettings_.IsRayTraced)
 	{
-		const auto extent = SwapChain().Extent();
+		const auto extent = RenderExtent();
+
+		// Converged tiles do not trace any ray.
+		const double activeTiles = userSettings_.AdaptiveSampling
+			? double(NumberOfActiveSampleTiles()) / NumberOfSampleTiles()
+			: 1.0;
 
 		stats.RayRate = static_cast<float>(
-			double(extent.width*extent.height)*numberOfSamples_
+			double(extent.width*extent.height)*numberOfSamples_*activeTiles*std::max(1u, userSettings_.BatchViews)/interleaveRate_
 			/ (timeDelta * 1000000000));
 
 		stats.TotalSamples = totalNumberOfSamples_;
+		stats.ActiveTiles = static_cast<float>(activeTiles);
+		stats.MeanPathLength = MeanPathLength();
+		stats.RenderSize = extent;
 	}
 
 	userInterface_->Render(commandBuffer, SwapChainFrameBuffer(imageIndex), stats);
@@ -200,6 +454,7 @@ void RayTracer::OnKey(int key, int scancode, int action, int mods)
 			{
 			case GLFW_KEY_F1: userSettings_.ShowSettings = !userSettings_.ShowSettings; break;
 			case GLFW_KEY_F2: userSettings_.ShowOverlay = !userSettings_.ShowOverlay; break;
+			case GLFW_KEY_F3: exrRequested_ = true; break;
 			case GLFW_KEY_R: userSettings_.IsRayTraced = !userSettings_.IsRayTraced; break;
 			case GLFW_KEY_H: userSettings_.ShowHeatmap = !userSettings_.ShowHeatmap; break;
 			case GLFW_KEY_P: isWireFrame_ = !isWireFrame_; break;
@@ -211,7 +466,7 @@ void RayTracer::OnKey(int key, int scancode, int action, int mods)
 	// Camera motions
 	if (!userSettings_.Benchmark)
 	{
-		resetAccumulation_ |= modelViewController_.OnKey(key, scancode, action, mods);
+		resetAccumulation_ |= modelViewController_.OnKey(key, scancode, action, mods) && !userSettings_.UsesTemporalReprojection();
 	}
 }
 
@@ -226,7 +481,7 @@ void RayTracer::OnCursorPosition(const double xpos, const double ypos)
 	}
 
 	// Camera motions
-	resetAccumulation_ |= modelViewController_.OnCursorPosition(xpos, ypos);
+	resetAccumulation_ |= modelViewController_.OnCursorPosition(xpos, ypos) && !userSettings_.UsesTemporalReprojection();
 }
 
 void RayTracer::OnMouseButton(const int button, const int action, const int mods)
@@ -239,7 +494,7 @@ void RayTracer::OnMouseButton(const int button, const int action, const int mods
 	}
 
 	// Camera motions
-	resetAccumulation_ |= modelViewController_.OnMouseButton(button, action, mods);
+	resetAccumulation_ |= modelViewController_.OnMouseButton(button, action, mods) && !userSettings_.UsesTemporalReprojection();
 }
 
 void RayTracer::OnScroll(const double xoffset, const double yoffset)
@@ -260,18 +515,52 @@ void RayTracer::OnScroll(const double xoffset, const double yoffset)
 	resetAccumulation_ = prevFov != userSettings_.FieldOfView;
 }
 
-void RayTracer::LoadScene(const uint32_t sceneIndex)
+void RayTracer::OnAccumulationSnapshot(const VkExtent2D extent, std::vector<glm::vec4>&& accumulation, std::vector<float>&& variance, AovSnapshot&& aovs)
 {
-	auto [models, textures] = SceneList::AllScenes[sceneIndex].second(cameraInitialSate_);
+	if (exrPending_)
+	{
+		exrPending_ = false;
+
+		// The checkpoint below needs the accumulation too.
+		std::vector<glm::vec4> pixels = pendingCheckpoint_ ? std::vector<glm::vec4>(accumulation) : std::move(accumulation);
 
-	// If there are no texture, add a dummy one. It makes the pipeline setup a lot easier.
-	if (textures.empty())
+		exrWriter_ = std::async(std::launch::async,
+			[filename = exrFilename_, half = exrHalf_, aovMask = aovMask_, extent, pixels = std::move(pixels), aovs = std::move(aovs)]()
+		{
+			ExrImage image(extent.width, extent.height);
+			image.AddAccumulation(pixels, half);
+			AddAovChannels(image, aovs, aovMask, half);
+			image.Save(filename);
+		});
+	}
+
+	if (!pendingCheckpoint_)
 	{
-		textures.push_back(Assets::Texture::LoadTexture("../assets/textures/white.png", Vulkan::SamplerConfig()));
+		return;
 	}
-	
-	scene_.reset(new Assets::Scene(CommandPool(), std::move(models), std::move(textures)));
+
+	std::unique_ptr<Checkpoint> checkpoint = std::move(pendingCheckpoint_);
+	checkpoint->Width = extent.width;
+	checkpoint->Height = extent.height;
+	checkpoint->Accumulation = std::move(accumulation);
+	checkpoint->Variance = std::move(variance);
+	checkpoint->Hash = checkpoint->ComputeHash(sceneHash_);
+
+	checkpointSamples_ = checkpoint->TotalNumberOfSamples;
+	checkpointWriter_ = std::async(std::launch::async, [filename = checkpointFilename_, checkpoint = std::move(checkpoint)]()
+	{
+		checkpoint->Save(filename);
+	});
+}
+
+void RayTracer::LoadScene(const uint32_t sceneIndex)
+{
+	// Checkpoints are matched against the scene geometry, keep it on the host to hash it.
+	const bool hashScene = !checkpointFilename_.empty() || resumeCheckpoint_;
+
+	scene_ = SceneList::LoadScene(CommandPool(), sceneIndex, cameraInitialSate_, hashScene ? Assets::HostResidency::Keep : Assets::HostResidency::Release);
 	sceneIndex_ = sceneIndex;
+	sceneHash_ = hashScene ? Checkpoint::HashScene(*scene_) : 0;
 
 	userSettings_.FieldOfView = cameraInitialSate_.FieldOfView;
 	userSettings_.Aperture = cameraInitialSate_.Aperture;
@@ -283,6 +572,44 @@ void RayTracer::LoadScene(const uint32_t sceneIndex)
 	resetAccumulation_ = true;
 }
 
+void RayTracer::UpdateRenderScale()
+{
+	const double time = Window().GetTime();
+	const double frameTime = time - time_;
+
+	// Only adjust while the frames are actually tracing rays, a converged image costs next to nothing to display.
+	if (!userSettings_.DynamicResolution || !userSettings_.IsRayTraced || userSettings_.Benchmark || numberOfSamples_ == 0 || time_ == 0)
+	{
+		frameTimeAverage_ = 0;
+		renderScaleTime_ = time;
+		return;
+	}
+
+	frameTimeAverage_ = frameTimeAverage_ == 0 ? frameTime : glm::mix(frameTimeAverage_, frameTime, 0.1);
+
+	// Give the average a few frames to settle after each change, and leave some slack around the target so that the
+	// resolution does not oscillate (every change throws the accumulated samples away).
+	if (time - renderScaleTime_ < 0.25)
+	{
+		return;
+	}
+
+	renderScaleTime_ = time;
+
+	const double ratio = userSettings_.TargetFrameTime / (frameTimeAverage_ * 1000);
+
+	if (ratio > 0.9 && ratio < 1.1)
+	{
+		return;
+	}
+
+	// The ray tracing cost is proportional to the number of pixels, i.e. to the square of the scale.
+	const float scale = static_cast<float>(userSettings_.RenderScale * std::sqrt(ratio));
+	const float quantizedScale = std::round(scale * 16) / 16;
+
+	userSettings_.RenderScale = glm::clamp(quantizedScale, UserSettings::RenderScaleMinValue, UserSettings::RenderScaleMaxValue);
+}
+
 void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 {
 	if (!userSettings_.Benchmark)
@@ -295,10 +622,42 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 	{
 		std::cout << std::endl;
 		std::cout << "Benchmark: Start scene #" << sceneIndex_ << " '" << SceneList::AllScenes[sceneIndex_].first << "'" << std::endl;
+		std::cout << "Benchmark: Engine '" << UserSettings::EngineNames[userSettings_.Engine] << "'" << std::endl;
+		std::cout << "Benchmark: Sampler '" << UserSettings::SamplerNames[userSettings_.Sampler] << "'" << std::endl;
+
+		if (IsSplittingFrame())
+		{
+			std::cout << "Benchmark: Split frame over " << splitFrameDevices_ << " devices" << std::endl;
+		}
+
+		if (userSettings_.UsesHybridPrimary())
+		{
+			std::cout << "Benchmark: Hybrid (rasterized first hits, the mean path length only counts the traced rays)" << std::endl;
+		}
+
+		if (userSettings_.AdaptiveSampling)
+		{
+			std::cout << "Benchmark: Adaptive sampling (error target " << userSettings_.ErrorTarget << ")" << std::endl;
+		}
+
+		if (userSettings_.Denoise)
+		{
+			std::cout << "Benchmark: Denoiser (" << userSettings_.DenoiserIterations << " iterations)" << std::endl;
+		}
+
+		if (userSettings_.RenderScale != 1.0f)
+		{
+			const auto extent = RenderExtent();
+			std::cout << "Benchmark: Render scale " << userSettings_.RenderScale << " (" << extent.width << "x" << extent.height << ")" << std::endl;
+		}
+
 		sceneInitialTime_ = time_;
 		periodInitialTime_ = time_;
+		sceneTotalFrames_ = 0;
 	}
 
+	sceneTotalFrames_++;
+
 	// Print out the frame rate at regular intervals.
 	{
 		const double period = 5;
@@ -307,7 +666,7 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 		if (periodTotalFrames_ != 0 && static_cast<uint64_t>(prevTotalTime / period) != static_cast<uint64_t>(totalTime / period))
 		{
-			std::cout << "Benchmark: " << periodTotalFrames_ / totalTime << " fps" << std::endl;
+			std::cout << "Benchmark: " << periodTotalFrames_ / totalTime << " fps (mean path length " << MeanPathLength() << ")" << std::endl;
 			periodInitialTime_ = time_;
 			periodTotalFrames_ = 0;
 		}
@@ -317,11 +676,76 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 	// If in benchmark mode, bail out from the scene if we've reached the time or sample limit.
 	{
-		const bool timeLimitReached = periodTotalFrames_ != 0 && Window().GetTime() - sceneInitialTime_ > userSettings_.BenchmarkMaxTime;
+		const bool timeLimitReached = periodTotalFrames_ != 0 && Window().GetTime() - sceneInitialTime_ > userSettings_.BenchmarkMaxTime &&
+			!userSettings_.BenchmarkCompareSamplers;
 		const bool sampleLimitReached = numberOfSamples_ == 0;
+		const bool splitFrame = userSettings_.UsesSplitFrame() && !peers_.empty();
+
+		if ((timeLimitReached || sampleLimitReached) && splitFrame)
+		{
+			// Report how close the frame rate comes to scaling linearly with the number of devices.
+			const double frameRate = sceneTotalFrames_ / (time_ - sceneInitialTime_);
+
+			if (splitFrameDevices_ == 1)
+			{
+				singleDeviceFrameRate_ = frameRate;
+			}
+
+			std::cout << "Benchmark: " << splitFrameDevices_ << " device(s) " << frameRate << " fps, scaling efficiency "
+				<< 100 * frameRate / (splitFrameDevices_ * singleDeviceFrameRate_) << "%" << std::endl;
+		}
 
-		if (timeLimitReached || sampleLimitReached)
+		if ((timeLimitReached || sampleLimitReached) && splitFrame && splitFrameDevices_ != peers_.size() + 1)
 		{
+			// Run the same scene again from the start with one more device.
+			std::cout << std::endl;
+			splitFrameDevices_++;
+			modelViewController_.Reset(cameraInitialSate_.ModelView);
+			periodTotalFrames_ = 0;
+			resetAccumulation_ = true;
+		}
+		else if ((timeLimitReached || sampleLimitReached) && userSettings_.BenchmarkCompareEngines && userSettings_.Engine == 0)
+		{
+			// Run the same scene again from the start with the wavefront engine.
+			std::cout << std::endl;
+			userSettings_.Engine = 1;
+			splitFrameDevices_ = 1;
+			modelViewController_.Reset(cameraInitialSate_.ModelView);
+			periodTotalFrames_ = 0;
+			resetAccumulation_ = true;
+		}
+		else if (sampleLimitReached && userSettings_.BenchmarkCompareSamplers && samplerRuns_.size() != std::size(UserSettings::SamplerNames))
+		{
+			// Run the same scene again from the start with the next sampler, and after the last one with many more LCG
+			// samples as reference.
+			samplerRuns_.push_back(ReadAccumulationRows({ 0, RenderExtent().height }));
+			std::cout << std::endl;
+
+			if (samplerRuns_.size() != std::size(UserSettings::SamplerNames))
+			{
+				userSettings_.Sampler++;
+			}
+			else
+			{
+				std::cout << "Benchmark: Reference with " << SamplerReferenceFactor << "x more samples" << std::endl;
+				userSettings_.Sampler = 0;
+				userSettings_.MaxNumberOfSamples *= SamplerReferenceFactor;
+			}
+
+			modelViewController_.Reset(cameraInitialSate_.ModelView);
+			periodTotalFrames_ = 0;
+			resetAccumulation_ = true;
+		}
+		else if (timeLimitReached || sampleLimitReached)
+		{
+			if (userSettings_.BenchmarkCompareSamplers)
+			{
+				PrintSamplerErrors(ReadAccumulationRows({ 0, RenderExtent().height }));
+				userSettings_.MaxNumberOfSamples /= SamplerReferenceFactor;
+				userSettings_.Sampler = 0;
+				samplerRuns_.clear();
+			}
+
 			if (!userSettings_.BenchmarkNextScenes || static_cast<size_t>(userSettings_.SceneIndex) == SceneList::AllScenes.size() - 1)
 			{
 				Window().Close();
@@ -329,7 +753,32 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 			std::cout << std::endl;
 			userSettings_.SceneIndex += 1;
+			userSettings_.Engine = userSettings_.BenchmarkCompareEngines ? 0 : userSettings_.Engine;
+			splitFrameDevices_ = 1;
+		}
+	}
+}
+
+void RayTracer::PrintSamplerErrors(const std::vector<glm::vec4>& reference) const
+{
+	// All the runs trace the same camera at the same resolution, the errors are relative to the one of the LCG.
+	std::vector<double> errors;
+
+	for (const auto& run : samplerRuns_)
+	{
+		errors.push_back(run.size() == reference.size() ? RootMeanSquareError(run, reference) : 0);
+	}
+
+	for (size_t i = 0; i != errors.size(); ++i)
+	{
+		std::cout << "Benchmark: Sampler '" << UserSettings::SamplerNames[i] << "' RMSE " << errors[i];
+
+		if (errors[0] > 0)
+		{
+			std::cout << " (" << errors[i] / errors[0] << "x the LCG error)";
 		}
+
+		std::cout << std::endl;
 	}
 }
 
@@ -350,3 +799,300 @@ void RayTracer::CheckFramebufferSize() const
 		Throw(std::runtime_error(out.str()));
 	}
 }
+
+bool RayTracer::IsSplittingFrame() const
+{
+	// The peers render at the size of the window when they were added, stop splitting if it has been resized since.
+	return
+		splitFrameDevices_ > 1 &&
+		userSettings_.UsesSplitFrame() &&
+		peers_[0]->SwapChain().Extent().width == SwapChain().Extent().width &&
+		peers_[0]->SwapChain().Extent().height == SwapChain().Extent().height;
+}
+
+void RayTracer::GatherPeerBands(const size_t currentFrame, const bool cameraMoved)
+{
+	traceBand_ = {};
+	uploadBands_.clear();
+
+	// The peer bands lag one frame behind, so the presenting device traces the whole frame itself whenever they do not
+	// match the current view (i.e. after a reset, or while the camera is moving).
+	if (!peerBandsPending_ || accumulatedFrames_ <= 1 || cameraMoved || !IsSplittingFrame())
+	{
+		return;
+	}
+
+	void* const data = MapBandBuffer(currentFrame);
+
+	for (uint32_t i = 0; i != splitFrameDevices_ - 1; ++i)
+	{
+		peers_[i]->ReadBand(data);
+		uploadBands_.push_back(peers_[i]->Band());
+	}
+
+	UnmapBandBuffer(currentFrame);
+
+	traceBand_ = frameBands_[0];
+	peerBandsPending_ = false;
+}
+
+void RayTracer::RenderPeerBands()
+{
+	if (!IsSplittingFrame() || resetAccumulation_)
+	{
+		// The next frame starts over, whatever the peers would render now is never going to be used.
+		peerBandsPending_ = false;
+		return;
+	}
+
+	// The bands can only move when the accumulation starts over, as each device only accumulates its own rows.
+	if (accumulatedFrames_ == 1 || frameBands_.size() != splitFrameDevices_)
+	{
+		UpdateFrameBands();
+	}
+	else if (time_ - rebalanceTime_ > 1)
+	{
+		// Start over with new bands when the devices are taking noticeably different times to trace theirs.
+		double minTime = std::numeric_limits<double>::max();
+		double maxTime = 0;
+
+		for (uint32_t i = 0; i != splitFrameDevices_; ++i)
+		{
+			const double rate = i == 0 ? TraceRowRate() : peers_[i - 1]->TraceRowRate();
+			const double time = rate > 0 ? frameBands_[i].RowCount / rate : 0;
+
+			minTime = std::min(minTime, time);
+			maxTime = std::max(maxTime, time);
+		}
+
+		rebalanceTime_ = time_;
+
+		if (minTime > 0 && maxTime / minTime > 1.2)
+		{
+			resetAccumulation_ = true;
+			peerBandsPending_ = false;
+			return;
+		}
+	}
+
+	const auto ubo = GetUniformBufferObject(SwapChain().Extent());
+
+	for (uint32_t i = 1; i != splitFrameDevices_; ++i)
+	{
+		peers_[i - 1]->RenderBand(ubo, pipelineVariant_, renderScale_, frameBands_[i]);
+	}
+
+	peerBandsPending_ = true;
+}
+
+void RayTracer::UpdateFrameBands()
+{
+	// Give each device a number of rows proportional to how fast it traced them so far, evenly to begin with.
+	rowRates_.resize(splitFrameDevices_);
+
+	double totalRate = 0;
+
+	for (uint32_t i = 0; i != splitFrameDevices_; ++i)
+	{
+		const double rate = i == 0 ? TraceRowRate() : peers_[i - 1]->TraceRowRate();
+
+		if (rate > 0)
+		{
+			rowRates_[i] = rowRates_[i] > 0 ? glm::mix(rowRates_[i], rate, 0.5) : rate;
+		}
+		else if (rowRates_[i] <= 0)
+		{
+			rowRates_[i] = 1;
+		}
+
+		totalRate += rowRates_[i];
+	}
+
+	const uint32_t height = RenderExtent().height;
+	const uint32_t minRows = height >= splitFrameDevices_ ? 1 : 0;
+	uint32_t firstRow = 0;
+
+	frameBands_.resize(splitFrameDevices_);
+
+	for (uint32_t i = 0; i != splitFrameDevices_; ++i)
+	{
+		const uint32_t remainingBands = splitFrameDevices_ - i - 1;
+		const uint32_t remainingRows = height - firstRow;
+		const uint32_t rows = remainingBands == 0
+			? remainingRows
+			: std::clamp(static_cast<uint32_t>(std::lround(height * rowRates_[i] / totalRate)), minRows, remainingRows - remainingBands * minRows);
+
+		frameBands_[i] = { firstRow, rows };
+		firstRow += rows;
+	}
+
+	rebalanceTime_ = time_;
+}
+
+void RayTracer::SaveBatchViews()
+{
+	const auto extent = RenderExtent();
+	const auto pixels = ReadBatchViews();
+	const size_t viewSize = static_cast<size_t>(extent.width) * extent.height * 4;
+
+	for (uint32_t i = 0; i != userSettings_.BatchViews; ++i)
+	{
+		std::ostringstream filename;
+		filename << batchOutputPrefix_ << "_" << std::setw(3) << std::setfill('0') << i << ".png";
+
+		if (!stbi_write_png(filename.str().c_str(), static_cast<int>(extent.width), static_cast<int>(extent.height), 4, pixels.data() + i * viewSize, static_cast<int>(extent.width * 4)))
+		{
+			Throw(std::runtime_error("failed to write batch view '" + filename.str() + "'"));
+		}
+	}
+
+	std::cout << "Saved " << userSettings_.BatchViews << " batch views to '" << batchOutputPrefix_ << "_*.png' ("
+		<< totalNumberOfSamples_ << " samples per pixel)" << std::endl;
+
+	batchViewsSaved_ = true;
+}
+
+bool RayTracer::IsCheckpointDue() const
+{
+	// The accumulation of the presenting device has stale rows where the peers traced, do not save it while splitting.
+	if (checkpointFilename_.empty() || !userSettings_.IsRayTraced || userSettings_.BatchViews != 0 ||
+		IsAccumulationSnapshotPending() || checkpointWriter_.valid() || IsSplittingFrame())
+	{
+		return false;
+	}
+
+	// Every interval while the samples accumulate, and once more when the sample limit is reached.
+	return totalNumberOfSamples_ != checkpointSamples_ && (time_ - checkpointTime_ >= checkpointInterval_ || numberOfSamples_ == 0);
+}
+
+void RayTracer::CollectCheckpoint()
+{
+	if (!checkpointWriter_.valid() || checkpointWriter_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	// Rethrows the error of the writer thread, if any.
+	checkpointWriter_.get();
+
+	std::cout << "Saved checkpoint '" << checkpointFilename_ << "' (" << checkpointSamples_ << " samples per pixel)" << std::endl;
+}
+
+bool RayTracer::IsExrDue() const
+{
+	// Same as the checkpoints, the accumulation has stale rows where the peers traced.
+	if (exrFilename_.empty() || !userSettings_.IsRayTraced || userSettings_.BatchViews != 0 ||
+		IsAccumulationSnapshotPending() || exrWriter_.valid() || IsSplittingFrame())
+	{
+		return false;
+	}
+
+	return exrRequested_ || (exrOnCompletion_ && numberOfSamples_ == 0 && totalNumberOfSamples_ != exrSamples_);
+}
+
+void RayTracer::CollectExr()
+{
+	if (!exrWriter_.valid() || exrWriter_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return;
+	}
+
+	// Rethrows the error of the writer thread, if any.
+	exrWriter_.get();
+
+	std::cout << "Saved '" << exrFilename_ << "' (" << exrSamples_ << " samples per pixel)" << std::endl;
+}
+
+void RayTracer::AddAovChannels(ExrImage& image, const AovSnapshot& aovs, const uint32_t aovMask, const bool half)
+{
+	using Vulkan::RayTracing::PipelineVariant;
+
+	const auto addChannels = [&](const char* const names[], const std::vector<glm::vec4>& pixels, const int channelCount, const int firstChannel, const bool isHalf)
+	{
+		for (int c = 0; c != channelCount; ++c)
+		{
+			std::vector<float> values(pixels.size());
+			std::transform(pixels.begin(), pixels.end(), values.begin(), [=](const glm::vec4& pixel) { return pixel[firstChannel + c]; });
+			image.AddChannel(names[c], values, isHalf);
+		}
+	};
+
+	// Usual compositing channel names. The depth is kept in full precision.
+	const char* const normalNames[] = { "N.X", "N.Y", "N.Z" };
+	const char* const depthNames[] = { "Z" };
+	const char* const albedoNames[] = { "albedo.R", "albedo.G", "albedo.B" };
+
+	if (aovMask & PipelineVariant::AovNormal)
+	{
+		addChannels(normalNames, aovs.NormalDepth, 3, 0, half);
+	}
+
+	if (aovMask & PipelineVariant::AovDepth)
+	{
+		addChannels(depthNames, aovs.NormalDepth, 1, 3, false);
+	}
+
+	if (aovMask & PipelineVariant::AovAlbedo)
+	{
+		addChannels(albedoNames, aovs.Albedo, 3, 0, half);
+	}
+
+	const auto addIds = [&](const char* const name, const int index)
+	{
+		std::vector<uint32_t> ids(aovs.Ids.size());
+		std::transform(aovs.Ids.begin(), aovs.Ids.end(), ids.begin(), [=](const glm::uvec2& pixel) { return pixel[index]; });
+		image.AddChannel(name, std::move(ids));
+	};
+
+	if (aovMask & PipelineVariant::AovInstanceId)
+	{
+		addIds("instanceId", 0);
+	}
+
+	if (aovMask & PipelineVariant::AovMaterialId)
+	{
+		addIds("materialId", 1);
+	}
+}
+
+void RayTracer::ResumeFromCheckpoint()
+{
+	const std::unique_ptr<Checkpoint> checkpoint = std::move(resumeCheckpoint_);
+
+	userSettings_.IsRayTraced = true;
+	userSettings_.AccumulateRays = true;
+	userSettings_.NumberOfBounces = checkpoint->NumberOfBounces;
+	userSettings_.NextEventEstimation = checkpoint->NextEventEstimation;
+	userSettings_.RussianRoulette = checkpoint->RussianRoulette;
+	userSettings_.RussianRouletteDepth = checkpoint->RussianRouletteDepth;
+	userSettings_.Sampler = checkpoint->Sampler;
+	userSettings_.FieldOfView = checkpoint->FieldOfView;
+	userSettings_.Aperture = checkpoint->Aperture;
+	userSettings_.FocusDistance = checkpoint->FocusDistance;
+
+	modelViewController_.Reset(checkpoint->ModelView);
+	renderScale_ = userSettings_.RenderScale;
+
+	const auto extent = RenderExtent();
+
+	if (checkpoint->Width != extent.width || checkpoint->Height != extent.height)
+	{
+		Throw(std::runtime_error("checkpoint was rendered at " + std::to_string(checkpoint->Width) + "x" + std::to_string(checkpoint->Height) +
+			", not at " + std::to_string(extent.width) + "x" + std::to_string(extent.height)));
+	}
+
+	if (checkpoint->ComputeHash(sceneHash_) != checkpoint->Hash)
+	{
+		Throw(std::runtime_error("checkpoint does not match the scene"));
+	}
+
+	RestoreAccumulation(checkpoint->Accumulation, checkpoint->Variance);
+
+	totalNumberOfSamples_ = checkpoint->TotalNumberOfSamples;
+	accumulatedFrames_ = checkpoint->AccumulatedFrames;
+
+	// The restored settings are the ones the accumulation was traced with, do not reset it.
+	resetAccumulation_ = false;
+	previousSettings_ = userSettings_;
+	checkpointTime_ = time_;
+}
@@ -1,9 +1,11 @@
 #pragma once
 
+#include "Checkpoint.hpp"
 #include "ModelViewController.hpp"
 #include "SceneList.hpp"
 #include "UserSettings.hpp"
 #include "Vulkan/RayTracing/Application.hpp"
+#include <future>
 
 class RayTracer final : public Vulkan::RayTracing::Application
 {
@@ -14,22 +16,36 @@ public:
 	RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, VkPresentModeKHR presentMode);
 	~RayTracer();
 
+	// Render bands of the frames on another device too, once the presenting device has been set (see PeerRenderer).
+	void AddPeerDevice(VkPhysicalDevice physicalDevice);
+
+	// Trace the views of all these cameras in every frame, before the device is set. They are saved as PNG files once the
+	// sample limit is reached, and the application then exits (see BatchCameras).
+	void SetBatchViews(const std::vector<glm::mat4>& modelViews, const std::string& outputPrefix);
+
+	// Save a checkpoint of the accumulation to this file every interval (in seconds), and once more when the sample limit
+	// is reached. Before the device is set, also resume the render from the given checkpoint if any (see Checkpoint).
+	void SetCheckpoint(const std::string& filename, double interval, const std::string& resumeFilename);
+
+	// Save the linear accumulation, normalized by the sample counts, to this EXR file when F3 is pressed, and once the
+	// sample limit is reached if asked (see ExrImage).
+	void SetExrOutput(const std::string& filename, bool half, bool onCompletion);
+
+	// Before the device is set, select the first hit AOVs written in the trace pass and saved as extra channels of the EXR
+	// file (see Vulkan::RayTracing::PipelineVariant::AovBits).
+	void SetAovs(uint32_t aovMask);
+
 protected:
 
 	const Assets::Scene& GetScene() const override { return *scene_; }
 	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override;
 
-	void SetPhysicalDevice(
-		VkPhysicalDevice physicalDevice, 
-		std::vector<const char*>& requiredExtensions, 
-		VkPhysicalDeviceFeatures& deviceFeatures, 
-		void* nextDeviceFeatures) override;
-
 	void OnDeviceSet() override;
 	void CreateSwapChain() override;
 	void DeleteSwapChain() override;
 	void DrawFrame() override;
 	void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex) override;
+	void OnAccumulationSnapshot(VkExtent2D extent, std::vector<glm::vec4>&& accumulation, std::vector<float>&& variance, AovSnapshot&& aovs) override;
 
 	void OnKey(int key, int scancode, int action, int mods) override;
 	void OnCursorPosition(double xpos, double ypos) override;
@@ -39,26 +55,86 @@ protected:
 private:
 
 	void LoadScene(uint32_t sceneIndex);
+	void UpdateRenderScale();
 	void CheckAndUpdateBenchmarkState(double prevTime);
+	void PrintSamplerErrors(const std::vector<glm::vec4>& reference) const;
 	void CheckFramebufferSize() const;
 
+	bool IsSplittingFrame() const;
+	void GatherPeerBands(size_t currentFrame, bool cameraMoved);
+	void RenderPeerBands();
+	void UpdateFrameBands();
+	void SaveBatchViews();
+
+	bool IsCheckpointDue() const;
+	void CollectCheckpoint();
+	void ResumeFromCheckpoint();
+
+	bool IsExrDue() const;
+	void CollectExr();
+	static void AddAovChannels(class ExrImage& image, const AovSnapshot& aovs, uint32_t aovMask, bool half);
+
 	uint32_t sceneIndex_{};
 	UserSettings userSettings_{};
 	UserSettings previousSettings_{};
 	SceneList::CameraInitialSate cameraInitialSate_{};
 	ModelViewController modelViewController_{};
+	glm::mat4 previousModelView_{};
 
 	std::unique_ptr<const Assets::Scene> scene_;
 	std::unique_ptr<class UserInterface> userInterface_;
 
 	double time_{};
 
+	// Dynamic resolution
+	double frameTimeAverage_{};
+	double renderScaleTime_{};
+
 	uint32_t totalNumberOfSamples_{};
 	uint32_t numberOfSamples_{};
+	uint32_t accumulatedFrames_{};
+	bool updateSampleBudgets_{};
+	uint32_t interleavePhase_{};
 	bool resetAccumulation_{};
 
+	// Split-frame rendering, the first band is traced by the presenting device and the others by the peers.
+	std::vector<std::unique_ptr<class PeerRenderer>> peers_;
+	std::vector<FrameBand> frameBands_;
+	std::vector<double> rowRates_;
+	double rebalanceTime_{};
+	bool peerBandsPending_{};
+	uint32_t splitFrameDevices_{1};
+
+	// Batch views output.
+	std::string batchOutputPrefix_;
+	bool batchViewsSaved_{};
+
+	// Checkpoints, the pending one holds the state of the frame whose accumulation snapshot is being read back.
+	std::string checkpointFilename_;
+	double checkpointInterval_{};
+	double checkpointTime_{};
+	uint32_t checkpointSamples_{};
+	uint64_t sceneHash_{};
+	std::unique_ptr<Checkpoint> pendingCheckpoint_;
+	std::unique_ptr<Checkpoint> resumeCheckpoint_;
+	std::future<void> checkpointWriter_;
+
+	// EXR output, read back from the accumulation snapshot like the checkpoints.
+	std::string exrFilename_;
+	bool exrHalf_{};
+	bool exrOnCompletion_{};
+	bool exrRequested_{};
+	bool exrPending_{};
+	uint32_t exrSamples_{};
+	std::future<void> exrWriter_;
+
 	// Benchmark stats
 	double sceneInitialTime_{};
 	double periodInitialTime_{};
 	uint32_t periodTotalFrames_{};
+	uint32_t sceneTotalFrames_{};
+	double singleDeviceFrameRate_{};
+
+	// Accumulation of each sampler run of --compare-samplers, the last run traces the reference.
+	std::vector<std::vector<glm::vec4>> samplerRuns_;
 };
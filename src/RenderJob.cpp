@@ -0,0 +1,124 @@
+#include "RenderJob.hpp"
+#include "SceneList.hpp"
+#include "Utilities/Exception.hpp"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	template <class T>
+	bool ParseValue(const std::string& text, T& value)
+	{
+		std::istringstream stream(text);
+		return (stream >> value) && stream.eof();
+	}
+
+	bool ParseVector(const std::string& text, glm::vec3& value)
+	{
+		std::istringstream stream(text);
+		char separator0{}, separator1{};
+
+		return (stream >> value.x >> separator0 >> value.y >> separator1 >> value.z) && stream.eof() && separator0 == ',' && separator1 == ',';
+	}
+}
+
+std::vector<RenderJob> RenderJob::LoadQueue(const std::string& filename, const RenderJob& defaults)
+{
+	std::cout << "- loading '" << filename << "'... " << std::flush;
+
+	std::ifstream file(filename);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("failed to open job file '" + filename + "'"));
+	}
+
+	std::vector<RenderJob> jobs;
+	std::string line;
+	size_t lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+
+		const auto first = line.find_first_not_of(" \t\r");
+
+		if (first == std::string::npos || line[first] == '#')
+		{
+			continue;
+		}
+
+		const auto error = [&](const std::string& message)
+		{
+			Throw(std::runtime_error(message + " on line " + std::to_string(lineNumber) + " of '" + filename + "'"));
+		};
+
+		RenderJob job = defaults;
+		job.Output.clear();
+
+		std::istringstream stream(line);
+		std::string field;
+
+		while (stream >> field)
+		{
+			const auto equal = field.find('=');
+
+			if (equal == std::string::npos)
+			{
+				error("invalid job field '" + field + "'");
+			}
+
+			const auto key = field.substr(0, equal);
+			const auto value = field.substr(equal + 1);
+			bool valid = true;
+
+			if (key == "scene") valid = ParseValue(value, job.SceneIndex);
+			else if (key == "width") valid = ParseValue(value, job.Width);
+			else if (key == "height") valid = ParseValue(value, job.Height);
+			else if (key == "spp") valid = ParseValue(value, job.Samples);
+			else if (key == "bounces") valid = ParseValue(value, job.Bounces);
+			else if (key == "eye") valid = ParseVector(value, job.Eye);
+			else if (key == "target") valid = ParseVector(value, job.Target);
+			else if (key == "fov") valid = ParseValue(value, job.FieldOfView);
+			else if (key == "output") job.Output = value;
+			else error("unknown job field '" + key + "'");
+
+			if (!valid)
+			{
+				error("invalid value for job field '" + key + "'");
+			}
+
+			job.HasCamera |= key == "eye" || key == "target";
+		}
+
+		if (job.SceneIndex >= SceneList::AllScenes.size())
+		{
+			error("scene index out of range");
+		}
+
+		if (job.Width == 0 || job.Height == 0 || job.Samples == 0)
+		{
+			error("empty job");
+		}
+
+		if (job.Output.empty())
+		{
+			std::ostringstream output;
+			output << "job_" << std::setw(3) << std::setfill('0') << jobs.size() << ".png";
+			job.Output = output.str();
+		}
+
+		jobs.push_back(job);
+	}
+
+	if (jobs.empty())
+	{
+		Throw(std::runtime_error("no job in '" + filename + "'"));
+	}
+
+	std::cout << "(" << jobs.size() << " jobs)" << std::endl;
+
+	return jobs;
+}
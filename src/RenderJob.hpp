@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Utilities/Glm.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// An offline render of the job queue (see JobRunner).
+struct RenderJob final
+{
+	uint32_t SceneIndex;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Samples; // samples per pixel
+	uint32_t Bounces;
+
+	// The scene initial camera is used unless the job has its own eye and target, and its field of view is zero.
+	bool HasCamera;
+	glm::vec3 Eye;
+	glm::vec3 Target;
+	float FieldOfView;
+
+	std::string Output; // PNG file name
+
+	// Each line of the file is a job made of 'key=value' fields separated by spaces (scene, width, height, spp, bounces,
+	// eye=x,y,z, target=x,y,z, fov and output), lines starting with '#' are comments. The missing fields are taken from the
+	// given defaults, and the output defaults to 'job_NNN.png'.
+	static std::vector<RenderJob> LoadQueue(const std::string& filename, const RenderJob& defaults);
+};
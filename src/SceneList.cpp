@@ -1,6 +1,7 @@
 #include "SceneList.hpp"
 #include "Assets/Material.hpp"
 #include "Assets/Model.hpp"
+#include "Assets/Scene.hpp"
 #include "Assets/Texture.hpp"
 #include <functional>
 #include <random>
@@ -70,6 +71,20 @@ const std::vector<std::pair<std::string, std::function<SceneAssets (SceneList::C
 	{"Cornell Box & Lucy", CornellBoxLucy},
 };
 
+std::unique_ptr<Assets::Scene> SceneList::LoadScene(
+	Vulkan::CommandPool& commandPool, const uint32_t sceneIndex, CameraInitialSate& camera, const Assets::HostResidency residency)
+{
+	auto [models, textures] = AllScenes[sceneIndex].second(camera);
+
+	// If there are no texture, add a dummy one. It makes the pipeline setup a lot easier.
+	if (textures.empty())
+	{
+		textures.push_back(Texture::LoadTexture("../assets/textures/white.png", Vulkan::SamplerConfig()));
+	}
+
+	return std::make_unique<Assets::Scene>(commandPool, std::move(models), std::move(textures), residency);
+}
+
 SceneAssets SceneList::CubeAndSpheres(CameraInitialSate& camera)
 {
 	// Basic test scene.
@@ -1,16 +1,24 @@
 #pragma once
 #include "Utilities/Glm.hpp"
 #include <functional>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
 
 namespace Assets
 {
+	enum class HostResidency;
 	class Model;
+	class Scene;
 	class Texture;
 }
 
+namespace Vulkan
+{
+	class CommandPool;
+}
+
 typedef std::tuple<std::vector<Assets::Model>, std::vector<Assets::Texture>> SceneAssets;
 
 class SceneList final
@@ -36,4 +44,8 @@ public:
 	static SceneAssets CornellBoxLucy(CameraInitialSate& camera);
 
 	static const std::vector<std::pair<std::string, std::function<SceneAssets (CameraInitialSate&)>>> AllScenes;
+
+	// Generate the given scene and upload it to the GPU. The scenes use a fixed seed, so every device gets the same one.
+	static std::unique_ptr<Assets::Scene> LoadScene(
+		Vulkan::CommandPool& commandPool, uint32_t sceneIndex, CameraInitialSate& camera, Assets::HostResidency residency);
 };
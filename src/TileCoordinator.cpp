@@ -0,0 +1,396 @@
+#include "TileCoordinator.hpp"
+#include "Utilities/Exception.hpp"
+#include "Utilities/StbImage.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace
+{
+	double SecondsSince(const std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+}
+
+TileCoordinator::TileCoordinator(const TileProtocol::Setup& setup, const uint32_t samples, const uint32_t unitRows, const uint32_t unitSamples) :
+	setup_(setup),
+	accumulation_(static_cast<size_t>(setup.Width) * setup.Height)
+{
+	const uint32_t rows = std::max(unitRows, 1u);
+	const uint32_t rangeSamples = std::max(unitSamples, 1u);
+
+	// Sample ranges first, so that the whole frame gets its first samples before any row gets more.
+	for (uint32_t firstSample = 0; firstSample < samples; firstSample += rangeSamples)
+	{
+		for (uint32_t firstRow = 0; firstRow < setup.Height; firstRow += rows)
+		{
+			UnitState state{};
+			state.Unit.Id = static_cast<uint32_t>(units_.size());
+			state.Unit.FirstRow = firstRow;
+			state.Unit.RowCount = std::min(rows, setup.Height - firstRow);
+			state.Unit.FirstSample = firstSample;
+			state.Unit.SampleCount = std::min(rangeSamples, samples - firstSample);
+
+			pendingUnits_.push_back(state.Unit.Id);
+			units_.push_back(state);
+		}
+	}
+
+	remainingUnits_ = units_.size();
+}
+
+TileCoordinator::~TileCoordinator()
+{
+}
+
+void TileCoordinator::Run(const std::string& executable, const uint32_t localWorkers, const std::vector<uint32_t>& visibleDevices, const uint32_t localDevices, const uint16_t port)
+{
+	using boost::asio::ip::tcp;
+
+	boost::asio::io_context context;
+	tcp::acceptor acceptor(context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+	acceptor.non_blocking(true);
+
+	std::cout << "Distributing " << units_.size() << " units (" << setup_.Width << "x" << setup_.Height << ") on port " << port << std::endl;
+
+	// The launcher threads may outlive the coordinator if a worker hangs, they only share the count of running launches.
+	const auto launchingWorkers = std::make_shared<std::atomic<uint32_t>>(localWorkers);
+	std::string command = "\"" + executable + "\" --worker --port " + std::to_string(port);
+
+	// The workers pick their device by index among the same visible devices as the coordinator.
+	for (const auto device : visibleDevices)
+	{
+		command += " --visible-device " + std::to_string(device);
+	}
+
+	for (uint32_t i = 0; i != localWorkers; ++i)
+	{
+		const uint32_t device = localDevices != 0 ? i % localDevices : 0;
+
+		std::cout << "Launching worker " << i << " on device " << device << std::endl;
+
+		std::thread([command = command + " --worker-device " + std::to_string(device), launchingWorkers]()
+		{
+			std::system(command.c_str());
+			--*launchingWorkers;
+		}).detach();
+	}
+
+	const auto start = Clock::now();
+
+	std::vector<std::unique_ptr<TileProtocol::Socket>> sockets;
+	std::vector<std::thread> threads;
+
+	for (;;)
+	{
+		boost::system::error_code error;
+		tcp::socket socket(context);
+		acceptor.accept(socket, error);
+
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		if (!error)
+		{
+			workers_.push_back(WorkerStats{ "unknown device", 0, 0, 0, 0, false, false });
+			activeWorkers_++;
+
+			sockets.emplace_back(new TileProtocol::Socket(std::move(socket)));
+			threads.emplace_back(&TileCoordinator::ServeWorker, this, std::ref(*sockets.back()), workers_.size() - 1);
+		}
+
+		if (remainingUnits_ == 0)
+		{
+			finished_ = true;
+			break;
+		}
+
+		// Workers started by hand may connect at any time, but give up once every known worker is gone.
+		if (activeWorkers_ == 0 && *launchingWorkers == 0 && (!threads.empty() || localWorkers != 0))
+		{
+			lock.unlock();
+
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+
+			Throw(std::runtime_error("all the workers have failed"));
+		}
+
+		condition_.wait_for(lock, std::chrono::milliseconds(50));
+	}
+
+	const double time = SecondsSince(start);
+
+	// Each worker thread tells its worker to quit and closes its own socket. The only exception are the workers still
+	// busy with a duplicated unit, whose blocked reads are cut off from here rather than waiting for a result nobody
+	// needs. Holding the lock guarantees their thread has not closed the socket yet (see CompleteUnit and FailUnit).
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		for (size_t i = 0; i != sockets.size(); ++i)
+		{
+			if (workers_[i].Busy)
+			{
+				sockets[i]->Shutdown();
+			}
+		}
+
+		condition_.notify_all();
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	PrintStats(time);
+}
+
+void TileCoordinator::Save(const std::string& filename) const
+{
+	std::vector<uint8_t> pixels(accumulation_.size() * 4);
+
+	for (size_t i = 0; i != accumulation_.size(); ++i)
+	{
+		// Same average and gamma correction as RayTracing.rgen.
+		const glm::vec4& sum = accumulation_[i];
+		const glm::vec3 color = glm::sqrt(glm::vec3(sum) / std::max(sum.a, 1.0f));
+
+		for (int c = 0; c != 3; ++c)
+		{
+			pixels[i * 4 + c] = static_cast<uint8_t>(std::lround(glm::clamp(color[c], 0.0f, 1.0f) * 255));
+		}
+
+		pixels[i * 4 + 3] = 255;
+	}
+
+	if (!stbi_write_png(filename.c_str(), static_cast<int>(setup_.Width), static_cast<int>(setup_.Height), 4, pixels.data(), static_cast<int>(setup_.Width * 4)))
+	{
+		Throw(std::runtime_error("failed to write distributed render '" + filename + "'"));
+	}
+
+	std::cout << "Saved distributed render to '" << filename << "'" << std::endl;
+}
+
+void TileCoordinator::ServeWorker(TileProtocol::Socket& socket, const size_t workerIndex)
+{
+	TileProtocol::Unit unit{};
+	bool hasUnit = false;
+
+	try
+	{
+		socket.Send(setup_);
+
+		const auto hello = socket.Receive<TileProtocol::Hello>();
+
+		if (hello.Magic != TileProtocol::Magic)
+		{
+			Throw(std::runtime_error("worker protocol mismatch"));
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			workers_[workerIndex].DeviceName = std::string(hello.DeviceName, strnlen(hello.DeviceName, sizeof(hello.DeviceName)));
+		}
+
+		std::vector<glm::vec4> pixels;
+
+		while ((hasUnit = TakeUnit(unit, workerIndex)))
+		{
+			socket.Send(unit);
+
+			const auto result = socket.Receive<TileProtocol::Result>();
+
+			if (result.Id != unit.Id)
+			{
+				Throw(std::runtime_error("worker returned unit " + std::to_string(result.Id) + " instead of " + std::to_string(unit.Id)));
+			}
+
+			pixels.resize(static_cast<size_t>(unit.RowCount) * setup_.Width);
+			socket.Read(pixels.data(), pixels.size() * sizeof(pixels[0]));
+
+			CompleteUnit(unit, pixels, result.RenderTime, workerIndex);
+			hasUnit = false;
+		}
+
+		unit.Id = TileProtocol::Unit::QuitId;
+		socket.Send(unit);
+	}
+
+	catch (const std::exception& exception)
+	{
+		if (hasUnit)
+		{
+			FailUnit(unit, workerIndex);
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		if (!finished_)
+		{
+			std::cerr << "Worker " << workerIndex << " failed: " << exception.what() << std::endl;
+			workers_[workerIndex].Failed = true;
+		}
+	}
+
+	socket.Close();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	activeWorkers_--;
+	condition_.notify_all();
+}
+
+bool TileCoordinator::TakeUnit(TileProtocol::Unit& unit, const size_t workerIndex)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	for (;;)
+	{
+		if (remainingUnits_ == 0)
+		{
+			return false;
+		}
+
+		if (!pendingUnits_.empty())
+		{
+			auto& state = units_[pendingUnits_.front()];
+			pendingUnits_.pop_front();
+
+			state.InFlight++;
+			state.Start = Clock::now();
+			unit = state.Unit;
+			workers_[workerIndex].Busy = true;
+			return true;
+		}
+
+		// Nothing left to hand out, duplicate the oldest unit in flight if it takes much longer than the average unit.
+		if (unitTimeCount_ != 0)
+		{
+			const auto now = Clock::now();
+			const double threshold = 2 * unitTimeSum_ / unitTimeCount_;
+			UnitState* slowest = nullptr;
+
+			for (auto& state : units_)
+			{
+				if (!state.Done && state.InFlight == 1 &&
+					std::chrono::duration<double>(now - state.Start).count() > threshold &&
+					(slowest == nullptr || state.Start < slowest->Start))
+				{
+					slowest = &state;
+				}
+			}
+
+			if (slowest != nullptr)
+			{
+				slowest->InFlight++;
+				unit = slowest->Unit;
+				workers_[workerIndex].Busy = true;
+				return true;
+			}
+		}
+
+		condition_.wait_for(lock, std::chrono::milliseconds(100));
+	}
+}
+
+void TileCoordinator::CompleteUnit(const TileProtocol::Unit& unit, const std::vector<glm::vec4>& pixels, const double renderTime, const size_t workerIndex)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	auto& state = units_[unit.Id];
+	auto& worker = workers_[workerIndex];
+
+	state.InFlight--;
+	worker.Busy = false;
+
+	worker.PixelSamples += static_cast<double>(pixels.size()) * unit.SampleCount;
+	worker.RenderTime += renderTime;
+
+	if (state.Done)
+	{
+		worker.DiscardedUnits++;
+		return;
+	}
+
+	// The accumulations are sums of radiance and of samples, merging them weights each unit by its number of samples.
+	const auto first = accumulation_.begin() + static_cast<size_t>(unit.FirstRow) * setup_.Width;
+	std::transform(pixels.begin(), pixels.end(), first, first, std::plus<glm::vec4>());
+
+	state.Done = true;
+	worker.Units++;
+	remainingUnits_--;
+	unitTimeSum_ += renderTime;
+	unitTimeCount_++;
+
+	condition_.notify_all();
+}
+
+void TileCoordinator::FailUnit(const TileProtocol::Unit& unit, const size_t workerIndex)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	auto& state = units_[unit.Id];
+	state.InFlight--;
+	workers_[workerIndex].Busy = false;
+
+	if (!state.Done && state.InFlight == 0)
+	{
+		pendingUnits_.push_front(unit.Id);
+	}
+
+	condition_.notify_all();
+}
+
+void TileCoordinator::PrintStats(const double time) const
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	double totalPixelSamples = 0;
+	double sumOfRates = 0;
+	uint32_t ratedWorkers = 0;
+
+	std::cout << std::fixed << std::setprecision(2);
+
+	for (size_t i = 0; i != workers_.size(); ++i)
+	{
+		const auto& worker = workers_[i];
+		const double rate = worker.RenderTime > 0 ? worker.PixelSamples / worker.RenderTime : 0;
+
+		std::cout << "- worker " << i << " '" << worker.DeviceName << "': " << worker.Units << " units";
+
+		if (worker.DiscardedUnits != 0)
+		{
+			std::cout << " (+" << worker.DiscardedUnits << " duplicates)";
+		}
+
+		std::cout << ", " << rate / 1000000 << " Msamples/s" << (worker.Failed ? " (failed)" : "") << std::endl;
+
+		if (rate > 0)
+		{
+			sumOfRates += rate;
+			ratedWorkers++;
+		}
+	}
+
+	for (const auto& state : units_)
+	{
+		totalPixelSamples += static_cast<double>(state.Unit.RowCount) * setup_.Width * state.Unit.SampleCount;
+	}
+
+	// The scaling is relative to an average worker on its own, the efficiency to all the workers running flat out.
+	const double rate = totalPixelSamples / time;
+	const double scaling = ratedWorkers != 0 ? rate / (sumOfRates / ratedWorkers) : 0;
+	const double efficiency = sumOfRates > 0 ? rate / sumOfRates : 0;
+
+	std::cout << "Rendered in " << time << "s with " << workers_.size() << " workers: " << rate / 1000000 << " Msamples/s, "
+		<< scaling << "x a single worker (" << efficiency * 100 << "% efficiency)" << std::endl;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "TileProtocol.hpp"
+#include "Utilities/Glm.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Coordinator of distributed rendering. The frame is split into units of a few rows and a range of samples, which are
+// handed out to worker processes of this executable over a loopback socket (see TileWorker). Their accumulations hold
+// radiance sums and sample counts, so merging them is a plain sum, naturally weighted by the number of samples.
+// The units of a failed worker are handed out again, and so are the ones of a worker much slower than the others once
+// there is nothing else left to do; the first result wins.
+class TileCoordinator final
+{
+public:
+
+	TileCoordinator(const TileCoordinator&) = delete;
+	TileCoordinator(TileCoordinator&&) = delete;
+	TileCoordinator& operator = (const TileCoordinator&) = delete;
+	TileCoordinator& operator = (TileCoordinator&&) = delete;
+
+	TileCoordinator(const TileProtocol::Setup& setup, uint32_t samples, uint32_t unitRows, uint32_t unitSamples);
+	~TileCoordinator();
+
+	// Launch the given number of workers, spread round-robin over the local suitable devices (among the visible ones), serve
+	// them and any other one connecting to the port, and return once all the units have been merged. Reports the throughput
+	// of each worker, and how it scales with their number.
+	void Run(const std::string& executable, uint32_t localWorkers, const std::vector<uint32_t>& visibleDevices, uint32_t localDevices, uint16_t port);
+
+	// Save the merged frame as a PNG file.
+	void Save(const std::string& filename) const;
+
+private:
+
+	using Clock = std::chrono::high_resolution_clock;
+
+	struct UnitState final
+	{
+		TileProtocol::Unit Unit;
+		uint32_t InFlight;
+		bool Done;
+		Clock::time_point Start;
+	};
+
+	struct WorkerStats final
+	{
+		std::string DeviceName;
+		uint32_t Units;
+		uint32_t DiscardedUnits;
+		double PixelSamples;
+		double RenderTime;
+		bool Failed;
+		bool Busy; // a unit is in flight
+	};
+
+	void ServeWorker(TileProtocol::Socket& socket, size_t workerIndex);
+	bool TakeUnit(TileProtocol::Unit& unit, size_t workerIndex);
+	void CompleteUnit(const TileProtocol::Unit& unit, const std::vector<glm::vec4>& pixels, double renderTime, size_t workerIndex);
+	void FailUnit(const TileProtocol::Unit& unit, size_t workerIndex);
+	void PrintStats(double time) const;
+
+	const TileProtocol::Setup setup_;
+	std::vector<glm::vec4> accumulation_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable condition_;
+
+	std::vector<UnitState> units_;
+	std::deque<uint32_t> pendingUnits_;
+	size_t remainingUnits_{};
+	double unitTimeSum_{};
+	uint32_t unitTimeCount_{};
+
+	std::deque<WorkerStats> workers_;
+	uint32_t activeWorkers_{};
+	bool finished_{};
+};
@@ -0,0 +1,52 @@
+#include "TileProtocol.hpp"
+
+namespace TileProtocol {
+
+Socket::Socket(boost::asio::ip::tcp::socket&& socket) :
+	socket_(std::move(socket))
+{
+	// The messages are small and each one waits for an answer, do not hold them back.
+	socket_.set_option(boost::asio::ip::tcp::no_delay(true));
+}
+
+Socket::~Socket()
+{
+}
+
+Socket Socket::Connect(const uint16_t port)
+{
+	auto context = std::make_unique<boost::asio::io_context>();
+	boost::asio::ip::tcp::socket socket(*context);
+
+	socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+
+	Socket result(std::move(socket));
+	result.context_ = std::move(context);
+
+	return result;
+}
+
+void Socket::Write(const void* const data, const size_t size)
+{
+	boost::asio::write(socket_, boost::asio::buffer(data, size));
+}
+
+void Socket::Read(void* const data, const size_t size)
+{
+	boost::asio::read(socket_, boost::asio::buffer(data, size));
+}
+
+void Socket::Close()
+{
+	boost::system::error_code error;
+	socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+	socket_.close(error);
+}
+
+void Socket::Shutdown()
+{
+	boost::system::error_code error;
+	socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <memory>
+
+// Messages exchanged over a loopback TCP connection between the tile coordinator and its workers (see TileCoordinator
+// and TileWorker). They are plain structs sent as is, both ends being the same binary on the same host.
+namespace TileProtocol
+{
+	constexpr uint32_t Magic = 0x52545731; // 'RTW1', bumped whenever a message changes
+
+	// Coordinator to worker, once connected: what to render.
+	struct Setup final
+	{
+		uint32_t Magic;
+		uint32_t SceneIndex;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Bounces;
+		uint32_t SamplesPerFrame;
+		uint32_t Sampler;
+		uint32_t NextEventEstimation; // bool
+		uint32_t RussianRoulette; // bool
+		uint32_t RussianRouletteDepth;
+	};
+
+	// Worker to coordinator, once its device is ready.
+	struct Hello final
+	{
+		uint32_t Magic;
+		char DeviceName[256];
+	};
+
+	// Coordinator to worker: trace samples [FirstSample, FirstSample + SampleCount) of rows [FirstRow, FirstRow + RowCount).
+	struct Unit final
+	{
+		static constexpr uint32_t QuitId = ~0u;
+
+		uint32_t Id;
+		uint32_t FirstRow;
+		uint32_t RowCount;
+		uint32_t FirstSample;
+		uint32_t SampleCount;
+	};
+
+	// Worker to coordinator, followed by the accumulation of the unit rows (RowCount * Width RGBA floats, radiance sums
+	// and sample count in alpha).
+	struct Result final
+	{
+		uint32_t Id;
+		double RenderTime; // seconds
+	};
+
+	// Blocking connection, throwing a boost::system::system_error when the other end fails.
+	class Socket final
+	{
+	public:
+
+		Socket(const Socket&) = delete;
+		Socket& operator = (const Socket&) = delete;
+
+		explicit Socket(boost::asio::ip::tcp::socket&& socket);
+		~Socket();
+
+		// Connect to the coordinator listening on the given loopback port.
+		static Socket Connect(uint16_t port);
+
+		Socket(Socket&& other) noexcept = default;
+
+		template <class T>
+		void Send(const T& message) { Write(&message, sizeof(T)); }
+
+		template <class T>
+		T Receive() { T message{}; Read(&message, sizeof(T)); return message; }
+
+		void Write(const void* data, size_t size);
+		void Read(void* data, size_t size);
+
+		// Shut the connection down and release the socket, from the thread using it.
+		void Close();
+
+		// Abort the pending and future operations. Asio sockets are not thread safe, this is the one call allowed while
+		// another thread is blocked on the socket (see TileCoordinator::Run).
+		void Shutdown();
+
+	private:
+
+		std::unique_ptr<boost::asio::io_context> context_;
+		boost::asio::ip::tcp::socket socket_;
+	};
+}
@@ -0,0 +1,131 @@
+#include "TileWorker.hpp"
+#include "Assets/Model.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/SwapChain.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+TileWorker::TileWorker(const TileProtocol::Setup& setup) :
+	Application(Vulkan::WindowConfig{ "Tile Worker", setup.Width, setup.Height, false, false, false, false }, VK_PRESENT_MODE_IMMEDIATE_KHR),
+	setup_(setup)
+{
+}
+
+TileWorker::~TileWorker()
+{
+	if (HasSwapChain())
+	{
+		Device().WaitIdle();
+	}
+
+	scene_.reset();
+}
+
+void TileWorker::Run(TileProtocol::Socket& socket)
+{
+	VkPhysicalDeviceProperties prop;
+	vkGetPhysicalDeviceProperties(Device().PhysicalDevice(), &prop);
+
+	TileProtocol::Hello hello{};
+	hello.Magic = TileProtocol::Magic;
+	std::strncpy(hello.DeviceName, prop.deviceName, sizeof(hello.DeviceName) - 1);
+
+	socket.Send(hello);
+
+	for (;;)
+	{
+		TileProtocol::Unit unit{};
+
+		// The coordinator may also close the connection once it has all the units it needs.
+		try
+		{
+			unit = socket.Receive<TileProtocol::Unit>();
+		}
+
+		catch (const boost::system::system_error& error)
+		{
+			if (error.code() != boost::asio::error::eof)
+			{
+				throw;
+			}
+
+			break;
+		}
+
+		if (unit.Id == TileProtocol::Unit::QuitId)
+		{
+			break;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		RenderUnit(unit);
+		const auto pixels = ReadAccumulationRows(traceBand_);
+
+		TileProtocol::Result result{};
+		result.Id = unit.Id;
+		result.RenderTime = std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+
+		socket.Send(result);
+		socket.Write(pixels.data(), pixels.size() * sizeof(pixels[0]));
+	}
+}
+
+Assets::UniformBufferObject TileWorker::GetUniformBufferObject(const VkExtent2D extent) const
+{
+	Assets::UniformBufferObject ubo = {};
+	ubo.ModelView = cameraInitialSate_.ModelView;
+	ubo.Projection = glm::perspective(glm::radians(cameraInitialSate_.FieldOfView), extent.width / static_cast<float>(extent.height), 0.1f, 10000.0f);
+	ubo.Projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
+	ubo.ModelViewInverse = glm::inverse(ubo.ModelView);
+	ubo.ProjectionInverse = glm::inverse(ubo.Projection);
+	ubo.PreviousModelView = ubo.ModelView;
+	ubo.Aperture = cameraInitialSate_.Aperture;
+	ubo.FocusDistance = cameraInitialSate_.FocusDistance;
+	ubo.TotalNumberOfSamples = totalNumberOfSamples_;
+	ubo.NumberOfSamples = numberOfSamples_;
+	ubo.RandomSeed = 1 + sampleOffset_;
+	ubo.Sampler = setup_.Sampler;
+	ubo.RussianRouletteDepth = setup_.RussianRouletteDepth;
+	ubo.RenderWidth = RenderExtent().width;
+	ubo.RenderHeight = RenderExtent().height;
+	ubo.InterleaveRate = interleaveRate_;
+	ubo.FirstRow = traceBand_.FirstRow;
+	ubo.SampleOffset = sampleOffset_;
+
+	return ubo;
+}
+
+void TileWorker::OnDeviceSet()
+{
+	Application::OnDeviceSet();
+
+	scene_ = SceneList::LoadScene(CommandPool(), setup_.SceneIndex, cameraInitialSate_, Assets::HostResidency::Release);
+
+	CreateAccelerationStructures();
+
+	pipelineVariant_.NumberOfBounces = setup_.Bounces;
+	pipelineVariant_.HasSky = cameraInitialSate_.HasSky;
+	pipelineVariant_.NextEventEstimation = setup_.NextEventEstimation;
+	pipelineVariant_.RussianRoulette = setup_.RussianRoulette;
+}
+
+void TileWorker::RenderUnit(const TileProtocol::Unit& unit)
+{
+	// Only the unit rows are traced, and the samples are numbered from the start of its range so that the units of the
+	// same rows do not trace the same paths.
+	traceBand_ = { unit.FirstRow, unit.RowCount };
+	sampleOffset_ = unit.FirstSample;
+	totalNumberOfSamples_ = 0;
+
+	while (totalNumberOfSamples_ != unit.SampleCount)
+	{
+		numberOfSamples_ = std::min(unit.SampleCount - totalNumberOfSamples_, std::max(setup_.SamplesPerFrame, 1u));
+		totalNumberOfSamples_ += numberOfSamples_;
+
+		DrawFrame();
+	}
+}
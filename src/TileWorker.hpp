@@ -0,0 +1,41 @@
+#pragma once
+
+#include "SceneList.hpp"
+#include "TileProtocol.hpp"
+#include "Vulkan/RayTracing/Application.hpp"
+
+// Worker process of distributed rendering (see TileCoordinator). Its window is hidden, it traces the rows and sample ranges
+// handed out by the coordinator one at a time, and sends back their accumulation. Any Vulkan device with ray tracing
+// support will do, each worker picks its own.
+class TileWorker final : public Vulkan::RayTracing::Application
+{
+public:
+
+	VULKAN_NON_COPIABLE(TileWorker)
+
+	explicit TileWorker(const TileProtocol::Setup& setup);
+	~TileWorker();
+
+	// Serve units until the coordinator asks to quit.
+	void Run(TileProtocol::Socket& socket);
+
+protected:
+
+	const Assets::Scene& GetScene() const override { return *scene_; }
+	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override;
+
+	void OnDeviceSet() override;
+
+private:
+
+	void RenderUnit(const TileProtocol::Unit& unit);
+
+	const TileProtocol::Setup setup_;
+
+	SceneList::CameraInitialSate cameraInitialSate_{};
+	std::unique_ptr<const Assets::Scene> scene_;
+
+	uint32_t sampleOffset_{};
+	uint32_t totalNumberOfSamples_{};
+	uint32_t numberOfSamples_{};
+};
@@ -180,6 +180,7 @@ void UserInterface::DrawSettings()
 		ImGui::Separator();
 		ImGui::BulletText("F1: toggle Settings.");
 		ImGui::BulletText("F2: toggle Statistics.");
+		ImGui::BulletText("F3: save the render (EXR).");
 		ImGui::BulletText(
 			"%c%c%c%c/SHIFT/CTRL: move camera.", 
 			std::toupper(window.GetKeyName(GLFW_KEY_W, 0)[0]),
@@ -199,11 +200,31 @@ void UserInterface::DrawSettings()
 		ImGui::Text("Ray Tracing");
 		ImGui::Separator();
 		ImGui::Checkbox("Enable ray tracing", &Settings().IsRayTraced);
+		ImGui::Combo("Engine", &Settings().Engine, UserSettings::EngineNames, static_cast<int>(std::size(UserSettings::EngineNames)));
+		ImGui::Checkbox("Rasterize first hits (hybrid)", &Settings().HybridPrimary);
+		ImGui::Checkbox("Split frame between devices", &Settings().SplitFrame);
 		ImGui::Checkbox("Accumulate rays between frames", &Settings().AccumulateRays);
 		uint32_t min = 1, max = 128;
 		ImGui::SliderScalar("Samples", ImGuiDataType_U32, &Settings().NumberOfSamples, &min, &max);
 		min = 1, max = 32;
 		ImGui::SliderScalar("Bounces", ImGuiDataType_U32, &Settings().NumberOfBounces, &min, &max);
+		ImGui::Checkbox("Sample lights explicitly (NEE)", &Settings().NextEventEstimation);
+		ImGui::Checkbox("Russian roulette", &Settings().RussianRoulette);
+		min = 1, max = 16;
+		ImGui::SliderScalar("Roulette depth", ImGuiDataType_U32, &Settings().RussianRouletteDepth, &min, &max);
+		ImGui::Combo("Sampler", &Settings().Sampler, UserSettings::SamplerNames, static_cast<int>(std::size(UserSettings::SamplerNames)));
+		ImGui::Checkbox("Adaptive sampling", &Settings().AdaptiveSampling);
+		ImGui::SliderFloat("Error target", &Settings().ErrorTarget, 0.001f, 0.1f, "%.3f", ImGuiSliderFlags_Logarithmic);
+		ImGui::Checkbox("Denoise", &Settings().Denoise);
+		min = 1, max = 8;
+		ImGui::SliderScalar("Denoiser iterations", ImGuiDataType_U32, &Settings().DenoiserIterations, &min, &max);
+		ImGui::Checkbox("Reproject samples when moving", &Settings().TemporalReprojection);
+		min = 1, max = 256;
+		ImGui::SliderScalar("History length", ImGuiDataType_U32, &Settings().MaxHistoryLength, &min, &max);
+		ImGui::Combo("Trace when moving", &Settings().InterleaveMode, UserSettings::InterleaveModeNames, static_cast<int>(std::size(UserSettings::InterleaveModeNames)));
+		ImGui::SliderFloat("Render scale", &Settings().RenderScale, UserSettings::RenderScaleMinValue, UserSettings::RenderScaleMaxValue, "%.2f");
+		ImGui::Checkbox("Dynamic resolution", &Settings().DynamicResolution);
+		ImGui::SliderFloat("Target frame time", &Settings().TargetFrameTime, 4.0f, 100.0f, "%.1f ms");
 		ImGui::NewLine();
 
 		ImGui::Text("Camera");
@@ -211,6 +232,12 @@ void UserInterface::DrawSettings()
 		ImGui::SliderFloat("FoV", &Settings().FieldOfView, UserSettings::FieldOfViewMinValue, UserSettings::FieldOfViewMaxValue, "%.0f");
 		ImGui::SliderFloat("Aperture", &Settings().Aperture, 0.0f, 1.0f, "%.2f");
 		ImGui::SliderFloat("Focus", &Settings().FocusDistance, 0.1f, 20.0f, "%.1f");
+
+		if (Settings().BatchViews != 0)
+		{
+			ImGui::SliderInt("Shown batch view", &Settings().ShownBatchView, 0, static_cast<int>(Settings().BatchViews) - 1);
+		}
+
 		ImGui::NewLine();
 
 		ImGui::Text("Profiler");
@@ -251,6 +278,17 @@ void UserInterface::DrawOverlay(const Statistics& statistics)
 		ImGui::Text("Frame rate: %.1f fps", statistics.FrameRate);
 		ImGui::Text("Primary ray rate: %.2f Gr/s", statistics.RayRate);
 		ImGui::Text("Accumulated samples:  %u", statistics.TotalSamples);
+		ImGui::Text("Mean path length: %.2f", statistics.MeanPathLength);
+
+		if (Settings().IsRayTraced)
+		{
+			ImGui::Text("Render size: %dx%d", statistics.RenderSize.width, statistics.RenderSize.height);
+		}
+
+		if (Settings().AdaptiveSampling)
+		{
+			ImGui::Text("Active tiles: %.0f%%", statistics.ActiveTiles * 100);
+		}
 	}
 	ImGui::End();
 }
@@ -17,9 +17,12 @@ struct UserSettings;
 struct Statistics final
 {
 	VkExtent2D FramebufferSize;
+	VkExtent2D RenderSize;
 	float FrameRate;
 	float RayRate;
 	uint32_t TotalSamples;
+	float ActiveTiles;
+	float MeanPathLength;
 };
 
 class UserInterface final
@@ -7,6 +7,8 @@ struct UserSettings final
 
 	// Benchmark
 	bool BenchmarkNextScenes{};
+	bool BenchmarkCompareEngines{};
+	bool BenchmarkCompareSamplers{};
 	uint32_t BenchmarkMaxTime{};
 	
 	// Scene
@@ -14,10 +16,29 @@ struct UserSettings final
 
 	// Renderer
 	bool IsRayTraced;
+	int Engine;
+	bool HybridPrimary;
+	bool SplitFrame;
+	uint32_t BatchViews; // number of batch cameras (see RayTracer::SetBatchViews), zero outside of batch mode
+	int ShownBatchView;
 	bool AccumulateRays;
 	uint32_t NumberOfSamples;
 	uint32_t NumberOfBounces;
 	uint32_t MaxNumberOfSamples;
+	bool NextEventEstimation;
+	int Sampler;
+	bool AdaptiveSampling;
+	float ErrorTarget;
+	bool RussianRoulette;
+	uint32_t RussianRouletteDepth;
+	bool Denoise;
+	uint32_t DenoiserIterations;
+	bool TemporalReprojection;
+	uint32_t MaxHistoryLength;
+	int InterleaveMode;
+	float RenderScale;
+	bool DynamicResolution;
+	float TargetFrameTime;
 
 	// Camera
 	float FieldOfView;
@@ -35,12 +56,51 @@ struct UserSettings final
 	inline const static float FieldOfViewMinValue = 10.0f;
 	inline const static float FieldOfViewMaxValue = 90.0f;
 
+	inline const static float RenderScaleMinValue = 0.25f;
+	inline const static float RenderScaleMaxValue = 1.0f;
+
+	// Must match the sampler constants in Random.glsl.
+	inline const static char* const SamplerNames[] = { "LCG", "Sobol (Owen scrambled)", "Rank-1 lattice (blue noise)" };
+
+	// Path tracing engines (see Vulkan::RayTracing::Application).
+	inline const static char* const EngineNames[] = { "Megakernel (ray tracing pipeline)", "Wavefront (compute, ray queries)" };
+
+	// Pixels traced per frame while the camera moves, the interleave rate is 1 << InterleaveMode.
+	inline const static char* const InterleaveModeNames[] = { "All pixels", "Checkerboard (1 in 2)", "Interleaved (1 in 4)" };
+
+	// The wavefront engine does not support temporal reprojection, it always restarts the accumulation when the camera moves.
+	bool UsesTemporalReprojection() const
+	{
+		return TemporalReprojection && Engine == 0;
+	}
+
+	// The first hits are rasterized with a pinhole camera, by the megakernel engine only (see VisibilityPipeline).
+	bool UsesHybridPrimary() const
+	{
+		return HybridPrimary && Engine == 0 && Aperture == 0;
+	}
+
+	// The frame bands rendered by the peer devices only carry the final color (see PeerRenderer), so split-frame rendering
+	// leaves out the passes that need the other per-pixel buffers of the whole frame.
+	bool UsesSplitFrame() const
+	{
+		return SplitFrame && IsRayTraced && Engine == 0 && !HybridPrimary && !AdaptiveSampling && !Denoise && !TemporalReprojection;
+	}
+
 	bool RequiresAccumulationReset(const UserSettings& prev) const
 	{
 		return
 			IsRayTraced != prev.IsRayTraced ||
+			Engine != prev.Engine ||
+			HybridPrimary != prev.HybridPrimary ||
+			SplitFrame != prev.SplitFrame ||
 			AccumulateRays != prev.AccumulateRays ||
 			NumberOfBounces != prev.NumberOfBounces ||
+			NextEventEstimation != prev.NextEventEstimation ||
+			Sampler != prev.Sampler ||
+			RussianRoulette != prev.RussianRoulette ||
+			RussianRouletteDepth != prev.RussianRouletteDepth ||
+			RenderScale != prev.RenderScale ||
 			FieldOfView != prev.FieldOfView ||
 			Aperture != prev.Aperture ||
 			FocusDistance != prev.FocusDistance;
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utilities
+{
+	// Radical inverse of the index in the given base, the jitter of the successive frames covers the pixel evenly.
+	inline float Halton(uint32_t index, const uint32_t base)
+	{
+		float result = 0;
+		float fraction = 1;
+
+		while (index != 0)
+		{
+			fraction /= static_cast<float>(base);
+			result += fraction * static_cast<float>(index % base);
+			index /= base;
+		}
+
+		return result;
+	}
+}
@@ -2,9 +2,11 @@
 #include "Buffer.hpp"
 #include "CommandPool.hpp"
 #include "CommandBuffers.hpp"
+#include "CullingPipeline.hpp"
 #include "DebugUtilsMessenger.hpp"
 #include "DepthBuffer.hpp"
 #include "Device.hpp"
+#include "Enumerate.hpp"
 #include "Fence.hpp"
 #include "FrameBuffer.hpp"
 #include "GraphicsPipeline.hpp"
@@ -19,11 +21,14 @@
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Utilities/Exception.hpp"
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 namespace Vulkan {
 
 Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
+	offscreenExtent_{ windowConfig.Width, windowConfig.Height },
 	presentMode_(presentMode)
 {
 	const auto validationLayers = enableValidationLayers
@@ -76,7 +81,21 @@ void Application::SetPhysicalDevice(VkPhysicalDevice physicalDevice)
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
+	// VK_KHR_draw_indirect_count lets the GPU culled raster path draw only the visible meshes. Without it, every mesh
+	// gets a draw command and the culled ones are left empty (see DrawRasterObjects).
+	const auto extensions = GetEnumerateVector(physicalDevice, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
+	const bool hasDrawIndirectCount = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return std::strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0;
+	});
+
+	if (hasDrawIndirectCount)
+	{
+		requiredExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
 	VkPhysicalDeviceFeatures deviceFeatures = {};
+	deviceFeatures.multiDrawIndirect = true;
 	
 	SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, nullptr);
 	OnDeviceSet();
@@ -111,6 +130,20 @@ void Application::SetPhysicalDevice(
 {
 	device_.reset(new class Device(physicalDevice, *surface_, requiredExtensions, deviceFeatures, nextDeviceFeatures));
 	commandPool_.reset(new class CommandPool(*device_, device_->GraphicsFamilyIndex(), true));
+
+	const bool hasDrawIndirectCount = std::any_of(requiredExtensions.begin(), requiredExtensions.end(), [](const char* const extension)
+	{
+		return std::strcmp(extension, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0;
+	});
+
+	if (hasDrawIndirectCount)
+	{
+		vkCmdDrawIndexedIndirectCountKHR_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(device_->Handle(), "vkCmdDrawIndexedIndirectCountKHR"));
+		if (vkCmdDrawIndexedIndirectCountKHR_ == nullptr)
+		{
+			Throw(std::runtime_error("failed to get address of 'vkCmdDrawIndexedIndirectCountKHR'"));
+		}
+	}
 }
 
 void Application::OnDeviceSet()
@@ -125,7 +158,7 @@ void Application::CreateSwapChain()
 		window_->WaitForEvents();
 	}
 
-	swapChain_.reset(new class SwapChain(*device_, presentMode_));
+	swapChain_.reset(new class SwapChain(*device_, presentMode_, offscreenExtent_));
 	depthBuffer_.reset(new class DepthBuffer(*commandPool_, swapChain_->Extent()));
 
 	for (size_t i = 0; i != swapChain_->ImageViews().size(); ++i)
@@ -150,6 +183,7 @@ void Application::DeleteSwapChain()
 {
 	commandBuffers_.reset();
 	swapChainFramebuffers_.clear();
+	cullingPipeline_.reset();
 	graphicsPipeline_.reset();
 	uniformBuffers_.clear();
 	inFlightFences_.clear();
@@ -169,6 +203,31 @@ void Application::DrawFrame()
 
 	inFlightFence.Wait(noTimeout);
 
+	// Offscreen, the frames are rendered to the swap-chain images in turn, and the submission waits on nothing.
+	if (swapChain_->IsOffscreen())
+	{
+		const auto commandBuffer = commandBuffers_->Begin(currentFrame_);
+		Render(commandBuffer, currentFrame_, static_cast<uint32_t>(currentFrame_));
+		commandBuffers_->End(currentFrame_);
+
+		UpdateUniformBuffer();
+
+		VkCommandBuffer commandBuffers[]{ commandBuffer };
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = commandBuffers;
+
+		inFlightFence.Reset();
+
+		Check(vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, inFlightFence.Handle()),
+			"submit offscreen command buffer");
+
+		currentFrame_ = (currentFrame_ + 1) % inFlightFences_.size();
+		return;
+	}
+
 	uint32_t imageIndex;
 	auto result = vkAcquireNextImageKHR(device_->Handle(), swapChain_->Handle(), noTimeout, imageAvailableSemaphore, nullptr, &imageIndex);
 
@@ -238,6 +297,15 @@ void Application::DrawFrame()
 
 void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
 {
+	const auto& scene = GetScene();
+
+	if (!scene.HasRasterProxies())
+	{
+		Throw(std::logic_error("scene raster proxies have not been created"));
+	}
+
+	CullRasterObjects(commandBuffer, currentFrame);
+
 	std::array<VkClearValue, 2> clearValues = {};
 	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
 	clearValues[1].depthStencil = { 1.0f, 0 };
@@ -253,35 +321,115 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 	{
-		const auto& scene = GetScene();
-
 		VkDescriptorSet descriptorSets[] = { graphicsPipeline_->DescriptorSet(currentFrame) };
-		VkBuffer vertexBuffers[] = { scene.VertexBuffer().Handle() };
-		const VkBuffer indexBuffer = scene.IndexBuffer().Handle();
-		VkDeviceSize offsets[] = { 0 };
 
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->Handle());
 		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-		uint32_t vertexOffset = 0;
-		uint32_t indexOffset = 0;
+		DrawRasterObjects(commandBuffer);
+	}
+	vkCmdEndRenderPass(commandBuffer);
+}
 
-		for (const auto& model : scene.Models())
-		{
-			const auto vertexCount = static_cast<uint32_t>(model.NumberOfVertices());
-			const auto indexCount = static_cast<uint32_t>(model.NumberOfIndices());
+void Application::DrawRasterObjects(VkCommandBuffer commandBuffer)
+{
+	const auto& scene = GetScene();
+	const VkBuffer drawBuffer = cullingPipeline_->DrawBuffer().Handle();
+
+	VkBuffer vertexBuffers[] = { scene.VertexBuffer().Handle(), scene.RasterInstanceBuffer().Handle() };
+	const VkBuffer indexBuffer = scene.IndexBuffer().Handle();
+	VkDeviceSize offsets[] = { 0, 0 };
 
-			vkCmdDrawIndexed(commandBuffer, indexCount, 1, indexOffset, vertexOffset, 0);
+	// Triangle meshes, using their identity instance. The draw count is written by the culling pass.
+	if (cullingPipeline_->NumberOfMeshes() != 0)
+	{
+		vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
-			vertexOffset += vertexCount;
-			indexOffset += indexCount;
+		if (vkCmdDrawIndexedIndirectCountKHR_ != nullptr)
+		{
+			vkCmdDrawIndexedIndirectCountKHR_(
+				commandBuffer, 
+				drawBuffer, CullingPipeline::MeshDrawsOffset, 
+				drawBuffer, CullingPipeline::MeshDrawCountOffset, 
+				cullingPipeline_->NumberOfMeshes(), sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdDrawIndexedIndirect(
+				commandBuffer, 
+				drawBuffer, CullingPipeline::MeshDrawsOffset, 
+				cullingPipeline_->NumberOfMeshes(), sizeof(VkDrawIndexedIndirectCommand));
 		}
 	}
-	vkCmdEndRenderPass(commandBuffer);
+
+	// Procedural spheres, all visible ones in a single instanced draw of the shared sphere mesh.
+	if (scene.NumberOfSphereInstances() != 0)
+	{
+		VkBuffer sphereBuffers[] = { scene.SphereVertexBuffer().Handle(), cullingPipeline_->VisibleInstanceBuffer().Handle() };
+
+		vkCmdBindVertexBuffers(commandBuffer, 0, 2, sphereBuffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, scene.SphereIndexBuffer().Handle(), 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, CullingPipeline::SphereDrawOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
+void Application::CullRasterObjects(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	const auto& scene = GetScene();
+
+	// The culling resources are only needed by the raster passes, create them on first use.
+	if (!cullingPipeline_)
+	{
+		cullingPipeline_.reset(new CullingPipeline(*device_, uniformBuffers_, scene));
+	}
+
+	const VkBuffer drawBuffer = cullingPipeline_->DrawBuffer().Handle();
+
+	// The previous frame may still be drawing from the buffers we are about to overwrite.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, 
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// Reset the sphere draw command and the mesh draw count.
+	const std::array<uint32_t, CullingPipeline::MeshDrawsOffset / sizeof(uint32_t)> header = { scene.NumberOfSphereIndices(), 0, 0, 0, 0, 0, 0, 0 };
+	vkCmdUpdateBuffer(commandBuffer, drawBuffer, 0, sizeof(header), header.data());
+
+	// Without a GPU draw count all the mesh draw commands are issued, the ones past the visible meshes must be empty.
+	if (vkCmdDrawIndexedIndirectCountKHR_ == nullptr && cullingPipeline_->NumberOfMeshes() != 0)
+	{
+		vkCmdFillBuffer(commandBuffer, drawBuffer, CullingPipeline::MeshDrawsOffset, cullingPipeline_->NumberOfMeshes() * sizeof(VkDrawIndexedIndirectCommand), 0);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, 
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// One thread per raster object, regardless of the number of models the recording cost stays the same.
+	VkDescriptorSet descriptorSets[] = { cullingPipeline_->DescriptorSet(currentFrame) };
+	const uint32_t groupCount = (cullingPipeline_->NumberOfObjects() + CullingPipeline::WorkGroupSize - 1) / CullingPipeline::WorkGroupSize;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, 
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
 }
 
+
 void Application::UpdateUniformBuffer()
 {
 	uniformBuffers_[currentFrame_].SetValue(GetUniformBufferObject(swapChain_->Extent()));
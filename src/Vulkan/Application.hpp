@@ -61,6 +61,10 @@ namespace Vulkan
 		virtual void DrawFrame();
 		virtual void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex);
 
+		// Cull the scene raster proxies on the GPU, then draw the visible ones with the currently bound graphics pipeline.
+		void CullRasterObjects(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void DrawRasterObjects(VkCommandBuffer commandBuffer);
+
 		virtual void OnKey(int key, int scancode, int action, int mods) { }
 		virtual void OnCursorPosition(double xpos, double ypos) { }
 		virtual void OnMouseButton(int button, int action, int mods) { }
@@ -68,6 +72,9 @@ namespace Vulkan
 
 		bool isWireFrame_{};
 
+		// Size of the swap chain images when the window is hidden, the window config size by default.
+		VkExtent2D offscreenExtent_{};
+
 	private:
 
 		void UpdateUniformBuffer();
@@ -84,6 +91,7 @@ namespace Vulkan
 		std::vector<Assets::UniformBuffer> uniformBuffers_;
 		std::unique_ptr<class DepthBuffer> depthBuffer_;
 		std::unique_ptr<class GraphicsPipeline> graphicsPipeline_;
+		std::unique_ptr<class CullingPipeline> cullingPipeline_;
 		std::vector<class FrameBuffer> swapChainFramebuffers_;
 		std::unique_ptr<class CommandPool> commandPool_;
 		std::unique_ptr<class CommandBuffers> commandBuffers_;
@@ -91,6 +99,8 @@ namespace Vulkan
 		std::vector<class Semaphore> renderFinishedSemaphores_;
 		std::vector<class Fence> inFlightFences_;
 
+		PFN_vkCmdDrawIndexedIndirectCountKHR vkCmdDrawIndexedIndirectCountKHR_{};
+
 		size_t currentFrame_{};
 	};
 
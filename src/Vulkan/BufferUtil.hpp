@@ -5,6 +5,7 @@
 #include "Device.hpp"
 #include "DeviceMemory.hpp"
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -27,21 +28,68 @@ namespace Vulkan
 			const std::vector<T>& content,
 			std::unique_ptr<Buffer>& buffer,
 			std::unique_ptr<DeviceMemory>& memory);
+
+		// Same as above, but the content is written directly into the mapped staging memory by the given callback.
+		// This avoids having to gather the whole content into a temporary host vector first.
+		static void CopyFromStagingBuffer(
+			CommandPool& commandPool, 
+			Buffer& dstBuffer, 
+			size_t contentSize, 
+			const std::function<void(void* data)>& write);
+
+		static void CreateDeviceBuffer(
+			CommandPool& commandPool,
+			const char* name,
+			VkBufferUsageFlags usage,
+			size_t contentSize,
+			const std::function<void(void* data)>& write,
+			std::unique_ptr<Buffer>& buffer,
+			std::unique_ptr<DeviceMemory>& memory);
 	};
 
 	template <class T>
 	void BufferUtil::CopyFromStagingBuffer(CommandPool& commandPool, Buffer& dstBuffer, const std::vector<T>& content)
 	{
-		const auto& device = commandPool.Device();
 		const auto contentSize = sizeof(content[0]) * content.size();
-		
+
+		CopyFromStagingBuffer(commandPool, dstBuffer, contentSize, [&content, contentSize](void* const data)
+		{
+			std::memcpy(data, content.data(), contentSize);
+		});
+	}
+
+	template <class T>
+	void BufferUtil::CreateDeviceBuffer(
+		CommandPool& commandPool,
+		const char* const name,
+		const VkBufferUsageFlags usage, 
+		const std::vector<T>& content,
+		std::unique_ptr<Buffer>& buffer,
+		std::unique_ptr<DeviceMemory>& memory)
+	{
+		const auto contentSize = sizeof(content[0]) * content.size();
+
+		CreateDeviceBuffer(commandPool, name, usage, contentSize, [&content, contentSize](void* const data)
+		{
+			std::memcpy(data, content.data(), contentSize);
+		}, buffer, memory);
+	}
+
+	inline void BufferUtil::CopyFromStagingBuffer(
+		CommandPool& commandPool, 
+		Buffer& dstBuffer, 
+		const size_t contentSize, 
+		const std::function<void(void* data)>& write)
+	{
+		const auto& device = commandPool.Device();
+
 		// Create a temporary host-visible staging buffer.
 		auto stagingBuffer = std::make_unique<Buffer>(device, contentSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
 		auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-		// Copy the host data into the staging buffer.
+		// Write the host data into the staging buffer.
 		const auto data = stagingBufferMemory.Map(0, contentSize);
-		std::memcpy(data, content.data(), contentSize);
+		write(data);
 		stagingBufferMemory.Unmap();
 
 		// Copy the staging buffer to the device buffer.
@@ -51,18 +99,17 @@ namespace Vulkan
 		stagingBuffer.reset();
 	}
 
-	template <class T>
-	void BufferUtil::CreateDeviceBuffer(
+	inline void BufferUtil::CreateDeviceBuffer(
 		CommandPool& commandPool,
 		const char* const name,
-		const VkBufferUsageFlags usage, 
-		const std::vector<T>& content,
+		const VkBufferUsageFlags usage,
+		const size_t contentSize,
+		const std::function<void(void* data)>& write,
 		std::unique_ptr<Buffer>& buffer,
 		std::unique_ptr<DeviceMemory>& memory)
 	{
 		const auto& device = commandPool.Device();
 		const auto& debugUtils = device.DebugUtils();
-		const auto contentSize = sizeof(content[0]) * content.size();
 		const VkMemoryAllocateFlags allocateFlags = usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
 			? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 			: 0;
@@ -73,6 +120,6 @@ namespace Vulkan
 		debugUtils.SetObjectName(buffer->Handle(), (name + std::string(" Buffer")).c_str());
 		debugUtils.SetObjectName(memory->Handle(), (name + std::string(" Memory")).c_str());
 
-		CopyFromStagingBuffer(commandPool, *buffer, content);
+		CopyFromStagingBuffer(commandPool, *buffer, contentSize, write);
 	}
 }
@@ -0,0 +1,127 @@
+#include "CullingPipeline.hpp"
+#include "Buffer.hpp"
+#include "DescriptorSetManager.hpp"
+#include "DescriptorSets.hpp"
+#include "Device.hpp"
+#include "PipelineLayout.hpp"
+#include "ShaderModule.hpp"
+#include "Assets/RasterInstance.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include <algorithm>
+
+namespace Vulkan {
+
+CullingPipeline::CullingPipeline(
+	const Device& device,
+	const std::vector<Assets::UniformBuffer>& uniformBuffers,
+	const Assets::Scene& scene) :
+	device_(device),
+	numberOfObjects_(scene.NumberOfRasterObjects()),
+	numberOfMeshes_(scene.NumberOfRasterObjects() - scene.NumberOfSphereInstances())
+{
+	// Output buffers, sized for the worst case where everything is visible.
+	const auto drawBufferSize = MeshDrawsOffset + std::max(numberOfMeshes_, 1u) * sizeof(VkDrawIndexedIndirectCommand);
+	const auto instanceBufferSize = std::max(scene.NumberOfSphereInstances(), 1u) * sizeof(Assets::RasterInstance);
+
+	drawBuffer_.reset(new Buffer(device, drawBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	drawBufferMemory_.reset(new DeviceMemory(drawBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	visibleInstanceBuffer_.reset(new Buffer(device, instanceBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+	visibleInstanceBufferMemory_.reset(new DeviceMemory(visibleInstanceBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	// Create descriptor pool/sets.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Camera information
+		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Raster objects & instances (input), draw commands & visible instances (output)
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	for (uint32_t i = 0; i != uniformBuffers.size(); ++i)
+	{
+		// Uniform buffer
+		VkDescriptorBufferInfo uniformBufferInfo = {};
+		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
+		uniformBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Raster objects buffer
+		VkDescriptorBufferInfo objectBufferInfo = {};
+		objectBufferInfo.buffer = scene.RasterObjectBuffer().Handle();
+		objectBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Raster instances buffer
+		VkDescriptorBufferInfo instanceBufferInfo = {};
+		instanceBufferInfo.buffer = scene.RasterInstanceBuffer().Handle();
+		instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Draw buffer
+		VkDescriptorBufferInfo drawBufferInfo = {};
+		drawBufferInfo.buffer = drawBuffer_->Handle();
+		drawBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Visible instances buffer
+		VkDescriptorBufferInfo visibleInstanceBufferInfo = {};
+		visibleInstanceBufferInfo.buffer = visibleInstanceBuffer_->Handle();
+		visibleInstanceBufferInfo.range = VK_WHOLE_SIZE;
+
+		const std::vector<VkWriteDescriptorSet> descriptorWrites =
+		{
+			descriptorSets.Bind(i, 0, uniformBufferInfo),
+			descriptorSets.Bind(i, 1, objectBufferInfo),
+			descriptorSets.Bind(i, 2, instanceBufferInfo),
+			descriptorSets.Bind(i, 3, drawBufferInfo),
+			descriptorSets.Bind(i, 4, visibleInstanceBufferInfo)
+		};
+
+		descriptorSets.UpdateDescriptors(descriptorWrites);
+	}
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+
+	// Load shaders.
+	const ShaderModule computeShader(device, "../assets/shaders/FrustumCulling.comp.spv");
+
+	// Create compute pipeline
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+		"create culling pipeline");
+}
+
+CullingPipeline::~CullingPipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(device_.Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	visibleInstanceBuffer_.reset();
+	visibleInstanceBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	drawBuffer_.reset();
+	drawBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+VkDescriptorSet CullingPipeline::DescriptorSet(const size_t index) const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(index);
+}
+
+}
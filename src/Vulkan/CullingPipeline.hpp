@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Assets
+{
+	class Scene;
+	class UniformBuffer;
+}
+
+namespace Vulkan
+{
+	class Buffer;
+	class DescriptorSetManager;
+	class Device;
+	class DeviceMemory;
+	class PipelineLayout;
+
+	// Compute pipeline culling the scene raster objects against the camera frustum. It outputs the indirect draw
+	// commands of the visible triangle meshes, and a single instanced draw command for the visible procedural spheres.
+	class CullingPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(CullingPipeline)
+
+		// Layout of the draw buffer: the sphere draw command, the mesh draw count, then the mesh draw commands.
+		static constexpr VkDeviceSize SphereDrawOffset = 0;
+		static constexpr VkDeviceSize MeshDrawCountOffset = sizeof(VkDrawIndexedIndirectCommand);
+		static constexpr VkDeviceSize MeshDrawsOffset = 32;
+		static constexpr uint32_t WorkGroupSize = 64;
+
+		CullingPipeline(
+			const Device& device,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const Assets::Scene& scene);
+		~CullingPipeline();
+
+		VkDescriptorSet DescriptorSet(size_t index) const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+		const Buffer& DrawBuffer() const { return *drawBuffer_; }
+		const Buffer& VisibleInstanceBuffer() const { return *visibleInstanceBuffer_; }
+
+		uint32_t NumberOfObjects() const { return numberOfObjects_; }
+		uint32_t NumberOfMeshes() const { return numberOfMeshes_; }
+
+	private:
+
+		const class Device& device_;
+		const uint32_t numberOfObjects_;
+		const uint32_t numberOfMeshes_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		std::unique_ptr<Buffer> drawBuffer_;
+		std::unique_ptr<DeviceMemory> drawBufferMemory_;
+
+		std::unique_ptr<Buffer> visibleInstanceBuffer_;
+		std::unique_ptr<DeviceMemory> visibleInstanceBufferMemory_;
+	};
+
+}
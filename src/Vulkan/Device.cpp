@@ -2,6 +2,7 @@
 #include "Enumerate.hpp"
 #include "Instance.hpp"
 #include "Surface.hpp"
+#include "Window.hpp"
 #include "Utilities/Exception.hpp"
 #include <algorithm>
 #include <set>
@@ -55,8 +56,10 @@ Device::Device(
 	//and causes problems with RADV (see https://github.com/NVIDIA/Q2RTX/issues/147).
 	//const auto transferFamily = FindQueue(queueFamilies, "transfer", VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
 
-	// Find the presentation queue (usually the same as graphics queue).
-	const auto presentFamily = std::find_if(queueFamilies.begin(), queueFamilies.end(), [&](const VkQueueFamilyProperties& queueFamily)
+	// Find the presentation queue (usually the same as graphics queue). Offscreen devices never present, they may not
+	// even be connected to a display, so they just use the graphics queue.
+	const bool offscreen = !surface.Instance().Window().Config().Visible;
+	const auto presentFamily = offscreen ? graphicsFamily : std::find_if(queueFamilies.begin(), queueFamilies.end(), [&](const VkQueueFamilyProperties& queueFamily)
 	{
 		VkBool32 presentSupport = false;
 		const uint32_t i = static_cast<uint32_t>(&*queueFamilies.cbegin() - &queueFamily);
@@ -8,6 +8,7 @@
 #include "RenderPass.hpp"
 #include "ShaderModule.hpp"
 #include "SwapChain.hpp"
+#include "Assets/RasterInstance.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Assets/Vertex.hpp"
@@ -24,13 +25,22 @@ GraphicsPipeline::GraphicsPipeline(
 	isWireFrame_(isWireFrame)
 {
 	const auto& device = swapChain.Device();
-	const auto bindingDescription = Assets::Vertex::GetBindingDescription();
-	const auto attributeDescriptions = Assets::Vertex::GetAttributeDescriptions();
+	const auto vertexAttributes = Assets::Vertex::GetAttributeDescriptions();
+	const auto instanceAttributes = Assets::RasterInstance::GetAttributeDescriptions();
+
+	const VkVertexInputBindingDescription bindingDescriptions[] =
+	{
+		Assets::Vertex::GetBindingDescription(),
+		Assets::RasterInstance::GetBindingDescription()
+	};
+
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(vertexAttributes.begin(), vertexAttributes.end());
+	attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.vertexBindingDescriptionCount = 2;
+	vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -18,9 +18,21 @@ Image::Image(
 	const VkFormat format,
 	const VkImageTiling tiling,
 	const VkImageUsageFlags usage) :
+	Image(device, extent, format, tiling, usage, 1)
+{
+}
+
+Image::Image(
+	const class Device& device,
+	const VkExtent2D extent,
+	const VkFormat format,
+	const VkImageTiling tiling,
+	const VkImageUsageFlags usage,
+	const uint32_t arrayLayers) :
 	device_(device),
 	extent_(extent),
 	format_(format),
+	arrayLayers_(arrayLayers),
 	imageLayout_(VK_IMAGE_LAYOUT_UNDEFINED)
 {
 	VkImageCreateInfo imageInfo = {};
@@ -30,7 +42,7 @@ Image::Image(
 	imageInfo.extent.height = extent.height;
 	imageInfo.extent.depth = 1;
 	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
+	imageInfo.arrayLayers = arrayLayers;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
 	imageInfo.initialLayout = imageLayout_;
@@ -47,6 +59,7 @@ Image::Image(Image&& other) noexcept :
 	device_(other.device_),
 	extent_(other.extent_),
 	format_(other.format_),
+	arrayLayers_(other.arrayLayers_),
 	imageLayout_(other.imageLayout_),
 	image_(other.image_)
 {
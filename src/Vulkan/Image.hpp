@@ -19,12 +19,14 @@ namespace Vulkan
 
 		Image(const Device& device, VkExtent2D extent, VkFormat format);
 		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
+		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, uint32_t arrayLayers);
 		Image(Image&& other) noexcept;
 		~Image();
 
 		const class Device& Device() const { return device_; }
 		VkExtent2D Extent() const { return extent_; }
 		VkFormat Format() const { return format_; }
+		uint32_t ArrayLayers() const { return arrayLayers_; }
 
 		DeviceMemory AllocateMemory(VkMemoryPropertyFlags properties) const;
 		VkMemoryRequirements GetMemoryRequirements() const;
@@ -37,6 +39,7 @@ namespace Vulkan
 		const class Device& device_;
 		const VkExtent2D extent_;
 		const VkFormat format_;
+		const uint32_t arrayLayers_;
 		VkImageLayout imageLayout_;
 
 		VULKAN_HANDLE(VkImage, image_)
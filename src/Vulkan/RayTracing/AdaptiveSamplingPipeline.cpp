@@ -0,0 +1,142 @@
+#include "AdaptiveSamplingPipeline.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SwapChain.hpp"
+#include <cstring>
+
+namespace Vulkan::RayTracing {
+
+AdaptiveSamplingPipeline::AdaptiveSamplingPipeline(
+	const SwapChain& swapChain,
+	const ImageView& accumulationImageView,
+	const ImageView& varianceImageView,
+	const std::vector<Assets::UniformBuffer>& uniformBuffers) :
+	swapChain_(swapChain),
+	tileCountX_((swapChain.Extent().width + TileSize - 1) / TileSize),
+	tileCountY_((swapChain.Extent().height + TileSize - 1) / TileSize)
+{
+	const auto& device = swapChain.Device();
+
+	// Frame counters, then one sample budget per tile.
+	const auto budgetBufferSize = BudgetsOffset + tileCountX_ * tileCountY_ * sizeof(uint32_t);
+
+	sampleBudgetBuffer_.reset(new Buffer(device, budgetBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	sampleBudgetBufferMemory_.reset(new DeviceMemory(sampleBudgetBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	// Until a frame has been read back, report every tile as active.
+	for (size_t i = 0; i != uniformBuffers.size(); ++i)
+	{
+		readbackBuffers_.emplace_back(new Buffer(device, sizeof(Counters), VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+		readbackBufferMemories_.emplace_back(new DeviceMemory(readbackBuffers_.back()->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+
+		const Counters counters = { tileCountX_ * tileCountY_, 0, 0 };
+		const auto data = readbackBufferMemories_.back()->Map(0, sizeof(Counters));
+		std::memcpy(data, &counters, sizeof(Counters));
+		readbackBufferMemories_.back()->Unmap();
+	}
+
+	// Create descriptor pool/sets.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Camera information
+		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Accumulation & variance images (input), sample budgets (output)
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	for (uint32_t i = 0; i != uniformBuffers.size(); ++i)
+	{
+		// Uniform buffer
+		VkDescriptorBufferInfo uniformBufferInfo = {};
+		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
+		uniformBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Accumulation image
+		VkDescriptorImageInfo accumulationImageInfo = {};
+		accumulationImageInfo.imageView = accumulationImageView.Handle();
+		accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Variance image
+		VkDescriptorImageInfo varianceImageInfo = {};
+		varianceImageInfo.imageView = varianceImageView.Handle();
+		varianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Sample budget buffer
+		VkDescriptorBufferInfo sampleBudgetBufferInfo = {};
+		sampleBudgetBufferInfo.buffer = sampleBudgetBuffer_->Handle();
+		sampleBudgetBufferInfo.range = VK_WHOLE_SIZE;
+
+		const std::vector<VkWriteDescriptorSet> descriptorWrites =
+		{
+			descriptorSets.Bind(i, 0, uniformBufferInfo),
+			descriptorSets.Bind(i, 1, accumulationImageInfo),
+			descriptorSets.Bind(i, 2, varianceImageInfo),
+			descriptorSets.Bind(i, 3, sampleBudgetBufferInfo)
+		};
+
+		descriptorSets.UpdateDescriptors(descriptorWrites);
+	}
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
+
+	// Load shaders.
+	const ShaderModule computeShader(device, "../assets/shaders/AdaptiveSampling.comp.spv");
+
+	// Create compute pipeline
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+		"create adaptive sampling pipeline");
+}
+
+AdaptiveSamplingPipeline::~AdaptiveSamplingPipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	readbackBuffers_.clear();
+	readbackBufferMemories_.clear(); // release memory after bound buffer has been destroyed
+	sampleBudgetBuffer_.reset();
+	sampleBudgetBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+VkDescriptorSet AdaptiveSamplingPipeline::DescriptorSet(const size_t index) const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(index);
+}
+
+AdaptiveSamplingPipeline::Counters AdaptiveSamplingPipeline::ReadCounters(const size_t index) const
+{
+	Counters counters = {};
+
+	const auto data = readbackBufferMemories_[index]->Map(0, sizeof(Counters));
+	std::memcpy(&counters, data, sizeof(Counters));
+	readbackBufferMemories_[index]->Unmap();
+
+	return counters;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Assets
+{
+	class UniformBuffer;
+}
+
+namespace Vulkan
+{
+	class Buffer;
+	class DescriptorSetManager;
+	class DeviceMemory;
+	class ImageView;
+	class PipelineLayout;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Compute pipeline estimating the remaining error of every screen tile from the per-pixel sample statistics, and
+	// deciding how many samples each tile receives in the next frames (see AdaptiveSampling.comp). The frame counters at
+	// the start of the budget buffer are copied back to the host, one readback buffer per frame in flight.
+	class AdaptiveSamplingPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(AdaptiveSamplingPipeline)
+
+		// Must match the header of the sample budget buffer.
+		struct Counters final
+		{
+			uint32_t ActiveTiles;
+			uint32_t Paths;
+			uint32_t PathSegments;
+		};
+
+		// Must match AdaptiveSampling.glsl.
+		static constexpr uint32_t TileSize = 16;
+		static constexpr VkDeviceSize BudgetsOffset = 16;
+
+		AdaptiveSamplingPipeline(
+			const SwapChain& swapChain,
+			const ImageView& accumulationImageView,
+			const ImageView& varianceImageView,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers);
+		~AdaptiveSamplingPipeline();
+
+		VkDescriptorSet DescriptorSet(size_t index) const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+		const Buffer& SampleBudgetBuffer() const { return *sampleBudgetBuffer_; }
+		const Buffer& ReadbackBuffer(size_t index) const { return *readbackBuffers_[index]; }
+
+		uint32_t TileCountX() const { return tileCountX_; }
+		uint32_t TileCountY() const { return tileCountY_; }
+
+		// Counters as of the last time the given frame was rendered.
+		Counters ReadCounters(size_t index) const;
+
+	private:
+
+		const SwapChain& swapChain_;
+		const uint32_t tileCountX_;
+		const uint32_t tileCountY_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		std::unique_ptr<Buffer> sampleBudgetBuffer_;
+		std::unique_ptr<DeviceMemory> sampleBudgetBufferMemory_;
+
+		std::vector<std::unique_ptr<Buffer>> readbackBuffers_;
+		std::vector<std::unique_ptr<DeviceMemory>> readbackBufferMemories_;
+	};
+
+}
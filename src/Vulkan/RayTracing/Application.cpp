@@ -1,11 +1,18 @@
 #include "Application.hpp"
+#include "AdaptiveSamplingPipeline.hpp"
 #include "BottomLevelAccelerationStructure.hpp"
+#include "DenoiserPipeline.hpp"
 #include "DeviceProcedures.hpp"
 #include "RayTracingPipeline.hpp"
+#include "ReconstructionPipeline.hpp"
 #include "ShaderBindingTable.hpp"
 #include "TopLevelAccelerationStructure.hpp"
+#include "UpscalerPipeline.hpp"
+#include "VisibilityPipeline.hpp"
+#include "WavefrontPipeline.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
+#include "Utilities/Exception.hpp"
 #include "Utilities/Glm.hpp"
 #include "Vulkan/Buffer.hpp"
 #include "Vulkan/BufferUtil.hpp"
@@ -15,7 +22,10 @@
 #include "Vulkan/PipelineLayout.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <numeric>
 
@@ -24,6 +34,13 @@ namespace Vulkan::RayTracing {
 
 namespace
 {
+	const bool EnableValidationLayers =
+#ifdef NDEBUG
+		false;
+#else
+		true;
+#endif
+
 	template <class TAccelerationStructure>
 	VkAccelerationStructureBuildSizesInfoKHR GetTotalRequirements(const std::vector<TAccelerationStructure>& accelerationStructures)
 	{
@@ -38,10 +55,25 @@ namespace
 
 		return total;
 	}
+
+	bool HasNormalDepthAov(const uint32_t aovMask)
+	{
+		return (aovMask & (PipelineVariant::AovDepth | PipelineVariant::AovNormal)) != 0;
+	}
+
+	bool HasAlbedoAov(const uint32_t aovMask)
+	{
+		return (aovMask & PipelineVariant::AovAlbedo) != 0;
+	}
+
+	bool HasIdAov(const uint32_t aovMask)
+	{
+		return (aovMask & (PipelineVariant::AovInstanceId | PipelineVariant::AovMaterialId)) != 0;
+	}
 }
 
-Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
-	Vulkan::Application(windowConfig, presentMode, enableValidationLayers)
+Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode) :
+	Vulkan::Application(windowConfig, presentMode, EnableValidationLayers)
 {
 }
 
@@ -65,13 +97,21 @@ void Application::SetPhysicalDevice(
 	{	
 		VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
 		VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
-		VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME
+		VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+		VK_KHR_RAY_QUERY_EXTENSION_NAME,
+		// VK_KHR_SHADER_CLOCK is required for heatmap
+		VK_KHR_SHADER_CLOCK_EXTENSION_NAME
 	});
 
 	// Required device features.
+	VkPhysicalDeviceShaderClockFeaturesKHR shaderClockFeatures = {};
+	shaderClockFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_CLOCK_FEATURES_KHR;
+	shaderClockFeatures.pNext = nextDeviceFeatures;
+	shaderClockFeatures.shaderSubgroupClock = true;
+
 	VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures = {};
 	bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
-	bufferDeviceAddressFeatures.pNext = nextDeviceFeatures;
+	bufferDeviceAddressFeatures.pNext = &shaderClockFeatures;
 	bufferDeviceAddressFeatures.bufferDeviceAddress = true;
 
 	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
@@ -90,7 +130,20 @@ void Application::SetPhysicalDevice(
 	rayTracingFeatures.pNext = &accelerationStructureFeatures;
 	rayTracingFeatures.rayTracingPipeline = true;
 
-	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayTracingFeatures);
+	// Ray queries are used by the wavefront engine kernels.
+	VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {};
+	rayQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+	rayQueryFeatures.pNext = &rayTracingFeatures;
+	rayQueryFeatures.rayQuery = true;
+
+	deviceFeatures.fillModeNonSolid = true;
+	deviceFeatures.samplerAnisotropy = true;
+	deviceFeatures.shaderInt64 = true;
+
+	// The visibility buffer of the hybrid mode reads the primitive index in the fragment shader.
+	deviceFeatures.geometryShader = true;
+
+	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayQueryFeatures);
 }
 
 void Application::OnDeviceSet()
@@ -142,20 +195,101 @@ void Application::CreateSwapChain()
 	Vulkan::Application::CreateSwapChain();
 
 	CreateOutputImage();
+	CreateBatchImages();
+	CreateAovImages();
+
+	adaptiveSamplingPipeline_.reset(new AdaptiveSamplingPipeline(SwapChain(), *accumulationImageView_, *varianceImageView_, UniformBuffers()));
+	activeSampleTiles_ = NumberOfSampleTiles();
+	meanPathLength_ = 0;
+
+	denoiserPipeline_.reset(new DenoiserPipeline(SwapChain(), *accumulationImageView_, *varianceImageView_, *albedoImageView_, *normalDepthImageView_, *outputImageView_));
+	reconstructionPipeline_.reset(new ReconstructionPipeline(SwapChain(), *accumulationImageView_, *outputImageView_));
+	upscalerPipeline_.reset(new UpscalerPipeline(SwapChain(), *outputImageView_));
+	visibilityPipeline_.reset(new VisibilityPipeline(CommandPool(), SwapChain(), UniformBuffers()));
 
-	rayTracingPipeline_.reset(new RayTracingPipeline(*deviceProcedures_, SwapChain(), topAs_[0], *accumulationImageView_, *outputImageView_, UniformBuffers(), GetScene()));
+	rayTracingPipeline_.reset(new RayTracingPipeline(
+		*deviceProcedures_, SwapChain(), topAs_[0], *accumulationImageView_, *outputImageView_, *varianceImageView_,
+		*albedoImageView_, *normalDepthImageView_, *accumulationHistoryImageView_, *varianceHistoryImageView_, *normalDepthHistoryImageView_,
+		visibilityPipeline_->VisibilityImageView(), *batchAccumulationImageView_, *batchOutputImageView_,
+		*aovNormalDepthImageView_, *aovAlbedoImageView_, *aovIdImageView_, *batchCameraBuffer_,
+		adaptiveSamplingPipeline_->SampleBudgetBuffer(), UniformBuffers(), GetScene()));
 
-	const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline_->RayGenShaderIndex(), {}} };
-	const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline_->MissShaderIndex(), {}} };
-	const std::vector<ShaderBindingTable::Entry> hitGroups = { {rayTracingPipeline_->TriangleHitGroupIndex(), {}}, {rayTracingPipeline_->ProceduralHitGroupIndex(), {}} };
+	wavefrontPipeline_.reset(new WavefrontPipeline(
+		SwapChain(), topAs_[0], *accumulationImageView_, *outputImageView_, *varianceImageView_, *albedoImageView_, *normalDepthImageView_,
+		adaptiveSamplingPipeline_->SampleBudgetBuffer(), UniformBuffers(), GetScene()));
 
-	shaderBindingTable_.reset(new ShaderBindingTable(*deviceProcedures_, *rayTracingPipeline_, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
+	VkQueryPoolCreateInfo queryPoolInfo = {};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = 2 * static_cast<uint32_t>(UniformBuffers().size());
+
+	Check(vkCreateQueryPool(Device().Handle(), &queryPoolInfo, nullptr, &traceQueryPool_),
+		"create trace query pool");
+
+	traceRows_.assign(UniformBuffers().size(), 0);
+	traceRowRate_ = 0;
+
+	SetPipelineVariant(pipelineVariant_);
 }
 
 void Application::DeleteSwapChain()
 {
-	shaderBindingTable_.reset();
+	if (traceQueryPool_ != nullptr)
+	{
+		vkDestroyQueryPool(Device().Handle(), traceQueryPool_, nullptr);
+		traceQueryPool_ = nullptr;
+	}
+
+	bandBuffers_.clear();
+	bandBufferMemories_.clear(); // release memory after bound buffer has been destroyed
+	snapshotBuffer_.reset();
+	snapshotBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	snapshotRequested_ = false;
+	snapshotPending_ = false;
+	shaderBindingTable_ = nullptr;
+	shaderBindingTables_.clear();
+	wavefrontPipeline_.reset();
 	rayTracingPipeline_.reset();
+	visibilityPipeline_.reset();
+	upscalerPipeline_.reset();
+	reconstructionPipeline_.reset();
+	denoiserPipeline_.reset();
+	adaptiveSamplingPipeline_.reset();
+	aovIdImageView_.reset();
+	aovIdImage_.reset();
+	aovIdImageMemory_.reset(); // release memory after bound image has been destroyed
+	aovAlbedoImageView_.reset();
+	aovAlbedoImage_.reset();
+	aovAlbedoImageMemory_.reset(); // release memory after bound image has been destroyed
+	aovNormalDepthImageView_.reset();
+	aovNormalDepthImage_.reset();
+	aovNormalDepthImageMemory_.reset(); // release memory after bound image has been destroyed
+	batchCameraBuffer_.reset();
+	batchCameraBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	batchOutputImageView_.reset();
+	batchOutputImage_.reset();
+	batchOutputImageMemory_.reset(); // release memory after bound image has been destroyed
+	batchAccumulationImageView_.reset();
+	batchAccumulationImage_.reset();
+	batchAccumulationImageMemory_.reset(); // release memory after bound image has been destroyed
+	normalDepthHistoryImageView_.reset();
+	normalDepthHistoryImage_.reset();
+	normalDepthHistoryImageMemory_.reset();
+	varianceHistoryImageView_.reset();
+	varianceHistoryImage_.reset();
+	varianceHistoryImageMemory_.reset();
+	accumulationHistoryImageView_.reset();
+	accumulationHistoryImage_.reset();
+	accumulationHistoryImageMemory_.reset();
+	normalDepthImageView_.reset();
+	normalDepthImage_.reset();
+	normalDepthImageMemory_.reset();
+	albedoImageView_.reset();
+	albedoImage_.reset();
+	albedoImageMemory_.reset();
+	varianceImageView_.reset();
+	varianceImage_.reset();
+	varianceImageMemory_.reset();
 	outputImageView_.reset();
 	outputImage_.reset();
 	outputImageMemory_.reset();
@@ -166,11 +300,51 @@ void Application::DeleteSwapChain()
 	Vulkan::Application::DeleteSwapChain();
 }
 
+void Application::SetPipelineVariant(const PipelineVariant& requestedVariant)
+{
+	// Only write the AOVs the images were allocated for.
+	PipelineVariant variant = requestedVariant;
+	variant.AovMask = aovImagesMask_;
+
+	rayTracingPipeline_->SetVariant(variant);
+
+	// The shader group handles differ between pipeline variants, so each one has its own shader binding table.
+	auto& shaderBindingTable = shaderBindingTables_[variant];
+
+	if (!shaderBindingTable)
+	{
+		const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline_->RayGenShaderIndex(), {}} };
+		const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline_->MissShaderIndex(), {}}, {rayTracingPipeline_->ShadowMissShaderIndex(), {}} };
+		std::vector<ShaderBindingTable::Entry> hitGroups;
+
+		// The hit group records follow the order expected by RayTracingPipeline::HitGroupOffset().
+		for (const auto firstHitGroup : { rayTracingPipeline_->TriangleHitGroupIndex(), rayTracingPipeline_->ProceduralHitGroupIndex() })
+		{
+			for (uint32_t i = 0; i != RayTracingPipeline::HitGroupsPerGeometry; ++i)
+			{
+				hitGroups.push_back({ firstHitGroup + i, {} });
+			}
+		}
+
+		shaderBindingTable.reset(new ShaderBindingTable(*deviceProcedures_, *rayTracingPipeline_, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
+	}
+
+	shaderBindingTable_ = shaderBindingTable.get();
+}
+
 void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFrame, const uint32_t imageIndex)
 {
 	const auto extent = SwapChain().Extent();
+	const auto renderExtent = RenderExtent();
 
-	VkDescriptorSet descriptorSets[] = { rayTracingPipeline_->DescriptorSet(currentFrame) };
+	// The fence of this frame has been waited on, so its readback holds the counters of when it was last rendered.
+	const auto counters = adaptiveSamplingPipeline_->ReadCounters(currentFrame);
+
+	activeSampleTiles_ = counters.ActiveTiles;
+	meanPathLength_ = counters.Paths != 0 ? static_cast<float>(counters.PathSegments) / counters.Paths : 0.0f;
+
+	ReadTraceTime(currentFrame);
+	ReadSnapshot(currentFrame);
 
 	VkImageSubresourceRange subresourceRange = {};
 	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -186,35 +360,103 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, 0,
 		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	// Bind ray tracing pipeline.
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->Handle());
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	ImageMemoryBarrier::Insert(commandBuffer, varianceImage_->Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	// Describe the shader binding table.
-	VkStridedDeviceAddressRegionKHR raygenShaderBindingTable = {};
-	raygenShaderBindingTable.deviceAddress = shaderBindingTable_->RayGenDeviceAddress();
-	raygenShaderBindingTable.stride = shaderBindingTable_->RayGenEntrySize();
-	raygenShaderBindingTable.size = shaderBindingTable_->RayGenSize();
+	ImageMemoryBarrier::Insert(commandBuffer, albedoImage_->Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
-	missShaderBindingTable.deviceAddress = shaderBindingTable_->MissDeviceAddress();
-	missShaderBindingTable.stride = shaderBindingTable_->MissEntrySize();
-	missShaderBindingTable.size = shaderBindingTable_->MissSize();
+	ImageMemoryBarrier::Insert(commandBuffer, normalDepthImage_->Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
-	hitShaderBindingTable.deviceAddress = shaderBindingTable_->HitGroupDeviceAddress();
-	hitShaderBindingTable.stride = shaderBindingTable_->HitGroupEntrySize();
-	hitShaderBindingTable.size = shaderBindingTable_->HitGroupSize();
+	// The AOVs are only written by the frames that trace samples, keep them for the snapshots taken once the limit is reached.
+	for (const auto& image : { aovNormalDepthImage_.get(), aovAlbedoImage_.get(), aovIdImage_.get() })
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
 
-	VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
+	for (const auto& image : { accumulationHistoryImage_.get(), varianceHistoryImage_.get(), normalDepthHistoryImage_.get() })
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	}
 
-	// Execute ray tracing shaders.
-	deviceProcedures_->vkCmdTraceRaysKHR(commandBuffer,
-		&raygenShaderBindingTable, &missShaderBindingTable, &hitShaderBindingTable, &callableShaderBindingTable,
-		extent.width, extent.height, 1);
+	// The batch views keep their accumulation in the layers of the batch images.
+	VkImageSubresourceRange batchSubresourceRange = subresourceRange;
+	batchSubresourceRange.layerCount = batchOutputImage_->ArrayLayers();
+
+	for (const auto& image : { batchAccumulationImage_.get(), batchOutputImage_.get() })
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), batchSubresourceRange, 0,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	if (reprojectAccumulation_)
+	{
+		CopyHistory(commandBuffer);
+	}
+
+	ResetFrameCounters(commandBuffer);
+
+	if (wavefront_)
+	{
+		TraceWavefront(commandBuffer, currentFrame);
+	}
+	else
+	{
+		TraceMegakernel(commandBuffer, currentFrame);
+	}
+
+	if (!wavefront_ && pipelineVariant_.BatchViews)
+	{
+		CopyBatchView(commandBuffer);
+	}
+
+	if (!uploadBands_.empty())
+	{
+		UploadBands(commandBuffer, currentFrame);
+	}
+
+	if (readBackBand_)
+	{
+		ReadBackBand(commandBuffer, currentFrame);
+	}
+
+	if (snapshotRequested_)
+	{
+		CopySnapshot(commandBuffer, currentFrame);
+	}
+
+	UpdateSampleBudgets(commandBuffer, currentFrame);
+
+	if (denoise_)
+	{
+		Denoise(commandBuffer);
+	}
+
+	if (interleaveRate_ > 1)
+	{
+		Reconstruct(commandBuffer);
+	}
+
+	// Offscreen, the frame is only rendered for the band read back, there is nothing to present.
+	if (SwapChain().IsOffscreen())
+	{
+		return;
+	}
+
+	// Below full resolution, the swap-chain image is copied from the upscaled image instead.
+	const bool upscale = renderExtent.width != extent.width || renderExtent.height != extent.height;
+	const Image& finalImage = upscale ? upscalerPipeline_->UpscaledImage() : *outputImage_;
+
+	if (upscale)
+	{
+		Upscale(commandBuffer);
+	}
 
 	// Acquire output image and swap-chain image for copying.
-	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, 
+	ImageMemoryBarrier::Insert(commandBuffer, finalImage.Handle(), subresourceRange, 
 		VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
 	ImageMemoryBarrier::Insert(commandBuffer, SwapChain().Images()[imageIndex], subresourceRange, 0,
@@ -229,7 +471,7 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 	copyRegion.extent = { extent.width, extent.height, 1 };
 
 	vkCmdCopyImage(commandBuffer,
-		outputImage_->Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		finalImage.Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 		SwapChain().Images()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		1, &copyRegion);
 
@@ -237,136 +479,1155 @@ void Application::Render(VkCommandBuffer commandBuffer, const size_t currentFram
 		0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 }
 
-void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
+void Application::TraceMegakernel(VkCommandBuffer commandBuffer, const size_t currentFrame)
 {
-	const auto& scene = GetScene();
-	const auto& debugUtils = Device().DebugUtils();
-	
-	// Bottom level acceleration structure
-	// Triangles via vertex buffers. Procedurals via AABBs.
-	uint32_t vertexOffset = 0;
-	uint32_t indexOffset = 0;
-	uint32_t aabbOffset = 0;
+	const auto renderExtent = RenderExtent();
 
-	for (const auto& model : scene.Models())
+	SetPipelineVariant(pipelineVariant_);
+
+	if (pipelineVariant_.HybridPrimary)
 	{
-		const auto vertexCount = static_cast<uint32_t>(model.NumberOfVertices());
-		const auto indexCount = static_cast<uint32_t>(model.NumberOfIndices());
-		BottomLevelGeometry geometries;
-		
-		model.Procedural()
-			? geometries.AddGeometryAabb(scene, aabbOffset, 1, true)
-			: geometries.AddGeometryTriangles(scene, vertexOffset, vertexCount, indexOffset, indexCount, true);
+		RasterizeVisibility(commandBuffer, currentFrame);
+	}
 
-		bottomAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, geometries);
+	VkDescriptorSet descriptorSets[] = { rayTracingPipeline_->DescriptorSet(currentFrame) };
+	const uint32_t rowCount = traceBand_.RowCount != 0 ? traceBand_.RowCount : renderExtent.height;
+	const uint32_t viewCount = pipelineVariant_.BatchViews ? batchOutputImage_->ArrayLayers() : 1;
 
-		vertexOffset += vertexCount * sizeof(Assets::Vertex);
-		indexOffset += indexCount * sizeof(uint32_t);
-		aabbOffset += sizeof(VkAabbPositionsKHR);
-	}
+	// Bind ray tracing pipeline.
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
 
-	// Allocate the structures memory.
-	const auto total = GetTotalRequirements(bottomAs_);
+	// Describe the shader binding table.
+	VkStridedDeviceAddressRegionKHR raygenShaderBindingTable = {};
+	raygenShaderBindingTable.deviceAddress = shaderBindingTable_->RayGenDeviceAddress();
+	raygenShaderBindingTable.stride = shaderBindingTable_->RayGenEntrySize();
+	raygenShaderBindingTable.size = shaderBindingTable_->RayGenSize();
 
-	bottomBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT));
-	bottomBufferMemory_.reset(new DeviceMemory(bottomBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	bottomScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
-	bottomScratchBufferMemory_.reset(new DeviceMemory(bottomScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
+	missShaderBindingTable.deviceAddress = shaderBindingTable_->MissDeviceAddress();
+	missShaderBindingTable.stride = shaderBindingTable_->MissEntrySize();
+	missShaderBindingTable.size = shaderBindingTable_->MissSize();
 
-	debugUtils.SetObjectName(bottomBuffer_->Handle(), "BLAS Buffer");
-	debugUtils.SetObjectName(bottomBufferMemory_->Handle(), "BLAS Memory");
-	debugUtils.SetObjectName(bottomScratchBuffer_->Handle(), "BLAS Scratch Buffer");
-	debugUtils.SetObjectName(bottomScratchBufferMemory_->Handle(), "BLAS Scratch Memory");
+	VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
+	hitShaderBindingTable.deviceAddress = shaderBindingTable_->HitGroupDeviceAddress();
+	hitShaderBindingTable.stride = shaderBindingTable_->HitGroupEntrySize();
+	hitShaderBindingTable.size = shaderBindingTable_->HitGroupSize();
 
-	// Generate the structures.
-	VkDeviceSize resultOffset = 0;
-	VkDeviceSize scratchOffset = 0;
+	VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
 
-	for (size_t i = 0; i != bottomAs_.size(); ++i)
-	{
-		bottomAs_[i].Generate(commandBuffer, *bottomScratchBuffer_, scratchOffset, *bottomBuffer_, resultOffset);
-		
-		resultOffset += bottomAs_[i].BuildSizes().accelerationStructureSize;
-		scratchOffset += bottomAs_[i].BuildSizes().buildScratchSize;
+	// Execute ray tracing shaders, over the trace band only in split-frame mode (the band first row is in the UBO), and
+	// over all the views at once in batch mode.
+	const uint32_t firstQuery = 2 * static_cast<uint32_t>(currentFrame);
 
-		debugUtils.SetObjectName(bottomAs_[i].Handle(), ("BLAS #" + std::to_string(i)).c_str());
-	}
+	vkCmdResetQueryPool(commandBuffer, traceQueryPool_, firstQuery, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, traceQueryPool_, firstQuery);
+
+	deviceProcedures_->vkCmdTraceRaysKHR(commandBuffer,
+		&raygenShaderBindingTable, &missShaderBindingTable, &hitShaderBindingTable, &callableShaderBindingTable,
+		renderExtent.width, rowCount, viewCount);
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, traceQueryPool_, firstQuery + 1);
+	traceRows_[currentFrame] = rowCount * viewCount;
 }
 
-void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
+void Application::TraceWavefront(VkCommandBuffer commandBuffer, const size_t currentFrame)
 {
-	const auto& scene = GetScene();
-	const auto& debugUtils = Device().DebugUtils();
+	const auto renderExtent = RenderExtent();
+	auto& pipeline = *wavefrontPipeline_;
+	const VkBuffer queueBuffer = pipeline.QueueBuffer().Handle();
 
-	// Top level acceleration structure
-	std::vector<VkAccelerationStructureInstanceKHR> instances;
+	pipeline.SetVariant(pipelineVariant_);
 
-	// Hit group 0: triangles
-	// Hit group 1: procedurals
-	uint32_t instanceId = 0;
+	VkDescriptorSet descriptorSets[] = { pipeline.DescriptorSet(currentFrame) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
 
-	for (const auto& model : scene.Models())
+	// Every kernel consumes what the previous one wrote, including the indirect dispatch arguments. The first barrier
+	// also keeps the kernels of the previous frame away from the queues.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	const auto wait = [&]()
 	{
-		instances.push_back(TopLevelAccelerationStructure::CreateInstance(
-			bottomAs_[instanceId], glm::mat4(1), instanceId, model.Procedural() ? 1 : 0));
-		instanceId++;
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	};
+
+	WavefrontPipeline::PushConstants pushConstants = { renderExtent.width, renderExtent.height, 0, 0, WavefrontPipeline::QueueStage::Generate };
+
+	const auto bind = [&](const WavefrontPipeline::Kernel kernel)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle(kernel));
+		vkCmdPushConstants(commandBuffer, pipeline.PipelineLayout().Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	};
+
+	const auto dispatch = [&](const WavefrontPipeline::Kernel kernel, const uint32_t groupCountX, const uint32_t groupCountY)
+	{
+		bind(kernel);
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+		wait();
+	};
+
+	const auto dispatchIndirect = [&](const WavefrontPipeline::Kernel kernel, const VkDeviceSize argumentsOffset)
+	{
+		bind(kernel);
+		vkCmdDispatchIndirect(commandBuffer, queueBuffer, argumentsOffset);
+		wait();
+	};
+
+	const auto updateQueues = [&](const WavefrontPipeline::QueueStage stage)
+	{
+		pushConstants.Stage = stage;
+		dispatch(WavefrontPipeline::Kernel::Dispatch, 1, 1);
+	};
+
+	const uint32_t tileSize = WavefrontPipeline::TileSize;
+	const uint32_t groupCountX = (renderExtent.width + tileSize - 1) / tileSize;
+	const uint32_t groupCountY = (renderExtent.height + tileSize - 1) / tileSize;
+
+	wait();
+
+	// The samples of the frame are traced one after the other, each one a bounce at a time. Once all the paths have
+	// terminated, the remaining bounces are dispatched with zero work groups.
+	for (uint32_t s = 0; s != std::max(1u, wavefrontSamples_); ++s)
+	{
+		pushConstants.Sample = s;
+		pushConstants.Bounce = 0;
+
+		updateQueues(WavefrontPipeline::QueueStage::Generate);
+		dispatch(WavefrontPipeline::Kernel::Generate, groupCountX, groupCountY);
+
+		for (uint32_t b = 0; b != pipelineVariant_.NumberOfBounces; ++b)
+		{
+			pushConstants.Bounce = b;
+
+			updateQueues(WavefrontPipeline::QueueStage::Extend);
+			dispatchIndirect(WavefrontPipeline::Kernel::Extend, WavefrontPipeline::ExtendArgsOffset);
+
+			updateQueues(WavefrontPipeline::QueueStage::Shade);
+			dispatchIndirect(WavefrontPipeline::Kernel::Sort, WavefrontPipeline::HitArgsOffset);
+			dispatchIndirect(WavefrontPipeline::Kernel::Shade, WavefrontPipeline::HitArgsOffset);
+
+			if (pipelineVariant_.NextEventEstimation)
+			{
+				updateQueues(WavefrontPipeline::QueueStage::Connect);
+				dispatchIndirect(WavefrontPipeline::Kernel::Connect, WavefrontPipeline::ShadowArgsOffset);
+			}
+		}
+
+		dispatch(WavefrontPipeline::Kernel::Accumulate, groupCountX, groupCountY);
 	}
+}
 
-	// Create and copy instances buffer (do it in a separate one-time synchronous command buffer).
-	BufferUtil::CreateDeviceBuffer(CommandPool(), "TLAS Instances", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, instances, instancesBuffer_, instancesBufferMemory_);
+void Application::RasterizeVisibility(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	const auto renderExtent = RenderExtent();
 
-	// Memory barrier for the bottom level acceleration structure builds.
-	AccelerationStructure::MemoryBarrier(commandBuffer);
-	
-	topAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, instancesBuffer_->GetDeviceAddress(), static_cast<uint32_t>(instances.size()));
+	CullRasterObjects(commandBuffer, currentFrame);
 
-	// Allocate the structure memory.
-	const auto total = GetTotalRequirements(topAs_);
+	std::array<VkClearValue, 2> clearValues = {};
+	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 0.0f} };
+	clearValues[1].depthStencil = { 1.0f, 0 };
 
-	topBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR));
-	topBufferMemory_.reset(new DeviceMemory(topBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	VkRenderPassBeginInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = visibilityPipeline_->RenderPass();
+	renderPassInfo.framebuffer = visibilityPipeline_->FrameBuffer();
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = renderExtent;
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
 
-	topScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
-	topScratchBufferMemory_.reset(new DeviceMemory(topScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	VkViewport viewport = {};
+	viewport.width = static_cast<float>(renderExtent.width);
+	viewport.height = static_cast<float>(renderExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
 
-	
-	debugUtils.SetObjectName(topBuffer_->Handle(), "TLAS Buffer");
-	debugUtils.SetObjectName(topBufferMemory_->Handle(), "TLAS Memory");
-	debugUtils.SetObjectName(topScratchBuffer_->Handle(), "TLAS Scratch Buffer");
-	debugUtils.SetObjectName(topScratchBufferMemory_->Handle(), "TLAS Scratch Memory");
-	debugUtils.SetObjectName(instancesBuffer_->Handle(), "TLAS Instances Buffer");
-	debugUtils.SetObjectName(instancesBufferMemory_->Handle(), "TLAS Instances Memory");
+	const VkRect2D scissor = { { 0, 0 }, renderExtent };
 
-	// Generate the structures.
-	topAs_[0].Generate(commandBuffer, *topScratchBuffer_, 0, *topBuffer_, 0);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	{
+		VkDescriptorSet descriptorSets[] = { visibilityPipeline_->DescriptorSet(currentFrame) };
 
-	debugUtils.SetObjectName(topAs_[0].Handle(), "TLAS");
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visibilityPipeline_->Handle());
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, visibilityPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		DrawRasterObjects(commandBuffer);
+	}
+	vkCmdEndRenderPass(commandBuffer);
 }
 
-void Application::CreateOutputImage()
+uint32_t Application::NumberOfSampleTiles() const
+{
+	const auto extent = RenderExtent();
+	const auto tileSize = AdaptiveSamplingPipeline::TileSize;
+
+	return ((extent.width + tileSize - 1) / tileSize) * ((extent.height + tileSize - 1) / tileSize);
+}
+
+VkExtent2D Application::RenderExtent() const
 {
 	const auto extent = SwapChain().Extent();
-	const auto format = SwapChain().Format();
-	const auto tiling = VK_IMAGE_TILING_OPTIMAL;
 
-	accumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
-	accumulationImageMemory_.reset(new DeviceMemory(accumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	accumulationImageView_.reset(new ImageView(Device(), accumulationImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+	return
+	{
+		std::max(1u, static_cast<uint32_t>(extent.width * renderScale_)),
+		std::max(1u, static_cast<uint32_t>(extent.height * renderScale_))
+	};
+}
 
-	outputImage_.reset(new Image(Device(), extent, format, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
-	outputImageMemory_.reset(new DeviceMemory(outputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	outputImageView_.reset(new ImageView(Device(), outputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+void* Application::MapBandBuffer(const size_t currentFrame)
+{
+	CreateBandBuffers();
 
-	const auto& debugUtils = Device().DebugUtils();
-	
-	debugUtils.SetObjectName(accumulationImage_->Handle(), "Accumulation Image");
-	debugUtils.SetObjectName(accumulationImageMemory_->Handle(), "Accumulation Image Memory");
-	debugUtils.SetObjectName(accumulationImageView_->Handle(), "Accumulation ImageView");
-	
-	debugUtils.SetObjectName(outputImage_->Handle(), "Output Image");
-	debugUtils.SetObjectName(outputImageMemory_->Handle(), "Output Image Memory");
-	debugUtils.SetObjectName(outputImageView_->Handle(), "Output ImageView");
+	return bandBufferMemories_[currentFrame]->Map(0, BandBufferRowPitch() * SwapChain().Extent().height);
+}
+
+void Application::UnmapBandBuffer(const size_t currentFrame)
+{
+	bandBufferMemories_[currentFrame]->Unmap();
+}
+
+VkDeviceSize Application::BandBufferRowPitch() const
+{
+	// The output image has the 32-bit format of the swap chain.
+	return static_cast<VkDeviceSize>(SwapChain().Extent().width) * 4;
+}
+
+void Application::CopyHistory(VkCommandBuffer commandBuffer)
+{
+	const auto extent = RenderExtent();
+
+	// The ray tracing shaders overwrite the accumulation in place, keep the previous view around to reproject from.
+	VkImageCopy copyRegion;
+	copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.srcOffset = { 0, 0, 0 };
+	copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.dstOffset = { 0, 0, 0 };
+	copyRegion.extent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImage(commandBuffer,
+		accumulationImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		accumulationHistoryImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		1, &copyRegion);
+
+	vkCmdCopyImage(commandBuffer,
+		varianceImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		varianceHistoryImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		1, &copyRegion);
+
+	vkCmdCopyImage(commandBuffer,
+		normalDepthImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		normalDepthHistoryImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		1, &copyRegion);
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Application::ResetFrameCounters(VkCommandBuffer commandBuffer)
+{
+	// The previous frame may still be reading the counters back.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdFillBuffer(commandBuffer, adaptiveSamplingPipeline_->SampleBudgetBuffer().Handle(), 0, AdaptiveSamplingPipeline::BudgetsOffset, 0);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Application::UpdateSampleBudgets(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	const VkBuffer budgetBuffer = adaptiveSamplingPipeline_->SampleBudgetBuffer().Handle();
+
+	// Wait for the ray tracing shaders to be done with the accumulation images, the budgets and the counters.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// One work group per screen tile of the rendered area.
+	VkDescriptorSet descriptorSets[] = { adaptiveSamplingPipeline_->DescriptorSet(currentFrame) };
+	const auto extent = RenderExtent();
+	const auto tileSize = AdaptiveSamplingPipeline::TileSize;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, adaptiveSamplingPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, adaptiveSamplingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdDispatch(commandBuffer, (extent.width + tileSize - 1) / tileSize, (extent.height + tileSize - 1) / tileSize, 1);
+
+	// Make the budgets visible to the next frame ray tracing shaders (or wavefront kernels), and the counters to the copy.
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.size = sizeof(AdaptiveSamplingPipeline::Counters);
+
+	vkCmdCopyBuffer(commandBuffer, budgetBuffer, adaptiveSamplingPipeline_->ReadbackBuffer(currentFrame).Handle(), 1, &copyRegion);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Application::Denoise(VkCommandBuffer commandBuffer)
+{
+	const auto extent = RenderExtent();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, denoiserPipeline_->FilterImage(i).Handle(), subresourceRange, 0,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	VkDescriptorSet descriptorSets[] = { denoiserPipeline_->DescriptorSet() };
+	const uint32_t groupCountX = (extent.width + DenoiserPipeline::WorkGroupSize - 1) / DenoiserPipeline::WorkGroupSize;
+	const uint32_t groupCountY = (extent.height + DenoiserPipeline::WorkGroupSize - 1) / DenoiserPipeline::WorkGroupSize;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, denoiserPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, denoiserPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+
+	// Each iteration reads what the previous one (or the ray tracing shaders) wrote.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	for (uint32_t i = 0; i != denoiserIterations_; ++i)
+	{
+		const auto pushConstants = DenoiserPipeline::GetPushConstants(i, denoiserIterations_, extent);
+
+		vkCmdPushConstants(commandBuffer, denoiserPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+void Application::Reconstruct(VkCommandBuffer commandBuffer)
+{
+	const auto extent = RenderExtent();
+
+	// Wait for the output image to be written, either by the ray tracing shaders or the denoiser.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	VkDescriptorSet descriptorSets[] = { reconstructionPipeline_->DescriptorSet() };
+	const ReconstructionPipeline::PushConstants pushConstants = { extent.width, extent.height };
+	const uint32_t groupCountX = (extent.width + ReconstructionPipeline::WorkGroupSize - 1) / ReconstructionPipeline::WorkGroupSize;
+	const uint32_t groupCountY = (extent.height + ReconstructionPipeline::WorkGroupSize - 1) / ReconstructionPipeline::WorkGroupSize;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reconstructionPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, reconstructionPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, reconstructionPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+}
+
+void Application::Upscale(VkCommandBuffer commandBuffer)
+{
+	const auto extent = SwapChain().Extent();
+	const auto renderExtent = RenderExtent();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	ImageMemoryBarrier::Insert(commandBuffer, upscalerPipeline_->UpscaledImage().Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+	// Wait for the output image to be written, either by the ray tracing shaders or the denoiser.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	// One thread per swap-chain pixel.
+	VkDescriptorSet descriptorSets[] = { upscalerPipeline_->DescriptorSet() };
+	const UpscalerPipeline::PushConstants pushConstants = { renderExtent.width, renderExtent.height };
+	const uint32_t groupCountX = (extent.width + UpscalerPipeline::WorkGroupSize - 1) / UpscalerPipeline::WorkGroupSize;
+	const uint32_t groupCountY = (extent.height + UpscalerPipeline::WorkGroupSize - 1) / UpscalerPipeline::WorkGroupSize;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, upscalerPipeline_->Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, upscalerPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, upscalerPipeline_->PipelineLayout().Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+}
+
+void Application::UploadBands(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	CreateBandBuffers();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	// The bands of the peer devices overwrite the rows the ray tracing shaders have left alone.
+	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	std::vector<VkBufferImageCopy> copyRegions;
+
+	for (const auto& band : uploadBands_)
+	{
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.bufferOffset = band.FirstRow * BandBufferRowPitch();
+		copyRegion.bufferRowLength = SwapChain().Extent().width;
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.imageOffset = { 0, static_cast<int32_t>(band.FirstRow), 0 };
+		copyRegion.imageExtent = { RenderExtent().width, band.RowCount, 1 };
+
+		copyRegions.push_back(copyRegion);
+	}
+
+	vkCmdCopyBufferToImage(commandBuffer, bandBuffers_[currentFrame]->Handle(), outputImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+
+	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+void Application::ReadBackBand(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	CreateBandBuffers();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	const uint32_t rowCount = traceBand_.RowCount != 0 ? traceBand_.RowCount : RenderExtent().height;
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.bufferOffset = traceBand_.FirstRow * BandBufferRowPitch();
+	copyRegion.bufferRowLength = SwapChain().Extent().width;
+	copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.imageOffset = { 0, static_cast<int32_t>(traceBand_.FirstRow), 0 };
+	copyRegion.imageExtent = { RenderExtent().width, rowCount, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, outputImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL, bandBuffers_[currentFrame]->Handle(), 1, &copyRegion);
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Application::ReadTraceTime(const size_t currentFrame)
+{
+	// The fence of this frame has been waited on, so the timestamps of when it was last rendered are available.
+	if (traceRows_[currentFrame] == 0)
+	{
+		return;
+	}
+
+	uint64_t timestamps[2] = {};
+
+	if (vkGetQueryPoolResults(Device().Handle(), traceQueryPool_, 2 * static_cast<uint32_t>(currentFrame), 2,
+		sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(Device().PhysicalDevice(), &properties);
+
+		const double seconds = static_cast<double>(timestamps[1] - timestamps[0]) * properties.limits.timestampPeriod * 1e-9;
+		traceRowRate_ = seconds > 0 ? traceRows_[currentFrame] / seconds : 0;
+	}
+
+	traceRows_[currentFrame] = 0;
+}
+
+void Application::CopyBatchView(VkCommandBuffer commandBuffer)
+{
+	const auto extent = RenderExtent();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = batchOutputImage_->ArrayLayers();
+
+	ImageMemoryBarrier::Insert(commandBuffer, batchOutputImage_->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	subresourceRange.layerCount = 1;
+
+	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+	// The batch images have the output image format, so the shown view is copied as is.
+	const uint32_t layer = std::min(batchViewShown_, batchOutputImage_->ArrayLayers() - 1);
+
+	VkImageCopy copyRegion;
+	copyRegion.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, layer, 1 };
+	copyRegion.srcOffset = { 0, 0, 0 };
+	copyRegion.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.dstOffset = { 0, 0, 0 };
+	copyRegion.extent = { extent.width, extent.height, 1 };
+
+	vkCmdCopyImage(commandBuffer,
+		batchOutputImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		outputImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL,
+		1, &copyRegion);
+
+	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+std::vector<uint8_t> Application::ReadBatchViews()
+{
+	return ReadColorImage(*batchOutputImage_, batchOutputImage_->ArrayLayers());
+}
+
+std::vector<uint8_t> Application::ReadOutputImage()
+{
+	return ReadColorImage(*outputImage_, 1);
+}
+
+std::vector<glm::vec4> Application::ReadAccumulationRows(const FrameBand band)
+{
+	const auto width = RenderExtent().width;
+	const size_t size = static_cast<size_t>(width) * band.RowCount * sizeof(glm::vec4);
+
+	Buffer stagingBuffer(Device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	auto stagingBufferMemory = stagingBuffer.AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	Device().WaitIdle();
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		ImageMemoryBarrier::Insert(commandBuffer, accumulationImage_->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.imageOffset = { 0, static_cast<int32_t>(band.FirstRow), 0 };
+		copyRegion.imageExtent = { width, band.RowCount, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, accumulationImage_->Handle(), VK_IMAGE_LAYOUT_GENERAL, stagingBuffer.Handle(), 1, &copyRegion);
+	});
+
+	std::vector<glm::vec4> pixels(static_cast<size_t>(width) * band.RowCount);
+
+	const auto data = stagingBufferMemory.Map(0, size);
+	std::memcpy(pixels.data(), data, size);
+	stagingBufferMemory.Unmap();
+
+	return pixels;
+}
+
+void Application::RequestAccumulationSnapshot()
+{
+	if (!snapshotPending_)
+	{
+		snapshotRequested_ = true;
+	}
+}
+
+void Application::RestoreAccumulation(const std::vector<glm::vec4>& accumulation, const std::vector<float>& variance)
+{
+	const auto extent = RenderExtent();
+	const VkDeviceSize accumulationSize = accumulation.size() * sizeof(accumulation[0]);
+	const VkDeviceSize varianceSize = variance.size() * sizeof(variance[0]);
+
+	if (accumulation.size() != static_cast<size_t>(extent.width) * extent.height || variance.size() != accumulation.size())
+	{
+		Throw(std::runtime_error("accumulation snapshot does not match the render extent"));
+	}
+
+	Buffer stagingBuffer(Device(), accumulationSize + varianceSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	auto stagingBufferMemory = stagingBuffer.AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	const auto data = static_cast<uint8_t*>(stagingBufferMemory.Map(0, accumulationSize + varianceSize));
+	std::memcpy(data, accumulation.data(), accumulationSize);
+	std::memcpy(data + accumulationSize, variance.data(), varianceSize);
+	stagingBufferMemory.Unmap();
+
+	Device().WaitIdle();
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		copyRegion.imageExtent = { extent.width, extent.height, 1 };
+
+		for (const auto image : { accumulationImage_.get(), varianceImage_.get() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.Handle(), image->Handle(), VK_IMAGE_LAYOUT_GENERAL, 1, &copyRegion);
+
+			copyRegion.bufferOffset = accumulationSize;
+		}
+	});
+}
+
+void Application::CopySnapshot(VkCommandBuffer commandBuffer, const size_t currentFrame)
+{
+	const auto images = SnapshotImages();
+
+	// Sized for the whole swap chain, so that the render scale can change without reallocating it.
+	if (!snapshotBuffer_)
+	{
+		const auto extent = SwapChain().Extent();
+		VkDeviceSize size = 0;
+
+		for (const auto& [image, pixelSize] : images)
+		{
+			size += static_cast<VkDeviceSize>(extent.width) * extent.height * pixelSize;
+		}
+
+		snapshotBuffer_.reset(new Buffer(Device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+		snapshotBufferMemory_.reset(new DeviceMemory(snapshotBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	}
+
+	snapshotExtent_ = RenderExtent();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	VkBufferImageCopy copyRegion = {};
+	copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	copyRegion.imageExtent = { snapshotExtent_.width, snapshotExtent_.height, 1 };
+
+	for (const auto& [image, pixelSize] : images)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		vkCmdCopyImageToBuffer(commandBuffer, image->Handle(), VK_IMAGE_LAYOUT_GENERAL, snapshotBuffer_->Handle(), 1, &copyRegion);
+
+		copyRegion.bufferOffset += static_cast<VkDeviceSize>(snapshotExtent_.width) * snapshotExtent_.height * pixelSize;
+	}
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	snapshotRequested_ = false;
+	snapshotPending_ = true;
+	snapshotFrame_ = currentFrame;
+}
+
+void Application::ReadSnapshot(const size_t currentFrame)
+{
+	// The fence of this frame has been waited on, so the snapshot it copied is complete.
+	if (!snapshotPending_ || snapshotFrame_ != currentFrame)
+	{
+		return;
+	}
+
+	snapshotPending_ = false;
+
+	const size_t pixelCount = static_cast<size_t>(snapshotExtent_.width) * snapshotExtent_.height;
+	size_t size = 0;
+
+	for (const auto& [image, pixelSize] : SnapshotImages())
+	{
+		size += pixelCount * pixelSize;
+	}
+
+	std::vector<glm::vec4> accumulation;
+	std::vector<float> variance;
+	AovSnapshot aovs;
+
+	// Same order as SnapshotImages().
+	const auto data = static_cast<const uint8_t*>(snapshotBufferMemory_->Map(0, size));
+	size_t offset = 0;
+
+	const auto read = [&](auto& values)
+	{
+		values.resize(pixelCount);
+		std::memcpy(values.data(), data + offset, pixelCount * sizeof(values[0]));
+		offset += pixelCount * sizeof(values[0]);
+	};
+
+	read(accumulation);
+
+	if (HasNormalDepthAov(aovImagesMask_))
+	{
+		read(aovs.NormalDepth);
+	}
+
+	if (HasAlbedoAov(aovImagesMask_))
+	{
+		read(aovs.Albedo);
+	}
+
+	if (HasIdAov(aovImagesMask_))
+	{
+		read(aovs.Ids);
+	}
+
+	read(variance);
+
+	snapshotBufferMemory_->Unmap();
+
+	OnAccumulationSnapshot(snapshotExtent_, std::move(accumulation), std::move(variance), std::move(aovs));
+}
+
+std::vector<std::pair<const Image*, VkDeviceSize>> Application::SnapshotImages() const
+{
+	// Largest texels first, so that each image is copied at an offset that is a multiple of its texel size.
+	std::vector<std::pair<const Image*, VkDeviceSize>> images =
+	{
+		{ accumulationImage_.get(), sizeof(glm::vec4) }
+	};
+
+	if (HasNormalDepthAov(aovImagesMask_))
+	{
+		images.emplace_back(aovNormalDepthImage_.get(), sizeof(glm::vec4));
+	}
+
+	if (HasAlbedoAov(aovImagesMask_))
+	{
+		images.emplace_back(aovAlbedoImage_.get(), sizeof(glm::vec4));
+	}
+
+	if (HasIdAov(aovImagesMask_))
+	{
+		images.emplace_back(aovIdImage_.get(), sizeof(glm::uvec2));
+	}
+
+	images.emplace_back(varianceImage_.get(), sizeof(float));
+
+	return images;
+}
+
+std::vector<uint8_t> Application::ReadColorImage(const Image& image, const uint32_t viewCount)
+{
+	const auto extent = RenderExtent();
+	const size_t viewSize = static_cast<size_t>(extent.width) * extent.height * 4;
+
+	Buffer stagingBuffer(Device(), viewSize * viewCount, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	auto stagingBufferMemory = stagingBuffer.AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	Device().WaitIdle();
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = viewCount;
+
+		ImageMemoryBarrier::Insert(commandBuffer, image.Handle(), subresourceRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		VkBufferImageCopy copyRegion = {};
+		copyRegion.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, viewCount };
+		copyRegion.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, image.Handle(), VK_IMAGE_LAYOUT_GENERAL, stagingBuffer.Handle(), 1, &copyRegion);
+	});
+
+	std::vector<uint8_t> pixels(viewSize * viewCount);
+
+	const auto data = stagingBufferMemory.Map(0, pixels.size());
+	std::memcpy(pixels.data(), data, pixels.size());
+	stagingBufferMemory.Unmap();
+
+	// The output images have the format of the swap chain, which is usually BGRA, and their alpha is left at zero.
+	const auto format = image.Format();
+	const bool isBgra = format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		if (isBgra)
+		{
+			std::swap(pixels[i], pixels[i + 2]);
+		}
+
+		pixels[i + 3] = 255;
+	}
+
+	return pixels;
+}
+
+void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
+{
+	const auto& scene = GetScene();
+	const auto& debugUtils = Device().DebugUtils();
+	
+	// Bottom level acceleration structure
+	// Triangles via vertex buffers. Procedurals via AABBs.
+	uint32_t vertexOffset = 0;
+	uint32_t indexOffset = 0;
+	uint32_t aabbOffset = 0;
+
+	for (const auto& model : scene.Models())
+	{
+		const auto vertexCount = static_cast<uint32_t>(model.NumberOfVertices());
+		const auto indexCount = static_cast<uint32_t>(model.NumberOfIndices());
+		BottomLevelGeometry geometries;
+		
+		model.Procedural()
+			? geometries.AddGeometryAabb(scene, aabbOffset, 1, true)
+			: geometries.AddGeometryTriangles(scene, vertexOffset, vertexCount, indexOffset, indexCount, true);
+
+		bottomAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, geometries);
+
+		vertexOffset += vertexCount * sizeof(Assets::Vertex);
+		indexOffset += indexCount * sizeof(uint32_t);
+		aabbOffset += sizeof(VkAabbPositionsKHR);
+	}
+
+	// Allocate the structures memory.
+	const auto total = GetTotalRequirements(bottomAs_);
+
+	bottomBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT));
+	bottomBufferMemory_.reset(new DeviceMemory(bottomBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	bottomScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	bottomScratchBufferMemory_.reset(new DeviceMemory(bottomScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	debugUtils.SetObjectName(bottomBuffer_->Handle(), "BLAS Buffer");
+	debugUtils.SetObjectName(bottomBufferMemory_->Handle(), "BLAS Memory");
+	debugUtils.SetObjectName(bottomScratchBuffer_->Handle(), "BLAS Scratch Buffer");
+	debugUtils.SetObjectName(bottomScratchBufferMemory_->Handle(), "BLAS Scratch Memory");
+
+	// Generate the structures.
+	VkDeviceSize resultOffset = 0;
+	VkDeviceSize scratchOffset = 0;
+
+	for (size_t i = 0; i != bottomAs_.size(); ++i)
+	{
+		bottomAs_[i].Generate(commandBuffer, *bottomScratchBuffer_, scratchOffset, *bottomBuffer_, resultOffset);
+		
+		resultOffset += bottomAs_[i].BuildSizes().accelerationStructureSize;
+		scratchOffset += bottomAs_[i].BuildSizes().buildScratchSize;
+
+		debugUtils.SetObjectName(bottomAs_[i].Handle(), ("BLAS #" + std::to_string(i)).c_str());
+	}
+}
+
+void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
+{
+	const auto& scene = GetScene();
+	const auto& debugUtils = Device().DebugUtils();
+
+	// Top level acceleration structure
+	std::vector<VkAccelerationStructureInstanceKHR> instances;
+
+	// Each instance selects the hit group of its geometry type, specialised for its material model when all its materials share it.
+	uint32_t instanceId = 0;
+
+	for (const auto& model : scene.Models())
+	{
+		const auto hitGroupOffset = RayTracingPipeline::HitGroupOffset(model.Procedural() != nullptr, model.SharedMaterialModel());
+
+		instances.push_back(TopLevelAccelerationStructure::CreateInstance(
+			bottomAs_[instanceId], glm::mat4(1), instanceId, hitGroupOffset));
+		instanceId++;
+	}
+
+	// Create and copy instances buffer (do it in a separate one-time synchronous command buffer).
+	BufferUtil::CreateDeviceBuffer(CommandPool(), "TLAS Instances", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, instances, instancesBuffer_, instancesBufferMemory_);
+
+	// Memory barrier for the bottom level acceleration structure builds.
+	AccelerationStructure::MemoryBarrier(commandBuffer);
+	
+	topAs_.emplace_back(*deviceProcedures_, *rayTracingProperties_, instancesBuffer_->GetDeviceAddress(), static_cast<uint32_t>(instances.size()));
+
+	// Allocate the structure memory.
+	const auto total = GetTotalRequirements(topAs_);
+
+	topBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR));
+	topBufferMemory_.reset(new DeviceMemory(topBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	topScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	topScratchBufferMemory_.reset(new DeviceMemory(topScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	
+	debugUtils.SetObjectName(topBuffer_->Handle(), "TLAS Buffer");
+	debugUtils.SetObjectName(topBufferMemory_->Handle(), "TLAS Memory");
+	debugUtils.SetObjectName(topScratchBuffer_->Handle(), "TLAS Scratch Buffer");
+	debugUtils.SetObjectName(topScratchBufferMemory_->Handle(), "TLAS Scratch Memory");
+	debugUtils.SetObjectName(instancesBuffer_->Handle(), "TLAS Instances Buffer");
+	debugUtils.SetObjectName(instancesBufferMemory_->Handle(), "TLAS Instances Memory");
+
+	// Generate the structures.
+	topAs_[0].Generate(commandBuffer, *topScratchBuffer_, 0, *topBuffer_, 0);
+
+	debugUtils.SetObjectName(topAs_[0].Handle(), "TLAS");
+}
+
+void Application::CreateBandBuffers()
+{
+	if (!bandBuffers_.empty())
+	{
+		return;
+	}
+
+	const VkDeviceSize size = BandBufferRowPitch() * SwapChain().Extent().height;
+
+	for (size_t i = 0; i != UniformBuffers().size(); ++i)
+	{
+		bandBuffers_.emplace_back(new Buffer(Device(), size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+		bandBufferMemories_.emplace_back(new DeviceMemory(bandBuffers_.back()->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	}
+}
+
+void Application::CreateOutputImage()
+{
+	const auto extent = SwapChain().Extent();
+	const auto format = SwapChain().Format();
+	const auto tiling = VK_IMAGE_TILING_OPTIMAL;
+
+	accumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+	accumulationImageMemory_.reset(new DeviceMemory(accumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	accumulationImageView_.reset(new ImageView(Device(), accumulationImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	outputImage_.reset(new Image(Device(), extent, format, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+	outputImageMemory_.reset(new DeviceMemory(outputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	outputImageView_.reset(new ImageView(Device(), outputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	varianceImage_.reset(new Image(Device(), extent, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+	varianceImageMemory_.reset(new DeviceMemory(varianceImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	varianceImageView_.reset(new ImageView(Device(), varianceImage_->Handle(), VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	albedoImage_.reset(new Image(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
+	albedoImageMemory_.reset(new DeviceMemory(albedoImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	albedoImageView_.reset(new ImageView(Device(), albedoImage_->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	normalDepthImage_.reset(new Image(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+	normalDepthImageMemory_.reset(new DeviceMemory(normalDepthImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	normalDepthImageView_.reset(new ImageView(Device(), normalDepthImage_->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	const auto historyUsage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	accumulationHistoryImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, historyUsage));
+	accumulationHistoryImageMemory_.reset(new DeviceMemory(accumulationHistoryImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	accumulationHistoryImageView_.reset(new ImageView(Device(), accumulationHistoryImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	varianceHistoryImage_.reset(new Image(Device(), extent, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, historyUsage));
+	varianceHistoryImageMemory_.reset(new DeviceMemory(varianceHistoryImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	varianceHistoryImageView_.reset(new ImageView(Device(), varianceHistoryImage_->Handle(), VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	normalDepthHistoryImage_.reset(new Image(Device(), extent, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, historyUsage));
+	normalDepthHistoryImageMemory_.reset(new DeviceMemory(normalDepthHistoryImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	normalDepthHistoryImageView_.reset(new ImageView(Device(), normalDepthHistoryImage_->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	const auto& debugUtils = Device().DebugUtils();
+	
+	debugUtils.SetObjectName(accumulationImage_->Handle(), "Accumulation Image");
+	debugUtils.SetObjectName(accumulationImageMemory_->Handle(), "Accumulation Image Memory");
+	debugUtils.SetObjectName(accumulationImageView_->Handle(), "Accumulation ImageView");
+	
+	debugUtils.SetObjectName(outputImage_->Handle(), "Output Image");
+	debugUtils.SetObjectName(outputImageMemory_->Handle(), "Output Image Memory");
+	debugUtils.SetObjectName(outputImageView_->Handle(), "Output ImageView");
+
+	debugUtils.SetObjectName(varianceImage_->Handle(), "Variance Image");
+	debugUtils.SetObjectName(varianceImageMemory_->Handle(), "Variance Image Memory");
+	debugUtils.SetObjectName(varianceImageView_->Handle(), "Variance ImageView");
+
+	debugUtils.SetObjectName(albedoImage_->Handle(), "Albedo Image");
+	debugUtils.SetObjectName(albedoImageMemory_->Handle(), "Albedo Image Memory");
+	debugUtils.SetObjectName(albedoImageView_->Handle(), "Albedo ImageView");
+
+	debugUtils.SetObjectName(normalDepthImage_->Handle(), "Normal Depth Image");
+	debugUtils.SetObjectName(normalDepthImageMemory_->Handle(), "Normal Depth Image Memory");
+	debugUtils.SetObjectName(normalDepthImageView_->Handle(), "Normal Depth ImageView");
+
+	debugUtils.SetObjectName(accumulationHistoryImage_->Handle(), "Accumulation History Image");
+	debugUtils.SetObjectName(accumulationHistoryImageMemory_->Handle(), "Accumulation History Image Memory");
+	debugUtils.SetObjectName(accumulationHistoryImageView_->Handle(), "Accumulation History ImageView");
+
+	debugUtils.SetObjectName(varianceHistoryImage_->Handle(), "Variance History Image");
+	debugUtils.SetObjectName(varianceHistoryImageMemory_->Handle(), "Variance History Image Memory");
+	debugUtils.SetObjectName(varianceHistoryImageView_->Handle(), "Variance History ImageView");
+
+	debugUtils.SetObjectName(normalDepthHistoryImage_->Handle(), "Normal Depth History Image");
+	debugUtils.SetObjectName(normalDepthHistoryImageMemory_->Handle(), "Normal Depth History Image Memory");
+	debugUtils.SetObjectName(normalDepthHistoryImageView_->Handle(), "Normal Depth History ImageView");
+
+}
+
+void Application::CreateBatchImages()
+{
+	// Outside of batch mode, the batch images and cameras are placeholders that only keep the descriptors valid.
+	const auto extent = batchModelViews_.empty() ? VkExtent2D{ 1, 1 } : SwapChain().Extent();
+	const auto format = SwapChain().Format();
+	const auto viewCount = std::max<uint32_t>(1, static_cast<uint32_t>(batchModelViews_.size()));
+
+	batchAccumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT, viewCount));
+	batchAccumulationImageMemory_.reset(new DeviceMemory(batchAccumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	batchAccumulationImageView_.reset(new ImageView(Device(), batchAccumulationImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_2D_ARRAY, viewCount));
+
+	batchOutputImage_.reset(new Image(Device(), extent, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, viewCount));
+	batchOutputImageMemory_.reset(new DeviceMemory(batchOutputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	batchOutputImageView_.reset(new ImageView(Device(), batchOutputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_2D_ARRAY, viewCount));
+
+	// The shaders only need the camera to world transform of each view.
+	std::vector<glm::mat4> modelViewInverses(viewCount, glm::mat4(1));
+	std::transform(batchModelViews_.begin(), batchModelViews_.end(), modelViewInverses.begin(), [](const glm::mat4& modelView)
+	{
+		return glm::inverse(modelView);
+	});
+
+	BufferUtil::CreateDeviceBuffer(CommandPool(), "Batch Cameras", VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, modelViewInverses, batchCameraBuffer_, batchCameraBufferMemory_);
+
+	const auto& debugUtils = Device().DebugUtils();
+
+	debugUtils.SetObjectName(batchAccumulationImage_->Handle(), "Batch Accumulation Image");
+	debugUtils.SetObjectName(batchAccumulationImageMemory_->Handle(), "Batch Accumulation Image Memory");
+	debugUtils.SetObjectName(batchAccumulationImageView_->Handle(), "Batch Accumulation ImageView");
+
+	debugUtils.SetObjectName(batchOutputImage_->Handle(), "Batch Output Image");
+	debugUtils.SetObjectName(batchOutputImageMemory_->Handle(), "Batch Output Image Memory");
+	debugUtils.SetObjectName(batchOutputImageView_->Handle(), "Batch Output ImageView");
+}
+
+void Application::CreateAovImages()
+{
+	// The AOV images that are not selected are placeholders that only keep the descriptors valid.
+	const auto usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	const auto extent = [this](const bool isSelected) { return isSelected ? SwapChain().Extent() : VkExtent2D{ 1, 1 }; };
+
+	aovImagesMask_ = aovMask_;
+
+	aovNormalDepthImage_.reset(new Image(Device(), extent(HasNormalDepthAov(aovImagesMask_)), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, usage));
+	aovNormalDepthImageMemory_.reset(new DeviceMemory(aovNormalDepthImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	aovNormalDepthImageView_.reset(new ImageView(Device(), aovNormalDepthImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	aovAlbedoImage_.reset(new Image(Device(), extent(HasAlbedoAov(aovImagesMask_)), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, usage));
+	aovAlbedoImageMemory_.reset(new DeviceMemory(aovAlbedoImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	aovAlbedoImageView_.reset(new ImageView(Device(), aovAlbedoImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	aovIdImage_.reset(new Image(Device(), extent(HasIdAov(aovImagesMask_)), VK_FORMAT_R32G32_UINT, VK_IMAGE_TILING_OPTIMAL, usage));
+	aovIdImageMemory_.reset(new DeviceMemory(aovIdImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	aovIdImageView_.reset(new ImageView(Device(), aovIdImage_->Handle(), VK_FORMAT_R32G32_UINT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	// Transitioned once and cleared, the frames then keep their layout and contents.
+	SingleTimeCommands::Submit(CommandPool(), [this](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		const VkClearColorValue clearColor = {};
+
+		for (const auto& image : { aovNormalDepthImage_.get(), aovAlbedoImage_.get(), aovIdImage_.get() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdClearColorImage(commandBuffer, image->Handle(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		}
+	});
+
+	const auto& debugUtils = Device().DebugUtils();
+
+	debugUtils.SetObjectName(aovNormalDepthImage_->Handle(), "AOV Normal Depth Image");
+	debugUtils.SetObjectName(aovNormalDepthImageMemory_->Handle(), "AOV Normal Depth Image Memory");
+	debugUtils.SetObjectName(aovNormalDepthImageView_->Handle(), "AOV Normal Depth ImageView");
+
+	debugUtils.SetObjectName(aovAlbedoImage_->Handle(), "AOV Albedo Image");
+	debugUtils.SetObjectName(aovAlbedoImageMemory_->Handle(), "AOV Albedo Image Memory");
+	debugUtils.SetObjectName(aovAlbedoImageView_->Handle(), "AOV Albedo ImageView");
 
+	debugUtils.SetObjectName(aovIdImage_->Handle(), "AOV Id Image");
+	debugUtils.SetObjectName(aovIdImageMemory_->Handle(), "AOV Id Image Memory");
+	debugUtils.SetObjectName(aovIdImageView_->Handle(), "AOV Id ImageView");
 }
 
 }
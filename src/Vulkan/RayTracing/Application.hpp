@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Vulkan/Application.hpp"
+#include "PipelineVariant.hpp"
 #include "RayTracingProperties.hpp"
+#include "Utilities/Glm.hpp"
+#include <map>
 
 namespace Vulkan
 {
@@ -22,7 +25,7 @@ namespace Vulkan::RayTracing
 
 	protected:
 
-		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, bool enableValidationLayers);
+		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode);
 		~Application();
 
 		void SetPhysicalDevice(VkPhysicalDevice physicalDevice,
@@ -36,12 +39,125 @@ namespace Vulkan::RayTracing
 		void CreateSwapChain() override;
 		void DeleteSwapChain() override;
 		void Render(VkCommandBuffer commandBuffer, size_t currentFrame, uint32_t imageIndex) override;
+
+		// Number of screen tiles still above the adaptive sampling error target, as of the last completed frame.
+		uint32_t NumberOfActiveSampleTiles() const { return activeSampleTiles_; }
+		uint32_t NumberOfSampleTiles() const;
+
+		// Average number of rays traced per path (shadow rays excluded), as of the last completed frame.
+		float MeanPathLength() const { return meanPathLength_; }
+
+		// Filter the output with the given number of a-trous iterations (see DenoiserPipeline).
+		bool denoise_{};
+		uint32_t denoiserIterations_{};
+
+		// Reproject the accumulated samples from the previous view instead of reading them in place.
+		bool reprojectAccumulation_{};
+
+		// Ratio of the ray traced resolution to the swap-chain resolution. The images keep the swap-chain size, only
+		// their top left corner is rendered to, and it gets upscaled to the whole window (see UpscalerPipeline).
+		float renderScale_{1};
+		VkExtent2D RenderExtent() const;
+
+		// Only one pixel in interleaveRate_ is traced, the empty ones are filled in from their neighbours (see ReconstructionPipeline).
+		uint32_t interleaveRate_{1};
+
+		// Feature switches of the ray tracing shaders, the matching pipeline variant is selected when rendering.
+		PipelineVariant pipelineVariant_{};
+
+		// Trace the paths with the wavefront compute kernels instead of the ray tracing pipeline (see WavefrontPipeline).
+		// The kernels trace one sample per pixel at a time, wavefrontSamples_ times per frame.
+		bool wavefront_{};
+		uint32_t wavefrontSamples_{1};
+
+		// Rows [FirstRow, FirstRow + RowCount) of the rendered frame.
+		struct FrameBand final
+		{
+			uint32_t FirstRow;
+			uint32_t RowCount;
+		};
+
+		// Split-frame rendering (see RayTracer and PeerRenderer): the megakernel only traces the trace band, or the whole
+		// frame when it has no rows. The upload bands are then copied into the output image from the band buffer of the frame
+		// (presenting device), and the trace band is copied back to it (peer devices, readBackBand_). The band buffers are
+		// host visible copies of the output image, one per frame in flight.
+		FrameBand traceBand_{};
+		std::vector<FrameBand> uploadBands_;
+		bool readBackBand_{};
+
+		void* MapBandBuffer(size_t currentFrame);
+		void UnmapBandBuffer(size_t currentFrame);
+		VkDeviceSize BandBufferRowPitch() const;
+
+		// Rows traced per second by the megakernel in the last completed frame, measured with GPU timestamps (zero if unknown).
+		double TraceRowRate() const { return traceRowRate_; }
+
+		// Batch rendering (see RayTracer::SetBatchViews): with the BatchViews pipeline variant, the megakernel launch has one
+		// layer per batch camera, and traces all their views at once into the layers of the batch images. The shown view is
+		// copied into the output image for display. The cameras are only read when the swap chain is created.
+		std::vector<glm::mat4> batchModelViews_;
+		uint32_t batchViewShown_{};
+
+		// First hit AOVs written by the megakernel (see PipelineVariant::AovBits), overriding the AovMask of the pipeline
+		// variant. The AOV images of the other ones are placeholders, the mask is only read when the swap chain is created.
+		uint32_t aovMask_{};
+
+		// Read back with the accumulation snapshots, left empty when not selected by aovMask_.
+		struct AovSnapshot final
+		{
+			std::vector<glm::vec4> NormalDepth; // world normal, distance along the camera ray
+			std::vector<glm::vec4> Albedo;
+			std::vector<glm::uvec2> Ids; // instance, material (~0 on the background)
+		};
+
+		// Wait for the device, then read back the output of all the batch views as RGBA8, one view after the other.
+		std::vector<uint8_t> ReadBatchViews();
+
+		// Wait for the device, then read back the traced part of the output image as RGBA8.
+		std::vector<uint8_t> ReadOutputImage();
+
+		// Wait for the device, then read back the given rows of the accumulation image (radiance sums, sample count in alpha).
+		std::vector<glm::vec4> ReadAccumulationRows(FrameBand band);
+
+		// Accumulation snapshots, read back without stalling: the render extent of the accumulation and variance images is
+		// copied into a host visible buffer at the end of the next frame, and handed over to OnAccumulationSnapshot once that
+		// frame has completed, together with the selected AOVs. Only one snapshot is in flight at a time, and a pending one
+		// is dropped with the swap chain.
+		void RequestAccumulationSnapshot();
+		bool IsAccumulationSnapshotPending() const { return snapshotRequested_ || snapshotPending_; }
+		virtual void OnAccumulationSnapshot(VkExtent2D extent, std::vector<glm::vec4>&& accumulation, std::vector<float>&& variance, AovSnapshot&& aovs) { }
+
+		// Wait for the device, then upload a snapshot of the render extent into the accumulation and variance images.
+		void RestoreAccumulation(const std::vector<glm::vec4>& accumulation, const std::vector<float>& variance);
 			   
 	private:
 
+		void CopyHistory(VkCommandBuffer commandBuffer);
+		void ResetFrameCounters(VkCommandBuffer commandBuffer);
+		void SetPipelineVariant(const PipelineVariant& variant);
+		void RasterizeVisibility(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void TraceMegakernel(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void TraceWavefront(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void UpdateSampleBudgets(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void Denoise(VkCommandBuffer commandBuffer);
+		void Reconstruct(VkCommandBuffer commandBuffer);
+		void Upscale(VkCommandBuffer commandBuffer);
+		void UploadBands(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void ReadBackBand(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void ReadTraceTime(size_t currentFrame);
+		void CopyBatchView(VkCommandBuffer commandBuffer);
+		void CopySnapshot(VkCommandBuffer commandBuffer, size_t currentFrame);
+		void ReadSnapshot(size_t currentFrame);
+		std::vector<std::pair<const Image*, VkDeviceSize>> SnapshotImages() const;
+		std::vector<uint8_t> ReadColorImage(const Image& image, uint32_t viewCount);
+
+		void CreateBandBuffers();
+
 		void CreateBottomLevelStructures(VkCommandBuffer commandBuffer);
 		void CreateTopLevelStructures(VkCommandBuffer commandBuffer);
 		void CreateOutputImage();
+		void CreateBatchImages();
+		void CreateAovImages();
 
 		std::unique_ptr<class DeviceProcedures> deviceProcedures_;
 		std::unique_ptr<class RayTracingProperties> rayTracingProperties_;
@@ -66,9 +182,84 @@ namespace Vulkan::RayTracing
 		std::unique_ptr<Image> outputImage_;
 		std::unique_ptr<DeviceMemory> outputImageMemory_;
 		std::unique_ptr<ImageView> outputImageView_;
+
+		std::unique_ptr<Image> varianceImage_;
+		std::unique_ptr<DeviceMemory> varianceImageMemory_;
+		std::unique_ptr<ImageView> varianceImageView_;
+
+		std::unique_ptr<Image> albedoImage_;
+		std::unique_ptr<DeviceMemory> albedoImageMemory_;
+		std::unique_ptr<ImageView> albedoImageView_;
+
+		std::unique_ptr<Image> normalDepthImage_;
+		std::unique_ptr<DeviceMemory> normalDepthImageMemory_;
+		std::unique_ptr<ImageView> normalDepthImageView_;
+
+		std::unique_ptr<Image> accumulationHistoryImage_;
+		std::unique_ptr<DeviceMemory> accumulationHistoryImageMemory_;
+		std::unique_ptr<ImageView> accumulationHistoryImageView_;
+
+		std::unique_ptr<Image> varianceHistoryImage_;
+		std::unique_ptr<DeviceMemory> varianceHistoryImageMemory_;
+		std::unique_ptr<ImageView> varianceHistoryImageView_;
+
+		std::unique_ptr<Image> normalDepthHistoryImage_;
+		std::unique_ptr<DeviceMemory> normalDepthHistoryImageMemory_;
+		std::unique_ptr<ImageView> normalDepthHistoryImageView_;
+
+		std::unique_ptr<Image> batchAccumulationImage_;
+		std::unique_ptr<DeviceMemory> batchAccumulationImageMemory_;
+		std::unique_ptr<ImageView> batchAccumulationImageView_;
+
+		std::unique_ptr<Image> batchOutputImage_;
+		std::unique_ptr<DeviceMemory> batchOutputImageMemory_;
+		std::unique_ptr<ImageView> batchOutputImageView_;
+
+		std::unique_ptr<Buffer> batchCameraBuffer_;
+		std::unique_ptr<DeviceMemory> batchCameraBufferMemory_;
+
+		std::unique_ptr<Image> aovNormalDepthImage_;
+		std::unique_ptr<DeviceMemory> aovNormalDepthImageMemory_;
+		std::unique_ptr<ImageView> aovNormalDepthImageView_;
+
+		std::unique_ptr<Image> aovAlbedoImage_;
+		std::unique_ptr<DeviceMemory> aovAlbedoImageMemory_;
+		std::unique_ptr<ImageView> aovAlbedoImageView_;
+
+		std::unique_ptr<Image> aovIdImage_;
+		std::unique_ptr<DeviceMemory> aovIdImageMemory_;
+		std::unique_ptr<ImageView> aovIdImageView_;
+		uint32_t aovImagesMask_{};
+
+		std::unique_ptr<Buffer> snapshotBuffer_;
+		std::unique_ptr<DeviceMemory> snapshotBufferMemory_;
+		VkExtent2D snapshotExtent_{};
+		size_t snapshotFrame_{};
+		bool snapshotRequested_{};
+		bool snapshotPending_{};
+
+		std::unique_ptr<class AdaptiveSamplingPipeline> adaptiveSamplingPipeline_;
+		uint32_t activeSampleTiles_{};
+		float meanPathLength_{};
+
+		std::unique_ptr<class DenoiserPipeline> denoiserPipeline_;
+		std::unique_ptr<class ReconstructionPipeline> reconstructionPipeline_;
+		std::unique_ptr<class UpscalerPipeline> upscalerPipeline_;
+		std::unique_ptr<class VisibilityPipeline> visibilityPipeline_;
 		
 		std::unique_ptr<class RayTracingPipeline> rayTracingPipeline_;
-		std::unique_ptr<class ShaderBindingTable> shaderBindingTable_;
+		std::map<PipelineVariant, std::unique_ptr<class ShaderBindingTable>> shaderBindingTables_;
+		const class ShaderBindingTable* shaderBindingTable_{};
+
+		std::unique_ptr<class WavefrontPipeline> wavefrontPipeline_;
+
+		std::vector<std::unique_ptr<Buffer>> bandBuffers_;
+		std::vector<std::unique_ptr<DeviceMemory>> bandBufferMemories_;
+
+		// Two timestamps per frame in flight around the megakernel trace, and the number of rows it traced.
+		VkQueryPool traceQueryPool_{};
+		std::vector<uint32_t> traceRows_;
+		double traceRowRate_{};
 	};
 
 }
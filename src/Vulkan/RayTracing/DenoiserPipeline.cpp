@@ -0,0 +1,145 @@
+#include "DenoiserPipeline.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SwapChain.hpp"
+#include <string>
+
+namespace Vulkan::RayTracing {
+
+DenoiserPipeline::DenoiserPipeline(
+	const SwapChain& swapChain,
+	const ImageView& accumulationImageView,
+	const ImageView& varianceImageView,
+	const ImageView& albedoImageView,
+	const ImageView& normalDepthImageView,
+	const ImageView& outputImageView) :
+	swapChain_(swapChain)
+{
+	const auto& device = swapChain.Device();
+	const auto& debugUtils = device.DebugUtils();
+
+	// Intermediate images: filtered illumination + variance.
+	for (size_t i = 0; i != filterImages_.size(); ++i)
+	{
+		filterImages_[i].reset(new Image(device, swapChain.Extent(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
+		filterImageMemories_[i].reset(new DeviceMemory(filterImages_[i]->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+		filterImageViews_[i].reset(new ImageView(device, filterImages_[i]->Handle(), VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+
+		debugUtils.SetObjectName(filterImages_[i]->Handle(), ("Denoiser Image #" + std::to_string(i)).c_str());
+		debugUtils.SetObjectName(filterImageMemories_[i]->Handle(), ("Denoiser Image Memory #" + std::to_string(i)).c_str());
+		debugUtils.SetObjectName(filterImageViews_[i]->Handle(), ("Denoiser ImageView #" + std::to_string(i)).c_str());
+	}
+
+	// Create descriptor pool/sets.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Accumulation & variance images
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Albedo & normal/depth guides
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Intermediate images & output
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto imageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const VkDescriptorImageInfo imageInfos[] =
+	{
+		imageInfo(accumulationImageView),
+		imageInfo(varianceImageView),
+		imageInfo(albedoImageView),
+		imageInfo(normalDepthImageView),
+		imageInfo(*filterImageViews_[0]),
+		imageInfo(*filterImageViews_[1]),
+		imageInfo(outputImageView)
+	};
+
+	std::vector<VkWriteDescriptorSet> descriptorWrites;
+
+	for (uint32_t binding = 0; binding != std::size(imageInfos); ++binding)
+	{
+		descriptorWrites.push_back(descriptorSets.Bind(0, binding, imageInfos[binding]));
+	}
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	// Load shaders.
+	const ShaderModule computeShader(device, "../assets/shaders/Denoiser.comp.spv");
+
+	// Create compute pipeline
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+		"create denoiser pipeline");
+}
+
+DenoiserPipeline::~DenoiserPipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+
+	for (size_t i = 0; i != filterImages_.size(); ++i)
+	{
+		filterImageViews_[i].reset();
+		filterImages_[i].reset();
+		filterImageMemories_[i].reset(); // release memory after bound image has been destroyed
+	}
+}
+
+VkDescriptorSet DenoiserPipeline::DescriptorSet() const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(0);
+}
+
+DenoiserPipeline::PushConstants DenoiserPipeline::GetPushConstants(const uint32_t iteration, const uint32_t iterationCount, const VkExtent2D extent)
+{
+	// The first iteration reads the accumulation image, the last one writes the output image.
+	PushConstants pushConstants = {};
+	pushConstants.StepWidth = 1u << iteration;
+	pushConstants.Source = iteration == 0 ? 0 : 1 + ((iteration - 1) & 1);
+	pushConstants.Target = iteration + 1 == iterationCount ? 0 : 1 + (iteration & 1);
+	pushConstants.Width = extent.width;
+	pushConstants.Height = extent.height;
+	return pushConstants;
+}
+
+}
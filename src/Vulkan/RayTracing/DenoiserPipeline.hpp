@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <array>
+#include <memory>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+	class PipelineLayout;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Compute pipeline filtering the accumulated image with an edge-avoiding a-trous wavelet filter guided by the first
+	// hit albedo, normal and depth (see Denoiser.comp). Each iteration is a dispatch with twice the step width of the
+	// previous one, ping-ponging between two intermediate images, and the last one writes the output image.
+	class DenoiserPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(DenoiserPipeline)
+
+		// Must match Denoiser.comp.
+		static constexpr uint32_t WorkGroupSize = 16;
+
+		struct PushConstants final
+		{
+			uint32_t StepWidth;
+			uint32_t Source;
+			uint32_t Target;
+			uint32_t Width;
+			uint32_t Height;
+		};
+
+		DenoiserPipeline(
+			const SwapChain& swapChain,
+			const ImageView& accumulationImageView,
+			const ImageView& varianceImageView,
+			const ImageView& albedoImageView,
+			const ImageView& normalDepthImageView,
+			const ImageView& outputImageView);
+		~DenoiserPipeline();
+
+		VkDescriptorSet DescriptorSet() const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+		const Image& FilterImage(size_t index) const { return *filterImages_[index]; }
+
+		// Source and target of the given filter iteration over the rendered area, see PushConstants.
+		static PushConstants GetPushConstants(uint32_t iteration, uint32_t iterationCount, VkExtent2D extent);
+
+	private:
+
+		const SwapChain& swapChain_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		std::array<std::unique_ptr<Image>, 2> filterImages_;
+		std::array<std::unique_ptr<DeviceMemory>, 2> filterImageMemories_;
+		std::array<std::unique_ptr<ImageView>, 2> filterImageViews_;
+	};
+
+}
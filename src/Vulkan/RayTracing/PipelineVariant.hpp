@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+namespace Vulkan::RayTracing
+{
+
+	// Feature switches compiled into the ray tracing shaders as specialization constants 1 to 8, in this order
+	// (see PipelineVariant.glsl). Each combination is compiled once and cached by RayTracingPipeline and WavefrontPipeline.
+	struct PipelineVariant final
+	{
+		uint32_t NumberOfBounces{16};
+		uint32_t HasSky{true}; // bool
+		uint32_t ShowHeatmap{false}; // bool
+		uint32_t NextEventEstimation{true}; // bool
+		uint32_t RussianRoulette{true}; // bool
+		uint32_t HybridPrimary{false}; // bool, the first hits come from the visibility buffer (see VisibilityPipeline)
+		uint32_t BatchViews{false}; // bool, each launch layer traces the view of one batch camera into its own image layer
+		uint32_t AovMask{0}; // AovBits, the first hit AOVs written by the megakernel into the AOV images
+
+		// First hit arbitrary output variables (see RayTracing.rgen).
+		enum AovBits : uint32_t
+		{
+			AovDepth = 1,
+			AovNormal = 2,
+			AovAlbedo = 4,
+			AovInstanceId = 8,
+			AovMaterialId = 16
+		};
+
+		static std::array<VkSpecializationMapEntry, 8> GetSpecializationMapEntries()
+		{
+			return
+			{{
+				{ 1, offsetof(PipelineVariant, NumberOfBounces), sizeof(uint32_t) },
+				{ 2, offsetof(PipelineVariant, HasSky), sizeof(uint32_t) },
+				{ 3, offsetof(PipelineVariant, ShowHeatmap), sizeof(uint32_t) },
+				{ 4, offsetof(PipelineVariant, NextEventEstimation), sizeof(uint32_t) },
+				{ 5, offsetof(PipelineVariant, RussianRoulette), sizeof(uint32_t) },
+				{ 6, offsetof(PipelineVariant, HybridPrimary), sizeof(uint32_t) },
+				{ 7, offsetof(PipelineVariant, BatchViews), sizeof(uint32_t) },
+				{ 8, offsetof(PipelineVariant, AovMask), sizeof(uint32_t) }
+			}};
+		}
+
+		bool operator < (const PipelineVariant& other) const
+		{
+			return
+				std::tie(NumberOfBounces, HasSky, ShowHeatmap, NextEventEstimation, RussianRoulette, HybridPrimary, BatchViews, AovMask) <
+				std::tie(other.NumberOfBounces, other.HasSky, other.ShowHeatmap, other.NextEventEstimation, other.RussianRoulette, other.HybridPrimary, other.BatchViews, other.AovMask);
+		}
+	};
+
+}
@@ -13,6 +13,7 @@
 #include "Vulkan/PipelineLayout.hpp"
 #include "Vulkan/ShaderModule.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include <algorithm>
 
 namespace Vulkan::RayTracing {
 
@@ -22,8 +23,23 @@ RayTracingPipeline::RayTracingPipeline(
 	const TopLevelAccelerationStructure& accelerationStructure,
 	const ImageView& accumulationImageView,
 	const ImageView& outputImageView,
+	const ImageView& varianceImageView,
+	const ImageView& albedoImageView,
+	const ImageView& normalDepthImageView,
+	const ImageView& accumulationHistoryImageView,
+	const ImageView& varianceHistoryImageView,
+	const ImageView& normalDepthHistoryImageView,
+	const ImageView& visibilityImageView,
+	const ImageView& batchAccumulationImageView,
+	const ImageView& batchOutputImageView,
+	const ImageView& aovNormalDepthImageView,
+	const ImageView& aovAlbedoImageView,
+	const ImageView& aovIdImageView,
+	const Buffer& batchCameraBuffer,
+	const Buffer& sampleBudgetBuffer,
 	const std::vector<Assets::UniformBuffer>& uniformBuffers,
 	const Assets::Scene& scene) :
+	deviceProcedures_(deviceProcedures),
 	swapChain_(swapChain)
 {
 	// Create descriptor pool/sets.
@@ -38,19 +54,50 @@ RayTracingPipeline::RayTracingPipeline(
 		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
 
 		// Camera information & co
-		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR},
+		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
 
-		// Vertex buffer, Index buffer, Material buffer, Offset buffer
-		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
-		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
-		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
-		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		// Vertex buffer, Index buffer, Material buffer, Offset buffer (the ray generation shader shades the rasterized first hits)
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
 
 		// Textures and image samplers
-		{8, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+		{8, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
 
 		// The Procedural buffer.
-		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR}
+		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR},
+
+		// Emissive primitives for explicit light sampling, the light tree over them, and the primitive to light index tables.
+		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+
+		// Adaptive sampling budgets (see AdaptiveSamplingPipeline) & per-pixel variance accumulation.
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// First hit albedo & normal/depth, guiding the denoiser.
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Previous frame accumulation, variance & normal/depth, for temporal reprojection.
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{19, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Rasterized first hits, in hybrid mode (see VisibilityPipeline).
+		{20, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Batch views accumulation & output layers, and their cameras.
+		{21, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{22, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{23, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// First hit AOVs: normal & depth, albedo, instance & material ids.
+		{24, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{25, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{26, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR}
 	};
 
 	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
@@ -77,6 +124,61 @@ RayTracingPipeline::RayTracingPipeline(
 		outputImageInfo.imageView = outputImageView.Handle();
 		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
+		// Variance image
+		VkDescriptorImageInfo varianceImageInfo = {};
+		varianceImageInfo.imageView = varianceImageView.Handle();
+		varianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Albedo image
+		VkDescriptorImageInfo albedoImageInfo = {};
+		albedoImageInfo.imageView = albedoImageView.Handle();
+		albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Normal & depth image
+		VkDescriptorImageInfo normalDepthImageInfo = {};
+		normalDepthImageInfo.imageView = normalDepthImageView.Handle();
+		normalDepthImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// History images
+		VkDescriptorImageInfo accumulationHistoryImageInfo = {};
+		accumulationHistoryImageInfo.imageView = accumulationHistoryImageView.Handle();
+		accumulationHistoryImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo varianceHistoryImageInfo = {};
+		varianceHistoryImageInfo.imageView = varianceHistoryImageView.Handle();
+		varianceHistoryImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo normalDepthHistoryImageInfo = {};
+		normalDepthHistoryImageInfo.imageView = normalDepthHistoryImageView.Handle();
+		normalDepthHistoryImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Visibility image
+		VkDescriptorImageInfo visibilityImageInfo = {};
+		visibilityImageInfo.imageView = visibilityImageView.Handle();
+		visibilityImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Batch view images
+		VkDescriptorImageInfo batchAccumulationImageInfo = {};
+		batchAccumulationImageInfo.imageView = batchAccumulationImageView.Handle();
+		batchAccumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo batchOutputImageInfo = {};
+		batchOutputImageInfo.imageView = batchOutputImageView.Handle();
+		batchOutputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// AOV images
+		VkDescriptorImageInfo aovNormalDepthImageInfo = {};
+		aovNormalDepthImageInfo.imageView = aovNormalDepthImageView.Handle();
+		aovNormalDepthImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo aovAlbedoImageInfo = {};
+		aovAlbedoImageInfo.imageView = aovAlbedoImageView.Handle();
+		aovAlbedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo aovIdImageInfo = {};
+		aovIdImageInfo.imageView = aovIdImageView.Handle();
+		aovIdImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
 		// Uniform buffer
 		VkDescriptorBufferInfo uniformBufferInfo = {};
 		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
@@ -102,6 +204,31 @@ RayTracingPipeline::RayTracingPipeline(
 		offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
 		offsetsBufferInfo.range = VK_WHOLE_SIZE;
 
+		// Light buffer
+		VkDescriptorBufferInfo lightBufferInfo = {};
+		lightBufferInfo.buffer = scene.LightBuffer().Handle();
+		lightBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Light tree buffer
+		VkDescriptorBufferInfo lightTreeBufferInfo = {};
+		lightTreeBufferInfo.buffer = scene.LightTreeBuffer().Handle();
+		lightTreeBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Light index buffer
+		VkDescriptorBufferInfo lightIndexBufferInfo = {};
+		lightIndexBufferInfo.buffer = scene.LightIndexBuffer().Handle();
+		lightIndexBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Sample budget buffer
+		VkDescriptorBufferInfo sampleBudgetBufferInfo = {};
+		sampleBudgetBufferInfo.buffer = sampleBudgetBuffer.Handle();
+		sampleBudgetBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Batch camera buffer
+		VkDescriptorBufferInfo batchCameraBufferInfo = {};
+		batchCameraBufferInfo.buffer = batchCameraBuffer.Handle();
+		batchCameraBufferInfo.range = VK_WHOLE_SIZE;
+
 		// Image and texture samplers.
 		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
 
@@ -123,7 +250,24 @@ RayTracingPipeline::RayTracingPipeline(
 			descriptorSets.Bind(i, 5, indexBufferInfo),
 			descriptorSets.Bind(i, 6, materialBufferInfo),
 			descriptorSets.Bind(i, 7, offsetsBufferInfo),
-			descriptorSets.Bind(i, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
+			descriptorSets.Bind(i, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size())),
+			descriptorSets.Bind(i, 10, lightBufferInfo),
+			descriptorSets.Bind(i, 11, lightTreeBufferInfo),
+			descriptorSets.Bind(i, 12, lightIndexBufferInfo),
+			descriptorSets.Bind(i, 13, sampleBudgetBufferInfo),
+			descriptorSets.Bind(i, 14, varianceImageInfo),
+			descriptorSets.Bind(i, 15, albedoImageInfo),
+			descriptorSets.Bind(i, 16, normalDepthImageInfo),
+			descriptorSets.Bind(i, 17, accumulationHistoryImageInfo),
+			descriptorSets.Bind(i, 18, varianceHistoryImageInfo),
+			descriptorSets.Bind(i, 19, normalDepthHistoryImageInfo),
+			descriptorSets.Bind(i, 20, visibilityImageInfo),
+			descriptorSets.Bind(i, 21, batchAccumulationImageInfo),
+			descriptorSets.Bind(i, 22, batchOutputImageInfo),
+			descriptorSets.Bind(i, 23, batchCameraBufferInfo),
+			descriptorSets.Bind(i, 24, aovNormalDepthImageInfo),
+			descriptorSets.Bind(i, 25, aovAlbedoImageInfo),
+			descriptorSets.Bind(i, 26, aovIdImageInfo)
 		};
 
 		// Procedural buffer (optional)
@@ -142,21 +286,13 @@ RayTracingPipeline::RayTracingPipeline(
 
 	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
 
-	// Load shaders.
-	const ShaderModule rayGenShader(device, "../assets/shaders/RayTracing.rgen.spv");
-	const ShaderModule missShader(device, "../assets/shaders/RayTracing.rmiss.spv");
-	const ShaderModule closestHitShader(device, "../assets/shaders/RayTracing.rchit.spv");
-	const ShaderModule proceduralClosestHitShader(device, "../assets/shaders/RayTracing.Procedural.rchit.spv");
-	const ShaderModule proceduralIntersectionShader(device, "../assets/shaders/RayTracing.Procedural.rint.spv");
-
-	std::vector<VkPipelineShaderStageCreateInfo> shaderStages =
-	{
-		rayGenShader.CreateShaderStage(VK_SHADER_STAGE_RAYGEN_BIT_KHR),
-		missShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
-		closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
-		proceduralClosestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
-		proceduralIntersectionShader.CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR)
-	};
+	// Load shaders, the pipeline itself is only created once a variant is selected.
+	rayGenShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.rgen.spv"));
+	missShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.rmiss.spv"));
+	shadowMissShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.Shadow.rmiss.spv"));
+	closestHitShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.rchit.spv"));
+	proceduralClosestHitShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.Procedural.rchit.spv"));
+	proceduralIntersectionShader_.reset(new ShaderModule(device, "../assets/shaders/RayTracing.Procedural.rint.spv"));
 
 	// Shader groups
 	VkRayTracingShaderGroupCreateInfoKHR rayGenGroupInfo = {};
@@ -179,67 +315,178 @@ RayTracingPipeline::RayTracingPipeline(
 	missGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
 	missIndex_ = 1;
 
+	VkRayTracingShaderGroupCreateInfoKHR shadowMissGroupInfo = {};
+	shadowMissGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+	shadowMissGroupInfo.pNext = nullptr;
+	shadowMissGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
+	shadowMissGroupInfo.generalShader = 2;
+	shadowMissGroupInfo.closestHitShader = VK_SHADER_UNUSED_KHR;
+	shadowMissGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
+	shadowMissGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
+	shadowMissIndex_ = 2;
+
 	VkRayTracingShaderGroupCreateInfoKHR triangleHitGroupInfo = {};
 	triangleHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
 	triangleHitGroupInfo.pNext = nullptr;
 	triangleHitGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
 	triangleHitGroupInfo.generalShader = VK_SHADER_UNUSED_KHR;
-	triangleHitGroupInfo.closestHitShader = 2;
+	triangleHitGroupInfo.closestHitShader = 3;
 	triangleHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
 	triangleHitGroupInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
-	triangleHitGroupIndex_ = 2;
+	triangleHitGroupIndex_ = 3;
 
 	VkRayTracingShaderGroupCreateInfoKHR proceduralHitGroupInfo = {};
 	proceduralHitGroupInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
 	proceduralHitGroupInfo.pNext = nullptr;
 	proceduralHitGroupInfo.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_PROCEDURAL_HIT_GROUP_KHR;
 	proceduralHitGroupInfo.generalShader = VK_SHADER_UNUSED_KHR;
-	proceduralHitGroupInfo.closestHitShader = 3;
+	proceduralHitGroupInfo.closestHitShader = 4;
 	proceduralHitGroupInfo.anyHitShader = VK_SHADER_UNUSED_KHR;
-	proceduralHitGroupInfo.intersectionShader = 4;
-	proceduralHitGroupIndex_ = 3;
+	proceduralHitGroupInfo.intersectionShader = 5;
 
-	std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups =
+	groups_ =
 	{
 		rayGenGroupInfo, 
 		missGroupInfo, 
-		triangleHitGroupInfo, 
-		proceduralHitGroupInfo,
+		shadowMissGroupInfo,
+		triangleHitGroupInfo
 	};
 
-	// Create graphic pipeline
-	VkRayTracingPipelineCreateInfoKHR pipelineInfo = {};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
-	pipelineInfo.pNext = nullptr;
-	pipelineInfo.flags = 0;
-	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-	pipelineInfo.pStages = shaderStages.data();
-	pipelineInfo.groupCount = static_cast<uint32_t>(groups.size());
-	pipelineInfo.pGroups = groups.data();
-	pipelineInfo.maxPipelineRayRecursionDepth = 1;
-	pipelineInfo.layout = pipelineLayout_->Handle();
-	pipelineInfo.basePipelineHandle = nullptr;
-	pipelineInfo.basePipelineIndex = 0;
+	// Specialised triangle hit groups, then the procedural ones (see CreatePipeline() for the stage order).
+	for (uint32_t i = 0; i != SpecialisedMaterialModels.size(); ++i)
+	{
+		groups_.push_back(triangleHitGroupInfo);
+		groups_.back().closestHitShader = FirstSpecialisedStage + 2 * i;
+	}
 
-	Check(deviceProcedures.vkCreateRayTracingPipelinesKHR(device.Handle(), nullptr, nullptr, 1, &pipelineInfo, nullptr, &pipeline_), 
-		"create ray tracing pipeline");
+	proceduralHitGroupIndex_ = static_cast<uint32_t>(groups_.size());
+	groups_.push_back(proceduralHitGroupInfo);
+
+	for (uint32_t i = 0; i != SpecialisedMaterialModels.size(); ++i)
+	{
+		groups_.push_back(proceduralHitGroupInfo);
+		groups_.back().closestHitShader = FirstSpecialisedStage + 2 * i + 1;
+	}
+
+	SetVariant(PipelineVariant());
 }
 
 RayTracingPipeline::~RayTracingPipeline()
 {
-	if (pipeline_ != nullptr)
+	for (const auto& variant : variants_)
 	{
-		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
-		pipeline_ = nullptr;
+		vkDestroyPipeline(swapChain_.Device().Handle(), variant.second, nullptr);
 	}
 
+	variants_.clear();
+	pipeline_ = nullptr;
+
+	proceduralIntersectionShader_.reset();
+	proceduralClosestHitShader_.reset();
+	closestHitShader_.reset();
+	shadowMissShader_.reset();
+	missShader_.reset();
+	rayGenShader_.reset();
 	pipelineLayout_.reset();
 	descriptorSetManager_.reset();
 }
 
+void RayTracingPipeline::SetVariant(const PipelineVariant& variant)
+{
+	auto cached = variants_.find(variant);
+
+	if (cached == variants_.end())
+	{
+		cached = variants_.emplace(variant, CreatePipeline(variant)).first;
+	}
+
+	pipeline_ = cached->second;
+}
+
+uint32_t RayTracingPipeline::HitGroupOffset(const bool isProcedural, const std::optional<Assets::Material::Enum>& materialModel)
+{
+	const uint32_t geometryOffset = isProcedural ? HitGroupsPerGeometry : 0;
+
+	// Models mixing material models (or using one without a specialised hit group) fall back to the generic hit group.
+	if (!materialModel)
+	{
+		return geometryOffset;
+	}
+
+	const auto specialised = std::find(SpecialisedMaterialModels.begin(), SpecialisedMaterialModels.end(), *materialModel);
+
+	return specialised != SpecialisedMaterialModels.end()
+		? geometryOffset + 1 + static_cast<uint32_t>(specialised - SpecialisedMaterialModels.begin())
+		: geometryOffset;
+}
+
 VkDescriptorSet RayTracingPipeline::DescriptorSet(const size_t index) const
 {
 	return descriptorSetManager_->DescriptorSets().Handle(index);
 }
 
+VkPipeline RayTracingPipeline::CreatePipeline(const PipelineVariant& variant) const
+{
+	// The ray generation and miss shaders get the feature switches (see PipelineVariant.glsl).
+	const auto variantEntries = PipelineVariant::GetSpecializationMapEntries();
+
+	VkSpecializationInfo variantSpecialisation = {};
+	variantSpecialisation.mapEntryCount = static_cast<uint32_t>(variantEntries.size());
+	variantSpecialisation.pMapEntries = variantEntries.data();
+	variantSpecialisation.dataSize = sizeof(PipelineVariant);
+	variantSpecialisation.pData = &variant;
+
+	std::vector<VkPipelineShaderStageCreateInfo> shaderStages =
+	{
+		rayGenShader_->CreateShaderStage(VK_SHADER_STAGE_RAYGEN_BIT_KHR),
+		missShader_->CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
+		shadowMissShader_->CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
+		closestHitShader_->CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
+		proceduralClosestHitShader_->CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
+		proceduralIntersectionShader_->CreateShaderStage(VK_SHADER_STAGE_INTERSECTION_BIT_KHR)
+	};
+
+	shaderStages[0].pSpecializationInfo = &variantSpecialisation;
+	shaderStages[1].pSpecializationInfo = &variantSpecialisation;
+
+	// Closest hit shaders specialised for each material model, the generic ones above keep the default value.
+	const VkSpecializationMapEntry materialModelEntry = { 0, 0, sizeof(Assets::Material::Enum) };
+	std::array<VkSpecializationInfo, SpecialisedMaterialModels.size()> specialisations = {};
+
+	for (size_t i = 0; i != specialisations.size(); ++i)
+	{
+		specialisations[i].mapEntryCount = 1;
+		specialisations[i].pMapEntries = &materialModelEntry;
+		specialisations[i].dataSize = sizeof(Assets::Material::Enum);
+		specialisations[i].pData = &SpecialisedMaterialModels[i];
+
+		shaderStages.push_back(closestHitShader_->CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR));
+		shaderStages.back().pSpecializationInfo = &specialisations[i];
+
+		shaderStages.push_back(proceduralClosestHitShader_->CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR));
+		shaderStages.back().pSpecializationInfo = &specialisations[i];
+	}
+
+	// Create graphic pipeline
+	VkRayTracingPipelineCreateInfoKHR pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
+	pipelineInfo.pNext = nullptr;
+	pipelineInfo.flags = 0;
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.groupCount = static_cast<uint32_t>(groups_.size());
+	pipelineInfo.pGroups = groups_.data();
+	pipelineInfo.maxPipelineRayRecursionDepth = 1;
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = 0;
+
+	VkPipeline pipeline = nullptr;
+
+	Check(deviceProcedures_.vkCreateRayTracingPipelinesKHR(swapChain_.Device().Handle(), nullptr, nullptr, 1, &pipelineInfo, nullptr, &pipeline), 
+		"create ray tracing pipeline");
+
+	return pipeline;
+}
+
 }
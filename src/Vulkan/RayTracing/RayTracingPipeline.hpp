@@ -1,7 +1,12 @@
 #pragma once
 
 #include "Vulkan/Vulkan.hpp"
+#include "Assets/Material.hpp"
+#include "PipelineVariant.hpp"
+#include <array>
+#include <map>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace Assets
@@ -12,9 +17,11 @@ namespace Assets
 
 namespace Vulkan
 {
+	class Buffer;
 	class DescriptorSetManager;
 	class ImageView;
 	class PipelineLayout;
+	class ShaderModule;
 	class SwapChain;
 }
 
@@ -29,35 +36,87 @@ namespace Vulkan::RayTracing
 
 		VULKAN_NON_COPIABLE(RayTracingPipeline)
 
+		// Each geometry type has a generic hit group, which switches on the material model at run time, followed by one hit
+		// group specialised for each of these material models (see Scatter.glsl).
+		static constexpr std::array<Assets::Material::Enum, 4> SpecialisedMaterialModels =
+		{
+			Assets::Material::Enum::Lambertian,
+			Assets::Material::Enum::Metallic,
+			Assets::Material::Enum::Dielectric,
+			Assets::Material::Enum::DiffuseLight
+		};
+
+		static constexpr uint32_t HitGroupsPerGeometry = 1 + static_cast<uint32_t>(SpecialisedMaterialModels.size());
+
+		// Offset of the hit group to use for an instance, relative to the first hit group (see TriangleHitGroupIndex()).
+		static uint32_t HitGroupOffset(bool isProcedural, const std::optional<Assets::Material::Enum>& materialModel);
+
 		RayTracingPipeline(
 			const DeviceProcedures& deviceProcedures,
 			const SwapChain& swapChain,
 			const TopLevelAccelerationStructure& accelerationStructure,
 			const ImageView& accumulationImageView,
 			const ImageView& outputImageView,
+			const ImageView& varianceImageView,
+			const ImageView& albedoImageView,
+			const ImageView& normalDepthImageView,
+			const ImageView& accumulationHistoryImageView,
+			const ImageView& varianceHistoryImageView,
+			const ImageView& normalDepthHistoryImageView,
+			const ImageView& visibilityImageView,
+			const ImageView& batchAccumulationImageView,
+			const ImageView& batchOutputImageView,
+			const ImageView& aovNormalDepthImageView,
+			const ImageView& aovAlbedoImageView,
+			const ImageView& aovIdImageView,
+			const Buffer& batchCameraBuffer,
+			const Buffer& sampleBudgetBuffer,
 			const std::vector<Assets::UniformBuffer>& uniformBuffers,
 			const Assets::Scene& scene);
 		~RayTracingPipeline();
 
 		uint32_t RayGenShaderIndex() const { return rayGenIndex_; }
 		uint32_t MissShaderIndex() const { return missIndex_; }
+		uint32_t ShadowMissShaderIndex() const { return shadowMissIndex_; }
+		// First of the HitGroupsPerGeometry hit groups of each geometry type.
 		uint32_t TriangleHitGroupIndex() const { return triangleHitGroupIndex_; }
 		uint32_t ProceduralHitGroupIndex() const { return proceduralHitGroupIndex_; }
 
+		// Make Handle() return the pipeline compiled for the given feature switches. Each variant is only compiled the
+		// first time it is selected, and they all share the same shader groups and descriptor sets.
+		void SetVariant(const PipelineVariant& variant);
+
 		VkDescriptorSet DescriptorSet(size_t index) const;
 		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
 
 	private:
 
+		VkPipeline CreatePipeline(const PipelineVariant& variant) const;
+
+		const DeviceProcedures& deviceProcedures_;
 		const SwapChain& swapChain_;
 
 		VULKAN_HANDLE(VkPipeline, pipeline_)
 
+		std::map<PipelineVariant, VkPipeline> variants_;
+
 		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
 		std::unique_ptr<class PipelineLayout> pipelineLayout_;
 
+		std::unique_ptr<ShaderModule> rayGenShader_;
+		std::unique_ptr<ShaderModule> missShader_;
+		std::unique_ptr<ShaderModule> shadowMissShader_;
+		std::unique_ptr<ShaderModule> closestHitShader_;
+		std::unique_ptr<ShaderModule> proceduralClosestHitShader_;
+		std::unique_ptr<ShaderModule> proceduralIntersectionShader_;
+
+		// The specialised closest hit shaders are appended after the six stages above, two per material model.
+		static constexpr uint32_t FirstSpecialisedStage = 6;
+		std::vector<VkRayTracingShaderGroupCreateInfoKHR> groups_;
+
 		uint32_t rayGenIndex_;
 		uint32_t missIndex_;
+		uint32_t shadowMissIndex_;
 		uint32_t triangleHitGroupIndex_;
 		uint32_t proceduralHitGroupIndex_;
 	};
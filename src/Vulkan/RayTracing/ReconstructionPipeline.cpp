@@ -0,0 +1,84 @@
+#include "ReconstructionPipeline.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SwapChain.hpp"
+
+namespace Vulkan::RayTracing {
+
+ReconstructionPipeline::ReconstructionPipeline(const SwapChain& swapChain, const ImageView& accumulationImageView, const ImageView& outputImageView) :
+	swapChain_(swapChain)
+{
+	const auto& device = swapChain.Device();
+
+	// Create descriptor pool/sets.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Accumulation image (sample counts), output image
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	VkDescriptorImageInfo accumulationImageInfo = {};
+	accumulationImageInfo.imageView = accumulationImageView.Handle();
+	accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo outputImageInfo = {};
+	outputImageInfo.imageView = outputImageView.Handle();
+	outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	const std::vector<VkWriteDescriptorSet> descriptorWrites =
+	{
+		descriptorSets.Bind(0, 0, accumulationImageInfo),
+		descriptorSets.Bind(0, 1, outputImageInfo)
+	};
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	// Load shaders.
+	const ShaderModule computeShader(device, "../assets/shaders/Reconstruction.comp.spv");
+
+	// Create compute pipeline
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+		"create reconstruction pipeline");
+}
+
+ReconstructionPipeline::~ReconstructionPipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+}
+
+VkDescriptorSet ReconstructionPipeline::DescriptorSet() const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(0);
+}
+
+}
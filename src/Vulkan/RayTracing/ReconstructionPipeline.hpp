@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class ImageView;
+	class PipelineLayout;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Compute pipeline filling in the output pixels that the interleaved sampling left without any sample, from their
+	// neighbours (see Reconstruction.comp).
+	class ReconstructionPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(ReconstructionPipeline)
+
+		// Must match Reconstruction.comp.
+		static constexpr uint32_t WorkGroupSize = 16;
+
+		struct PushConstants final
+		{
+			uint32_t Width;
+			uint32_t Height;
+		};
+
+		ReconstructionPipeline(const SwapChain& swapChain, const ImageView& accumulationImageView, const ImageView& outputImageView);
+		~ReconstructionPipeline();
+
+		VkDescriptorSet DescriptorSet() const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+	private:
+
+		const SwapChain& swapChain_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+	};
+
+}
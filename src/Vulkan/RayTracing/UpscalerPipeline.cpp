@@ -0,0 +1,100 @@
+#include "UpscalerPipeline.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SwapChain.hpp"
+
+namespace Vulkan::RayTracing {
+
+UpscalerPipeline::UpscalerPipeline(const SwapChain& swapChain, const ImageView& outputImageView) :
+	swapChain_(swapChain)
+{
+	const auto& device = swapChain.Device();
+	const auto& debugUtils = device.DebugUtils();
+	const auto format = swapChain.Format();
+
+	// Full resolution image, copied into the swap-chain image in place of the output image.
+	upscaledImage_.reset(new Image(device, swapChain.Extent(), format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
+	upscaledImageMemory_.reset(new DeviceMemory(upscaledImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	upscaledImageView_.reset(new ImageView(device, upscaledImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	debugUtils.SetObjectName(upscaledImage_->Handle(), "Upscaled Image");
+	debugUtils.SetObjectName(upscaledImageMemory_->Handle(), "Upscaled Image Memory");
+	debugUtils.SetObjectName(upscaledImageView_->Handle(), "Upscaled ImageView");
+
+	// Create descriptor pool/sets.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Output image (input), upscaled image (output)
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	VkDescriptorImageInfo outputImageInfo = {};
+	outputImageInfo.imageView = outputImageView.Handle();
+	outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo upscaledImageInfo = {};
+	upscaledImageInfo.imageView = upscaledImageView_->Handle();
+	upscaledImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	const std::vector<VkWriteDescriptorSet> descriptorWrites =
+	{
+		descriptorSets.Bind(0, 0, outputImageInfo),
+		descriptorSets.Bind(0, 1, upscaledImageInfo)
+	};
+
+	descriptorSets.UpdateDescriptors(descriptorWrites);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	// Load shaders.
+	const ShaderModule computeShader(device, "../assets/shaders/Upscaler.comp.spv");
+
+	// Create compute pipeline
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+	pipelineInfo.layout = pipelineLayout_->Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device.Handle(), nullptr, 1, &pipelineInfo, nullptr, &pipeline_),
+		"create upscaler pipeline");
+}
+
+UpscalerPipeline::~UpscalerPipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(swapChain_.Device().Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+
+	upscaledImageView_.reset();
+	upscaledImage_.reset();
+	upscaledImageMemory_.reset(); // release memory after bound image has been destroyed
+}
+
+VkDescriptorSet UpscalerPipeline::DescriptorSet() const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(0);
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class DescriptorSetManager;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+	class PipelineLayout;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Compute pipeline resampling the rendered area of the output image (the top left corner when the render scale
+	// is below 1) to the full swap-chain resolution with a bicubic Catmull-Rom filter (see Upscaler.comp).
+	class UpscalerPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(UpscalerPipeline)
+
+		// Must match Upscaler.comp.
+		static constexpr uint32_t WorkGroupSize = 16;
+
+		struct PushConstants final
+		{
+			uint32_t SourceWidth;
+			uint32_t SourceHeight;
+		};
+
+		UpscalerPipeline(const SwapChain& swapChain, const ImageView& outputImageView);
+		~UpscalerPipeline();
+
+		VkDescriptorSet DescriptorSet() const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+		const Image& UpscaledImage() const { return *upscaledImage_; }
+
+	private:
+
+		const SwapChain& swapChain_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		std::unique_ptr<Image> upscaledImage_;
+		std::unique_ptr<DeviceMemory> upscaledImageMemory_;
+		std::unique_ptr<ImageView> upscaledImageView_;
+	};
+
+}
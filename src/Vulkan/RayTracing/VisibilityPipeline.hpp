@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <memory>
+#include <vector>
+
+namespace Assets
+{
+	class UniformBuffer;
+}
+
+namespace Vulkan
+{
+	class CommandPool;
+	class DepthBuffer;
+	class DescriptorSetManager;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+	class PipelineLayout;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Graphics pipeline rasterizing the scene raster proxies into a visibility buffer, holding for each pixel the model
+	// index plus one (zero for the background) and the primitive index of the first hit. In hybrid mode, the ray generation
+	// shader starts the paths from these hits instead of tracing the camera rays (see RayTracing.rgen). The geometry is
+	// jittered like the camera rays, so the accumulated frames are still antialiased (see Visibility.vert).
+	class VisibilityPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(VisibilityPipeline)
+
+		static constexpr VkFormat Format = VK_FORMAT_R32G32_UINT;
+
+		VisibilityPipeline(
+			CommandPool& commandPool,
+			const SwapChain& swapChain,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers);
+		~VisibilityPipeline();
+
+		VkDescriptorSet DescriptorSet(size_t index) const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+		VkRenderPass RenderPass() const { return renderPass_; }
+		VkFramebuffer FrameBuffer() const { return frameBuffer_; }
+
+		const ImageView& VisibilityImageView() const { return *visibilityImageView_; }
+
+	private:
+
+		const SwapChain& swapChain_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+
+		VkRenderPass renderPass_{};
+		VkFramebuffer frameBuffer_{};
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		std::unique_ptr<Image> visibilityImage_;
+		std::unique_ptr<DeviceMemory> visibilityImageMemory_;
+		std::unique_ptr<ImageView> visibilityImageView_;
+
+		std::unique_ptr<DepthBuffer> depthBuffer_;
+	};
+
+}
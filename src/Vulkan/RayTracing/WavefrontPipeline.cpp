@@ -0,0 +1,346 @@
+#include "WavefrontPipeline.hpp"
+#include "TopLevelAccelerationStructure.hpp"
+#include "Assets/Scene.hpp"
+#include "Assets/UniformBuffer.hpp"
+#include "Utilities/Exception.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SwapChain.hpp"
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the structures of Wavefront.glsl.
+	constexpr VkDeviceSize PathSize = 96;
+	constexpr VkDeviceSize HitSize = 32;
+	constexpr VkDeviceSize ShadowRaySize = 48;
+
+	// In the order of WavefrontPipeline::Kernel.
+	const char* const KernelShaders[WavefrontPipeline::KernelCount] =
+	{
+		"../assets/shaders/Wavefront.Generate.comp.spv",
+		"../assets/shaders/Wavefront.Dispatch.comp.spv",
+		"../assets/shaders/Wavefront.Extend.comp.spv",
+		"../assets/shaders/Wavefront.Sort.comp.spv",
+		"../assets/shaders/Wavefront.Shade.comp.spv",
+		"../assets/shaders/Wavefront.Connect.comp.spv",
+		"../assets/shaders/Wavefront.Accumulate.comp.spv"
+	};
+}
+
+WavefrontPipeline::WavefrontPipeline(
+	const SwapChain& swapChain,
+	const TopLevelAccelerationStructure& accelerationStructure,
+	const ImageView& accumulationImageView,
+	const ImageView& outputImageView,
+	const ImageView& varianceImageView,
+	const ImageView& albedoImageView,
+	const ImageView& normalDepthImageView,
+	const Buffer& sampleBudgetBuffer,
+	const std::vector<Assets::UniformBuffer>& uniformBuffers,
+	const Assets::Scene& scene) :
+	swapChain_(swapChain)
+{
+	const auto& device = swapChain.Device();
+
+	// One path slot per pixel, the ray queues and the hits are double buffered (see Wavefront.glsl).
+	const VkDeviceSize pixelCount = static_cast<VkDeviceSize>(swapChain.Extent().width) * swapChain.Extent().height;
+
+	pathBuffer_.reset(new Buffer(device, pixelCount * PathSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	pathBufferMemory_.reset(new DeviceMemory(pathBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	queueBuffer_.reset(new Buffer(device, QueuesOffset + 2 * pixelCount * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT));
+	queueBufferMemory_.reset(new DeviceMemory(queueBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	hitBuffer_.reset(new Buffer(device, 2 * pixelCount * HitSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	hitBufferMemory_.reset(new DeviceMemory(hitBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	shadowRayBuffer_.reset(new Buffer(device, pixelCount * ShadowRaySize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	shadowRayBufferMemory_.reset(new DeviceMemory(shadowRayBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	// Create descriptor pool/sets, the bindings 0 to 16 are the same as in RayTracingPipeline.
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Top level acceleration structure.
+		{0, 1, VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Image accumulation & output
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Camera information & co
+		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Vertex buffer, Index buffer, Material buffer, Offset buffer
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Textures and image samplers
+		{8, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// The Procedural buffer.
+		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Lights, light tree and primitive to light index tables.
+		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Adaptive sampling budgets & per-pixel variance accumulation.
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// First hit albedo & normal/depth, guiding the denoiser.
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT},
+
+		// Path states, ray queues, hits and shadow rays.
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{19, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT},
+		{20, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT}
+	};
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	for (uint32_t i = 0; i != uniformBuffers.size(); ++i)
+	{
+		// Top level acceleration structure.
+		const auto accelerationStructureHandle = accelerationStructure.Handle();
+		VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
+		structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+		structureInfo.pNext = nullptr;
+		structureInfo.accelerationStructureCount = 1;
+		structureInfo.pAccelerationStructures = &accelerationStructureHandle;
+
+		// Images
+		VkDescriptorImageInfo accumulationImageInfo = {};
+		accumulationImageInfo.imageView = accumulationImageView.Handle();
+		accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo outputImageInfo = {};
+		outputImageInfo.imageView = outputImageView.Handle();
+		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo varianceImageInfo = {};
+		varianceImageInfo.imageView = varianceImageView.Handle();
+		varianceImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo albedoImageInfo = {};
+		albedoImageInfo.imageView = albedoImageView.Handle();
+		albedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo normalDepthImageInfo = {};
+		normalDepthImageInfo.imageView = normalDepthImageView.Handle();
+		normalDepthImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// Uniform buffer
+		VkDescriptorBufferInfo uniformBufferInfo = {};
+		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
+		uniformBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Scene buffers
+		VkDescriptorBufferInfo vertexBufferInfo = {};
+		vertexBufferInfo.buffer = scene.VertexBuffer().Handle();
+		vertexBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo indexBufferInfo = {};
+		indexBufferInfo.buffer = scene.IndexBuffer().Handle();
+		indexBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo materialBufferInfo = {};
+		materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
+		materialBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo offsetsBufferInfo = {};
+		offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
+		offsetsBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo lightBufferInfo = {};
+		lightBufferInfo.buffer = scene.LightBuffer().Handle();
+		lightBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo lightTreeBufferInfo = {};
+		lightTreeBufferInfo.buffer = scene.LightTreeBuffer().Handle();
+		lightTreeBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo lightIndexBufferInfo = {};
+		lightIndexBufferInfo.buffer = scene.LightIndexBuffer().Handle();
+		lightIndexBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Sample budget buffer
+		VkDescriptorBufferInfo sampleBudgetBufferInfo = {};
+		sampleBudgetBufferInfo.buffer = sampleBudgetBuffer.Handle();
+		sampleBudgetBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Wavefront buffers
+		VkDescriptorBufferInfo pathBufferInfo = {};
+		pathBufferInfo.buffer = pathBuffer_->Handle();
+		pathBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo queueBufferInfo = {};
+		queueBufferInfo.buffer = queueBuffer_->Handle();
+		queueBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo hitBufferInfo = {};
+		hitBufferInfo.buffer = hitBuffer_->Handle();
+		hitBufferInfo.range = VK_WHOLE_SIZE;
+
+		VkDescriptorBufferInfo shadowRayBufferInfo = {};
+		shadowRayBufferInfo.buffer = shadowRayBuffer_->Handle();
+		shadowRayBufferInfo.range = VK_WHOLE_SIZE;
+
+		// Image and texture samplers.
+		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
+
+		for (size_t t = 0; t != imageInfos.size(); ++t)
+		{
+			auto& imageInfo = imageInfos[t];
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfo.imageView = scene.TextureImageViews()[t];
+			imageInfo.sampler = scene.TextureSamplers()[t];
+		}
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites =
+		{
+			descriptorSets.Bind(i, 0, structureInfo),
+			descriptorSets.Bind(i, 1, accumulationImageInfo),
+			descriptorSets.Bind(i, 2, outputImageInfo),
+			descriptorSets.Bind(i, 3, uniformBufferInfo),
+			descriptorSets.Bind(i, 4, vertexBufferInfo),
+			descriptorSets.Bind(i, 5, indexBufferInfo),
+			descriptorSets.Bind(i, 6, materialBufferInfo),
+			descriptorSets.Bind(i, 7, offsetsBufferInfo),
+			descriptorSets.Bind(i, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size())),
+			descriptorSets.Bind(i, 10, lightBufferInfo),
+			descriptorSets.Bind(i, 11, lightTreeBufferInfo),
+			descriptorSets.Bind(i, 12, lightIndexBufferInfo),
+			descriptorSets.Bind(i, 13, sampleBudgetBufferInfo),
+			descriptorSets.Bind(i, 14, varianceImageInfo),
+			descriptorSets.Bind(i, 15, albedoImageInfo),
+			descriptorSets.Bind(i, 16, normalDepthImageInfo),
+			descriptorSets.Bind(i, 17, pathBufferInfo),
+			descriptorSets.Bind(i, 18, queueBufferInfo),
+			descriptorSets.Bind(i, 19, hitBufferInfo),
+			descriptorSets.Bind(i, 20, shadowRayBufferInfo)
+		};
+
+		// Procedural buffer (optional)
+		VkDescriptorBufferInfo proceduralBufferInfo = {};
+
+		if (scene.HasProcedurals())
+		{
+			proceduralBufferInfo.buffer = scene.ProceduralBuffer().Handle();
+			proceduralBufferInfo.range = VK_WHOLE_SIZE;
+
+			descriptorWrites.push_back(descriptorSets.Bind(i, 9, proceduralBufferInfo));
+		}
+
+		descriptorSets.UpdateDescriptors(descriptorWrites);
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	// Load shaders, the kernels are only created once a variant is selected.
+	for (size_t i = 0; i != KernelCount; ++i)
+	{
+		shaders_[i].reset(new ShaderModule(device, KernelShaders[i]));
+	}
+}
+
+WavefrontPipeline::~WavefrontPipeline()
+{
+	for (const auto& variant : variants_)
+	{
+		for (const auto kernel : variant.second)
+		{
+			vkDestroyPipeline(swapChain_.Device().Handle(), kernel, nullptr);
+		}
+	}
+
+	variants_.clear();
+	kernels_ = nullptr;
+
+	for (auto& shader : shaders_)
+	{
+		shader.reset();
+	}
+
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	shadowRayBuffer_.reset();
+	shadowRayBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	hitBuffer_.reset();
+	hitBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	queueBuffer_.reset();
+	queueBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+	pathBuffer_.reset();
+	pathBufferMemory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+void WavefrontPipeline::SetVariant(const PipelineVariant& variant)
+{
+	auto cached = variants_.find(variant);
+
+	if (cached == variants_.end())
+	{
+		cached = variants_.emplace(variant, CreateKernels(variant)).first;
+	}
+
+	kernels_ = &cached->second;
+}
+
+VkDescriptorSet WavefrontPipeline::DescriptorSet(const size_t index) const
+{
+	return descriptorSetManager_->DescriptorSets().Handle(index);
+}
+
+WavefrontPipeline::Kernels WavefrontPipeline::CreateKernels(const PipelineVariant& variant) const
+{
+	// Every kernel gets the feature switches (see PipelineVariant.glsl).
+	const auto variantEntries = PipelineVariant::GetSpecializationMapEntries();
+
+	VkSpecializationInfo variantSpecialisation = {};
+	variantSpecialisation.mapEntryCount = static_cast<uint32_t>(variantEntries.size());
+	variantSpecialisation.pMapEntries = variantEntries.data();
+	variantSpecialisation.dataSize = sizeof(PipelineVariant);
+	variantSpecialisation.pData = &variant;
+
+	std::array<VkComputePipelineCreateInfo, KernelCount> pipelineInfos = {};
+
+	for (size_t i = 0; i != KernelCount; ++i)
+	{
+		auto& pipelineInfo = pipelineInfos[i];
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaders_[i]->CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT);
+		pipelineInfo.stage.pSpecializationInfo = &variantSpecialisation;
+		pipelineInfo.layout = pipelineLayout_->Handle();
+		pipelineInfo.basePipelineHandle = nullptr;
+		pipelineInfo.basePipelineIndex = -1;
+	}
+
+	Kernels kernels = {};
+
+	Check(vkCreateComputePipelines(swapChain_.Device().Handle(), nullptr, static_cast<uint32_t>(pipelineInfos.size()), pipelineInfos.data(), nullptr, kernels.data()),
+		"create wavefront pipelines");
+
+	return kernels;
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include "PipelineVariant.hpp"
+#include <array>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Assets
+{
+	class Scene;
+	class UniformBuffer;
+}
+
+namespace Vulkan
+{
+	class Buffer;
+	class DescriptorSetManager;
+	class DeviceMemory;
+	class ImageView;
+	class PipelineLayout;
+	class ShaderModule;
+	class SwapChain;
+}
+
+namespace Vulkan::RayTracing
+{
+	class TopLevelAccelerationStructure;
+
+	// Compute alternative to the ray tracing pipeline, tracing the paths with ray queries one bounce at a time (see
+	// Wavefront.glsl). Every bounce runs a separate kernel for extension, material sorting, shading and shadow rays, the
+	// paths being passed between them through GPU queues. The Dispatch kernel turns the queue sizes into the indirect
+	// dispatch arguments of the next kernel, so the host never needs to read them back.
+	class WavefrontPipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(WavefrontPipeline)
+
+		enum class Kernel
+		{
+			Generate,
+			Dispatch,
+			Extend,
+			Sort,
+			Shade,
+			Connect,
+			Accumulate
+		};
+
+		static constexpr size_t KernelCount = 7;
+
+		// Queue update performed by the Dispatch kernel, must match Wavefront.glsl.
+		enum class QueueStage : uint32_t
+		{
+			Generate,
+			Extend,
+			Shade,
+			Connect
+		};
+
+		struct PushConstants final
+		{
+			uint32_t Width;
+			uint32_t Height;
+			uint32_t Sample;
+			uint32_t Bounce;
+			QueueStage Stage;
+		};
+
+		static constexpr uint32_t WorkGroupSize = 64;
+		static constexpr uint32_t TileSize = 8;
+
+		// Offsets in the queue buffer of the indirect dispatch arguments, then of the ray queues.
+		static constexpr VkDeviceSize ExtendArgsOffset = 80;
+		static constexpr VkDeviceSize HitArgsOffset = 96;
+		static constexpr VkDeviceSize ShadowArgsOffset = 112;
+		static constexpr VkDeviceSize QueuesOffset = 128;
+
+		WavefrontPipeline(
+			const SwapChain& swapChain,
+			const TopLevelAccelerationStructure& accelerationStructure,
+			const ImageView& accumulationImageView,
+			const ImageView& outputImageView,
+			const ImageView& varianceImageView,
+			const ImageView& albedoImageView,
+			const ImageView& normalDepthImageView,
+			const Buffer& sampleBudgetBuffer,
+			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const Assets::Scene& scene);
+		~WavefrontPipeline();
+
+		// Make Handle() return the kernels compiled for the given feature switches (see RayTracingPipeline::SetVariant()).
+		void SetVariant(const PipelineVariant& variant);
+
+		VkPipeline Handle(Kernel kernel) const { return (*kernels_)[static_cast<size_t>(kernel)]; }
+		VkDescriptorSet DescriptorSet(size_t index) const;
+		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
+
+		const Buffer& QueueBuffer() const { return *queueBuffer_; }
+
+	private:
+
+		using Kernels = std::array<VkPipeline, KernelCount>;
+
+		Kernels CreateKernels(const PipelineVariant& variant) const;
+
+		const SwapChain& swapChain_;
+
+		std::map<PipelineVariant, Kernels> variants_;
+		const Kernels* kernels_{};
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+		std::array<std::unique_ptr<ShaderModule>, KernelCount> shaders_;
+
+		std::unique_ptr<Buffer> pathBuffer_;
+		std::unique_ptr<DeviceMemory> pathBufferMemory_;
+		std::unique_ptr<Buffer> queueBuffer_;
+		std::unique_ptr<DeviceMemory> queueBufferMemory_;
+		std::unique_ptr<Buffer> hitBuffer_;
+		std::unique_ptr<DeviceMemory> hitBufferMemory_;
+		std::unique_ptr<Buffer> shadowRayBuffer_;
+		std::unique_ptr<DeviceMemory> shadowRayBufferMemory_;
+	};
+
+}
@@ -1,6 +1,7 @@
 #include "SwapChain.hpp"
 #include "Device.hpp"
 #include "Enumerate.hpp"
+#include "Image.hpp"
 #include "ImageView.hpp"
 #include "Instance.hpp"
 #include "Surface.hpp"
@@ -11,10 +12,19 @@
 
 namespace Vulkan {
 
-SwapChain::SwapChain(const class Device& device, const VkPresentModeKHR presentMode) :
+SwapChain::SwapChain(const class Device& device, const VkPresentModeKHR presentMode, const VkExtent2D offscreenExtent) :
 	physicalDevice_(device.PhysicalDevice()),
 	device_(device)
 {
+	const auto& window = device.Surface().Instance().Window();
+
+	if (!window.Config().Visible)
+	{
+		presentMode_ = presentMode;
+		CreateOffscreenImages(offscreenExtent);
+		return;
+	}
+
 	const auto details = QuerySwapChainSupport(device.PhysicalDevice(), device.Surface().Handle());
 	if (details.Formats.empty() || details.PresentModes.empty())
 	{
@@ -22,7 +32,6 @@ SwapChain::SwapChain(const class Device& device, const VkPresentModeKHR presentM
 	}
 
 	const auto& surface = device.Surface();
-	const auto& window = surface.Instance().Window();
 
 	const auto surfaceFormat = ChooseSwapSurfaceFormat(details.Formats);
 	const auto actualPresentMode = ChooseSwapPresentMode(details.PresentModes, presentMode);
@@ -86,6 +95,8 @@ SwapChain::SwapChain(const class Device& device, const VkPresentModeKHR presentM
 SwapChain::~SwapChain()
 {
 	imageViews_.clear();
+	offscreenImages_.clear();
+	offscreenImageMemories_.clear(); // release memory after bound image has been destroyed
 
 	if (swapChain_ != nullptr)
 	{
@@ -207,4 +218,20 @@ uint32_t SwapChain::ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilitie
 	return imageCount;
 }
 
+void SwapChain::CreateOffscreenImages(const VkExtent2D extent)
+{
+	// The size is given as is, a hidden window framebuffer may not be scaled like the visible ones.
+	minImageCount_ = 2;
+	format_ = VK_FORMAT_B8G8R8A8_UNORM;
+	extent_ = extent;
+
+	for (uint32_t i = 0; i != minImageCount_; ++i)
+	{
+		offscreenImages_.emplace_back(new Image(device_, extent_, format_, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+		offscreenImageMemories_.emplace_back(new DeviceMemory(offscreenImages_.back()->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+		images_.push_back(offscreenImages_.back()->Handle());
+		imageViews_.push_back(std::make_unique<ImageView>(device_, images_.back(), format_, VK_IMAGE_ASPECT_COLOR_BIT));
+	}
+}
+
 }
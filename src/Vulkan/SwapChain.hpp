@@ -7,6 +7,8 @@
 namespace Vulkan
 {
 	class Device;
+	class DeviceMemory;
+	class Image;
 	class ImageView;
 	class Window;
 
@@ -16,9 +18,13 @@ namespace Vulkan
 
 		VULKAN_NON_COPIABLE(SwapChain)
 
-		SwapChain(const Device& device, VkPresentModeKHR presentMode);
+		// The offscreen extent is the size of the images of a hidden window swap chain.
+		SwapChain(const Device& device, VkPresentModeKHR presentMode, VkExtent2D offscreenExtent);
 		~SwapChain();
 
+		// The swap chain of a hidden window is made of plain images, which are never acquired nor presented.
+		bool IsOffscreen() const { return swapChain_ == nullptr; }
+
 		VkPhysicalDevice PhysicalDevice() const { return physicalDevice_; }
 		const class Device& Device() const { return device_; }
 		uint32_t MinImageCount() const { return minImageCount_; }
@@ -43,6 +49,8 @@ namespace Vulkan
 		static VkExtent2D ChooseSwapExtent(const Window& window, const VkSurfaceCapabilitiesKHR& capabilities);
 		static uint32_t ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities);
 
+		void CreateOffscreenImages(VkExtent2D extent);
+
 		const VkPhysicalDevice physicalDevice_;
 		const class Device& device_;
 
@@ -54,6 +62,8 @@ namespace Vulkan
 		VkExtent2D extent_{};
 		std::vector<VkImage> images_;
 		std::vector<std::unique_ptr<ImageView>> imageViews_;
+		std::vector<std::unique_ptr<Image>> offscreenImages_;
+		std::vector<std::unique_ptr<DeviceMemory>> offscreenImageMemories_;
 	};
 
 }
@@ -7,6 +7,9 @@ namespace Vulkan {
 
 namespace
 {
+	// GLFW is shared by all the windows, the last one to be destroyed terminates it.
+	int windowCount = 0;
+
 	void GlfwErrorCallback(const int error, const char* const description)
 	{
 		std::cerr << "ERROR: GLFW: " << description << " (code: " << error << ")" << std::endl;
@@ -66,6 +69,7 @@ Window::Window(const WindowConfig& config) :
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 	glfwWindowHint(GLFW_RESIZABLE, config.Resizable ? GLFW_TRUE : GLFW_FALSE);
+	glfwWindowHint(GLFW_VISIBLE, config.Visible ? GLFW_TRUE : GLFW_FALSE);
 
 	auto* const monitor = config.Fullscreen ? glfwGetPrimaryMonitor() : nullptr;
 
@@ -75,6 +79,8 @@ Window::Window(const WindowConfig& config) :
 		Throw(std::runtime_error("failed to create window"));
 	}
 
+	windowCount++;
+
 	GLFWimage icon;
 	icon.pixels = stbi_load("../assets/textures/Vulkan.png", &icon.width, &icon.height, nullptr, 4);
 	if (icon.pixels == nullptr)
@@ -103,10 +109,14 @@ Window::~Window()
 	{
 		glfwDestroyWindow(window_);
 		window_ = nullptr;
+		windowCount--;
 	}
 
-	glfwTerminate();
-	glfwSetErrorCallback(nullptr);
+	if (windowCount == 0)
+	{
+		glfwTerminate();
+		glfwSetErrorCallback(nullptr);
+	}
 }
 
 float Window::ContentScale() const
@@ -13,5 +13,6 @@ namespace Vulkan
 		bool CursorDisabled;
 		bool Fullscreen;
 		bool Resizable;
+		bool Visible; // hidden windows are never presented to, their application renders offscreen
 	};
 }
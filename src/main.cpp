@@ -1,12 +1,19 @@
 
 #include "Vulkan/Enumerate.hpp"
+#include "Vulkan/Instance.hpp"
 #include "Vulkan/Strings.hpp"
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Version.hpp"
+#include "Vulkan/Window.hpp"
 #include "Utilities/Console.hpp"
 #include "Utilities/Exception.hpp"
+#include "BatchCameras.hpp"
+#include "JobRunner.hpp"
 #include "Options.hpp"
 #include "RayTracer.hpp"
+#include "RenderJob.hpp"
+#include "TileCoordinator.hpp"
+#include "TileWorker.hpp"
 
 #include <algorithm>
 #include <cstdlib>
@@ -20,7 +27,13 @@ namespace
 	void PrintVulkanLayersInformation(const Vulkan::Application& application, bool benchmark);
 	void PrintVulkanDevices(const Vulkan::Application& application, const std::vector<uint32_t>& visible_devices);
 	void PrintVulkanSwapChainInformation(const Vulkan::Application& application, bool benchmark);
-	void SetVulkanDevice(Vulkan::Application& application, const std::vector<uint32_t>& visible_devices);
+	bool IsSuitableDevice(VkPhysicalDevice device, const std::vector<uint32_t>& visible_devices);
+	uint32_t CountSuitableDevices(const std::vector<uint32_t>& visible_devices);
+	void SetVulkanDevice(Vulkan::Application& application, const std::vector<uint32_t>& visible_devices, uint32_t deviceIndex = 0);
+	void AddPeerDevices(RayTracer& application, const std::vector<uint32_t>& visible_devices);
+	void RunJobQueue(const Options& options, const UserSettings& userSettings);
+	void RunTileCoordinator(const Options& options, const std::string& executable);
+	void RunTileWorker(const Options& options);
 }
 
 int main(int argc, const char* argv[]) noexcept
@@ -29,6 +42,25 @@ int main(int argc, const char* argv[]) noexcept
 	{
 		const Options options(argc, argv);
 		const UserSettings userSettings = CreateUserSettings(options);
+
+		if (!options.JobFile.empty())
+		{
+			RunJobQueue(options, userSettings);
+			return EXIT_SUCCESS;
+		}
+
+		if (options.Distribute)
+		{
+			RunTileCoordinator(options, argv[0]);
+			return EXIT_SUCCESS;
+		}
+
+		if (options.Worker)
+		{
+			RunTileWorker(options);
+			return EXIT_SUCCESS;
+		}
+
 		const Vulkan::WindowConfig windowConfig
 		{
 			"Vulkan Window",
@@ -36,7 +68,8 @@ int main(int argc, const char* argv[]) noexcept
 			options.Height,
 			options.Benchmark && options.Fullscreen,
 			options.Fullscreen,
-			!options.Fullscreen
+			!options.Fullscreen,
+			true
 		};
 
 		RayTracer application(userSettings, windowConfig, static_cast<VkPresentModeKHR>(options.PresentMode));
@@ -46,8 +79,22 @@ int main(int argc, const char* argv[]) noexcept
 		PrintVulkanLayersInformation(application, options.Benchmark);
 		PrintVulkanDevices(application, options.VisibleDevices);
 
+		if (!options.CameraFile.empty())
+		{
+			application.SetBatchViews(BatchCameras::Load(options.CameraFile), options.BatchOutput);
+		}
+
+		application.SetCheckpoint(options.CheckpointFile, options.CheckpointInterval, options.ResumeFile);
+		application.SetExrOutput(options.ExrFile, options.ExrHalf, options.ExrOnCompletion);
+		application.SetAovs(options.AovMask);
+
 		SetVulkanDevice(application, options.VisibleDevices);
 
+		if (options.SplitFrame)
+		{
+			AddPeerDevices(application, options.VisibleDevices);
+		}
+
 		PrintVulkanSwapChainInformation(application, options.Benchmark);
 
 		application.Run();
@@ -95,15 +142,36 @@ namespace
 
 		userSettings.Benchmark = options.Benchmark;
 		userSettings.BenchmarkNextScenes = options.BenchmarkNextScenes;
+		userSettings.BenchmarkCompareEngines = options.BenchmarkCompareEngines;
+		userSettings.BenchmarkCompareSamplers = options.BenchmarkCompareSamplers;
 		userSettings.BenchmarkMaxTime = options.BenchmarkMaxTime;
 		
 		userSettings.SceneIndex = options.SceneIndex;
 
 		userSettings.IsRayTraced = true;
+		userSettings.Engine = options.BenchmarkCompareEngines ? 0 : static_cast<int>(options.Engine);
+		userSettings.HybridPrimary = options.HybridPrimary;
+		userSettings.SplitFrame = options.SplitFrame;
+		userSettings.BatchViews = 0;
+		userSettings.ShownBatchView = 0;
 		userSettings.AccumulateRays = true;
 		userSettings.NumberOfSamples = options.Samples;
 		userSettings.NumberOfBounces = options.Bounces;
 		userSettings.MaxNumberOfSamples = options.MaxSamples;
+		userSettings.NextEventEstimation = options.NextEventEstimation;
+		userSettings.Sampler = options.BenchmarkCompareSamplers ? 0 : static_cast<int>(options.Sampler);
+		userSettings.AdaptiveSampling = options.AdaptiveSampling;
+		userSettings.ErrorTarget = options.ErrorTarget;
+		userSettings.RussianRoulette = options.RussianRoulette;
+		userSettings.RussianRouletteDepth = options.RussianRouletteDepth;
+		userSettings.Denoise = options.Denoise;
+		userSettings.DenoiserIterations = options.DenoiserIterations;
+		userSettings.TemporalReprojection = options.TemporalReprojection;
+		userSettings.MaxHistoryLength = options.MaxHistoryLength;
+		userSettings.InterleaveMode = static_cast<int>(options.InterleaveMode);
+		userSettings.RenderScale = options.RenderScale;
+		userSettings.DynamicResolution = options.DynamicResolution;
+		userSettings.TargetFrameTime = options.TargetFrameTime;
 
 		userSettings.ShowSettings = !options.Benchmark;
 		userSettings.ShowOverlay = true;
@@ -208,50 +276,69 @@ namespace
 		std::cout << std::endl;
 	}
 
-	void SetVulkanDevice(Vulkan::Application& application, const std::vector<uint32_t>& visible_devices)
+	bool IsSuitableDevice(VkPhysicalDevice device, const std::vector<uint32_t>& visible_devices)
 	{
-		const auto& physicalDevices = application.PhysicalDevices();
-		const auto result = std::find_if(physicalDevices.begin(), physicalDevices.end(), [&](const VkPhysicalDevice& device)
+		VkPhysicalDeviceProperties2 prop{};
+		prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		vkGetPhysicalDeviceProperties2(device, &prop);
+
+		// Check whether device has been explicitly filtered out.
+		if (!visible_devices.empty() && std::find(visible_devices.begin(), visible_devices.end(), prop.properties.deviceID) == visible_devices.end())
 		{
-			VkPhysicalDeviceProperties2 prop{};
-			prop.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
-			vkGetPhysicalDeviceProperties2(device, &prop);
+			return false;
+		}
 
-			// Check whether device has been explicitly filtered out.
-			if (!visible_devices.empty() && std::find(visible_devices.begin(), visible_devices.end(), prop.properties.deviceID) == visible_devices.end())
-			{
-				return false;
-			}
+		// We want a device with geometry shader support.
+		VkPhysicalDeviceFeatures deviceFeatures;
+		vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
 
-			// We want a device with geometry shader support.
-			VkPhysicalDeviceFeatures deviceFeatures;
-			vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+		if (!deviceFeatures.geometryShader)
+		{
+			return false;
+		}
 
-			if (!deviceFeatures.geometryShader)
-			{
-				return false;
-			}
+		// We want a device that supports the ray tracing extension.
+		const auto extensions = Vulkan::GetEnumerateVector(device, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
+		const auto hasRayTracing = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+		{
+			return strcmp(extension.extensionName, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) == 0;
+		});
 
-			// We want a device that supports the ray tracing extension.
-			const auto extensions = Vulkan::GetEnumerateVector(device, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
-			const auto hasRayTracing = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
-			{
-				return strcmp(extension.extensionName, VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) == 0;
-			});
+		if (!hasRayTracing)
+		{
+			return false;
+		}
 
-			if (!hasRayTracing)
-			{
-				return false;
-			}
+		// We want a device with a graphics queue.
+		const auto queueFamilies = Vulkan::GetEnumerateVector(device, vkGetPhysicalDeviceQueueFamilyProperties);
+		const auto hasGraphicsQueue = std::any_of(queueFamilies.begin(), queueFamilies.end(), [](const VkQueueFamilyProperties& queueFamily)
+		{
+			return queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+		});
 
-			// We want a device with a graphics queue.
-			const auto queueFamilies = Vulkan::GetEnumerateVector(device, vkGetPhysicalDeviceQueueFamilyProperties);
-			const auto hasGraphicsQueue = std::any_of(queueFamilies.begin(), queueFamilies.end(), [](const VkQueueFamilyProperties& queueFamily)
-			{
-				return queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
-			});
+		return hasGraphicsQueue;
+	}
+
+	uint32_t CountSuitableDevices(const std::vector<uint32_t>& visible_devices)
+	{
+		// The devices are enumerated through an instance of their own, the coordinator does not render.
+		const Vulkan::Window window(Vulkan::WindowConfig{ "Tile Coordinator", 1, 1, false, false, false, false });
+		const Vulkan::Instance instance(window, {}, VK_API_VERSION_1_2);
+
+		return static_cast<uint32_t>(std::count_if(instance.PhysicalDevices().begin(), instance.PhysicalDevices().end(), [&](const VkPhysicalDevice& device)
+		{
+			return IsSuitableDevice(device, visible_devices);
+		}));
+	}
 
-			return hasGraphicsQueue;
+	void SetVulkanDevice(Vulkan::Application& application, const std::vector<uint32_t>& visible_devices, const uint32_t deviceIndex)
+	{
+		// Pick the given suitable device, the first one unless a tile worker has been assigned another one.
+		const auto& physicalDevices = application.PhysicalDevices();
+		uint32_t suitableDevices = 0;
+		const auto result = std::find_if(physicalDevices.begin(), physicalDevices.end(), [&](const VkPhysicalDevice& device)
+		{
+			return IsSuitableDevice(device, visible_devices) && suitableDevices++ == deviceIndex;
 		});
 
 		if (result == physicalDevices.end())
@@ -270,4 +357,94 @@ namespace
 		std::cout << std::endl;
 	}
 
+	void AddPeerDevices(RayTracer& application, const std::vector<uint32_t>& visible_devices)
+	{
+		// The first suitable device presents (see SetVulkanDevice), the other ones render bands of its frames.
+		bool isPresentingDevice = true;
+
+		for (const auto device : application.PhysicalDevices())
+		{
+			if (!IsSuitableDevice(device, visible_devices))
+			{
+				continue;
+			}
+
+			if (isPresentingDevice)
+			{
+				isPresentingDevice = false;
+				continue;
+			}
+
+			VkPhysicalDeviceProperties2 deviceProp{};
+			deviceProp.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			vkGetPhysicalDeviceProperties2(device, &deviceProp);
+
+			std::cout << "Adding Peer Device [" << deviceProp.properties.deviceID << "]:" << std::endl;
+
+			application.AddPeerDevice(device);
+
+			std::cout << std::endl;
+		}
+	}
+
+	void RunJobQueue(const Options& options, const UserSettings& userSettings)
+	{
+		// The fields missing from the jobs are taken from the command line.
+		RenderJob defaults{};
+		defaults.SceneIndex = options.SceneIndex;
+		defaults.Width = options.Width;
+		defaults.Height = options.Height;
+		defaults.Samples = options.MaxSamples;
+		defaults.Bounces = options.Bounces;
+
+		std::cout << "Job Queue:" << std::endl;
+
+		JobRunner runner(userSettings, RenderJob::LoadQueue(options.JobFile, defaults));
+
+		std::cout << std::endl;
+
+		PrintVulkanSdkInformation();
+		PrintVulkanDevices(runner, options.VisibleDevices);
+		SetVulkanDevice(runner, options.VisibleDevices);
+
+		runner.RunJobs();
+	}
+
+	void RunTileCoordinator(const Options& options, const std::string& executable)
+	{
+		TileProtocol::Setup setup{};
+		setup.Magic = TileProtocol::Magic;
+		setup.SceneIndex = options.SceneIndex;
+		setup.Width = options.Width;
+		setup.Height = options.Height;
+		setup.Bounces = options.Bounces;
+		setup.SamplesPerFrame = options.Samples;
+		setup.Sampler = options.Sampler;
+		setup.NextEventEstimation = options.NextEventEstimation;
+		setup.RussianRoulette = options.RussianRoulette;
+		setup.RussianRouletteDepth = options.RussianRouletteDepth;
+
+		TileCoordinator coordinator(setup, options.MaxSamples, options.UnitRows, options.UnitSamples);
+
+		coordinator.Run(executable, options.Workers, options.VisibleDevices, CountSuitableDevices(options.VisibleDevices), static_cast<uint16_t>(options.Port));
+		coordinator.Save(options.DistributedOutput);
+	}
+
+	void RunTileWorker(const Options& options)
+	{
+		auto socket = TileProtocol::Socket::Connect(static_cast<uint16_t>(options.Port));
+		const auto setup = socket.Receive<TileProtocol::Setup>();
+
+		if (setup.Magic != TileProtocol::Magic)
+		{
+			Throw(std::runtime_error("coordinator protocol mismatch"));
+		}
+
+		TileWorker worker(setup);
+
+		SetVulkanDevice(worker, options.VisibleDevices, options.WorkerDevice);
+
+		worker.Run(socket);
+	}
+
 }
@@ -28,6 +28,7 @@ git checkout 2025.06.13
 ./bootstrap-vcpkg.sh
 
 ./vcpkg install \
+	boost-asio:${vcpkg_arch}-linux \
 	boost-exception:${vcpkg_arch}-linux \
 	boost-program-options:${vcpkg_arch}-linux \
 	boost-stacktrace:${vcpkg_arch}-linux \
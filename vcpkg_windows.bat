@@ -6,6 +6,7 @@ git checkout 2025.06.13 || goto :error
 call bootstrap-vcpkg.bat || goto :error
 
 vcpkg.exe install ^
+	boost-asio:x64-windows-static ^
 	boost-exception:x64-windows-static ^
 	boost-program-options:x64-windows-static ^
 	boost-stacktrace:x64-windows-static ^